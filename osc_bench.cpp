@@ -0,0 +1,2736 @@
+// Benchmarks for the OSC trigger engine. Linux only; build with
+//   g++ -O2 -std=c++17 -pthread osc_bench.cpp -o osc_bench
+// and run "./osc_bench" for the list of suites.
+#include "osc_trigger.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <ifaddrs.h>
+#include <net/if.h>
+#include <string>
+#include <sys/resource.h>
+#include <thread>
+#include <new>
+#include <vector>
+
+// Counts every heap allocation in the process so suites can report
+// allocations per message.
+static std::atomic<uint64_t> g_allocations(0);
+
+// noinline keeps GCC from pairing the inlined malloc/free across new/delete
+// and warning about a mismatch that isn't there.
+__attribute__((noinline)) void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept { free(p); }
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept { free(p); }
+
+// Suites measure the engine, not status output: only errors get through.
+static LogRing g_quietLog(64, LogError);
+
+static uint64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void AppendPadded(std::vector<char>& out, const std::string& text) {
+    out.insert(out.end(), text.begin(), text.end());
+    size_t padded = (text.size() + 4) & ~size_t(3);
+    out.resize(out.size() + (padded - text.size()), 0);
+}
+
+static void AppendInt32(std::vector<char>& out, int32_t value) {
+    uint32_t raw = static_cast<uint32_t>(value);
+    out.push_back(static_cast<char>(raw >> 24));
+    out.push_back(static_cast<char>(raw >> 16));
+    out.push_back(static_cast<char>(raw >> 8));
+    out.push_back(static_cast<char>(raw));
+}
+
+static void AppendInt64(std::vector<char>& out, int64_t value) {
+    AppendInt32(out, static_cast<int32_t>(static_cast<uint64_t>(value) >> 32));
+    AppendInt32(out, static_cast<int32_t>(value));
+}
+
+static void AppendFloat(std::vector<char>& out, float value) {
+    int32_t raw;
+    memcpy(&raw, &value, sizeof(raw));
+    AppendInt32(out, raw);
+}
+
+static std::vector<char> BuildIntMessage(const std::string& address, int32_t value) {
+    std::vector<char> msg;
+    AppendPadded(msg, address);
+    AppendPadded(msg, ",i");
+    AppendInt32(msg, value);
+    return msg;
+}
+
+// One argument of every OSC 1.0/1.1 type, plus a two-element array
+static std::vector<char> BuildAllTypesMessage() {
+    std::vector<char> msg;
+    AppendPadded(msg, "/bench/alltypes");
+    AppendPadded(msg, ",ifhdsSbtTFNIcrm[ii]");
+    AppendInt32(msg, 42);
+    AppendFloat(msg, 0.5f);
+    AppendInt64(msg, -1234567890123ll);
+    double d = 2.25;
+    int64_t draw;
+    memcpy(&draw, &d, sizeof(draw));
+    AppendInt64(msg, draw);
+    AppendPadded(msg, "go");
+    AppendPadded(msg, "symbol");
+    AppendInt32(msg, 3);
+    msg.push_back(1); msg.push_back(2); msg.push_back(3); msg.push_back(0);
+    AppendInt64(msg, 1);
+    AppendInt32(msg, 'x');
+    AppendInt32(msg, static_cast<int32_t>(0xff8000ffu));
+    msg.push_back(0); msg.push_back(static_cast<char>(0x90)); msg.push_back(60); msg.push_back(127);
+    AppendInt32(msg, 7);
+    AppendInt32(msg, 8);
+    return msg;
+}
+
+static const char* ArgValue(int argc, char** argv, const char* name, const char* fallback) {
+    for (int i = 2; i + 1 < argc; i++) {
+        if (std::string(argv[i]) == name) return argv[i + 1];
+    }
+    return fallback;
+}
+
+// ---------------------------------------------------------------------------
+// recv: loopback UDP throughput through the real listener
+// ---------------------------------------------------------------------------
+
+struct RecvResult {
+    uint64_t received;
+    double seconds;
+    double listenerCpuSeconds;
+};
+
+static double ThreadCpuSeconds() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static RecvResult MeasureRecv(int port, int batchSize, int packets) {
+    Config config;
+    config.ipAddress = "127.0.0.1";
+    config.port = port;
+    config.continuousMode = true;
+    config.recvBatchSize = batchSize;
+
+    OSCTrigger trigger(g_quietLog, std::make_unique<NullSink>());
+    if (!trigger.Start(config)) {
+        fprintf(stderr, "Failed to bind 127.0.0.1:%d\n", port);
+        exit(1);
+    }
+    double listenerCpu = 0;
+    std::thread listener([&] {
+        double cpuStart = ThreadCpuSeconds();
+        trigger.Listen();
+        listenerCpu = ThreadCpuSeconds() - cpuStart;
+    });
+
+    int sender = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    sockaddr_in dest = {};
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &dest.sin_addr);
+    connect(sender, (sockaddr*)&dest, sizeof(dest));
+
+    // Non-matching traffic keeps the engine cost small, so the numbers are
+    // dominated by the receive path being measured.
+    std::vector<char> msg = BuildIntMessage("/bench/other", 0);
+    const int kSendBatch = 64;
+    std::vector<mmsghdr> headers(kSendBatch);
+    std::vector<iovec> iov(kSendBatch);
+    for (int i = 0; i < kSendBatch; i++) {
+        iov[i].iov_base = msg.data();
+        iov[i].iov_len = msg.size();
+        headers[i].msg_hdr.msg_iov = &iov[i];
+        headers[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    uint64_t start = NowNs();
+    int sent = 0;
+    while (sent < packets) {
+        int n = sendmmsg(sender, headers.data(), (std::min)(kSendBatch, packets - sent), 0);
+        if (n > 0) sent += n;
+    }
+
+    // Wait until the listener has been quiet for 200ms
+    uint64_t lastCount = 0;
+    uint64_t lastChangeNs = NowNs();
+    while (NowNs() - lastChangeNs < 200000000ull) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        uint64_t count = trigger.GetDatagramCount();
+        if (count != lastCount) {
+            lastCount = count;
+            lastChangeNs = NowNs();
+        }
+    }
+
+    trigger.Stop();
+    listener.join();
+    close(sender);
+
+    RecvResult result;
+    result.received = trigger.GetDatagramCount();
+    result.seconds = (lastChangeNs - start) / 1e9;
+    result.listenerCpuSeconds = listenerCpu;
+    return result;
+}
+
+// Pre-fills the socket queue with a burst before the listener thread runs,
+// then drains it. This is the console-burst case: on a loaded box the queue
+// builds up behind the listener, and the cost that matters is how much CPU
+// the listener spends per queued datagram getting it back out.
+static RecvResult MeasureDrain(int port, int batchSize, int burst, int rounds) {
+    Config config;
+    config.ipAddress = "127.0.0.1";
+    config.port = port;
+    config.continuousMode = true;
+    config.recvBatchSize = batchSize;
+
+    OSCTrigger trigger(g_quietLog, std::make_unique<NullSink>());
+    std::vector<char> msg = BuildIntMessage("/bench/other", 0);
+
+    RecvResult result = {0, 0, 0};
+    for (int round = 0; round < rounds; round++) {
+        if (!trigger.Start(config)) {
+            fprintf(stderr, "Failed to bind 127.0.0.1:%d\n", port);
+            exit(1);
+        }
+
+        int sender = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        sockaddr_in dest = {};
+        dest.sin_family = AF_INET;
+        dest.sin_port = htons(port);
+        inet_pton(AF_INET, "127.0.0.1", &dest.sin_addr);
+        for (int i = 0; i < burst; i++) {
+            sendto(sender, msg.data(), msg.size(), 0, (sockaddr*)&dest, sizeof(dest));
+        }
+        close(sender);
+
+        uint64_t before = trigger.GetDatagramCount();
+        double listenerCpu = 0;
+        uint64_t start = NowNs();
+        std::thread listener([&] {
+            double cpuStart = ThreadCpuSeconds();
+            trigger.Listen();
+            listenerCpu = ThreadCpuSeconds() - cpuStart;
+        });
+
+        // Queued datagrams beyond SO_RCVBUF were dropped by the kernel, so stop
+        // once the count has been flat for a moment rather than waiting for all.
+        uint64_t lastCount = before;
+        uint64_t lastChangeNs = NowNs();
+        while (NowNs() - lastChangeNs < 20000000ull) {
+            std::this_thread::yield();
+            uint64_t count = trigger.GetDatagramCount();
+            if (count != lastCount) {
+                lastCount = count;
+                lastChangeNs = NowNs();
+            }
+        }
+
+        trigger.Stop();
+        listener.join();
+
+        result.received += trigger.GetDatagramCount() - before;
+        result.seconds += (lastChangeNs - start) / 1e9;
+        result.listenerCpuSeconds += listenerCpu;
+    }
+    return result;
+}
+
+static int RunRecvBench(int argc, char** argv) {
+    int port = atoi(ArgValue(argc, argv, "--port", "55600"));
+    int packets = atoi(ArgValue(argc, argv, "--packets", "500000"));
+    int batch = atoi(ArgValue(argc, argv, "--batch", "32"));
+    int burst = atoi(ArgValue(argc, argv, "--burst", "256"));
+    int rounds = atoi(ArgValue(argc, argv, "--rounds", "200"));
+    int sizes[] = {1, batch};
+
+    printf("recv/flood: %d datagrams sent over loopback as fast as possible\n", packets);
+    printf("%-10s %12s %12s %14s %16s\n", "batch", "received", "dropped", "packets/sec", "listener ns/pkt");
+    for (int batchSize : sizes) {
+        RecvResult r = MeasureRecv(port, batchSize, packets);
+        printf("%-10d %12llu %12llu %14.0f %16.0f\n", batchSize,
+               (unsigned long long)r.received,
+               (unsigned long long)(packets - r.received),
+               r.received / r.seconds,
+               r.received ? r.listenerCpuSeconds * 1e9 / r.received : 0.0);
+    }
+
+    printf("\nrecv/drain: %d rounds of a %d-datagram burst queued before the listener runs\n", rounds, burst);
+    printf("%-10s %12s %16s %18s\n", "batch", "received", "listener ns/pkt", "drain packets/sec");
+    for (int batchSize : sizes) {
+        RecvResult r = MeasureDrain(port, batchSize, burst, rounds);
+        double nsPerPacket = r.received ? r.listenerCpuSeconds * 1e9 / r.received : 0.0;
+        printf("%-10d %12llu %16.0f %18.0f\n", batchSize,
+               (unsigned long long)r.received, nsPerPacket,
+               nsPerPacket > 0 ? 1e9 / nsPerPacket : 0.0);
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// buffers: SO_RCVBUF sizing and kernel drop accounting
+// ---------------------------------------------------------------------------
+
+struct BufferResult {
+    SocketStats socket;
+    uint64_t received;
+    uint64_t kernelDrops; // From the engine counters, to check against socket.kernelDrops
+    uint64_t overloads;
+};
+
+// Queues a burst before the listener runs, so whatever the buffer can't
+// hold is dropped, then sends one more datagram once it has drained: the
+// kernel reports drops on the datagrams queued after them.
+static BufferResult MeasureBuffer(int port, int bufferBytes, int burst) {
+    Config config;
+    config.ipAddress = "127.0.0.1";
+    config.port = port;
+    config.continuousMode = true;
+    config.oscAddress = "/bench/none";
+    config.recvBufferBytes = bufferBytes;
+
+    OSCTrigger trigger(g_quietLog, std::make_unique<NullSink>());
+    if (!trigger.Start(config)) {
+        fprintf(stderr, "Failed to bind 127.0.0.1:%d\n", port);
+        exit(1);
+    }
+
+    int sender = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    sockaddr_in dest = {};
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &dest.sin_addr);
+    connect(sender, (sockaddr*)&dest, sizeof(dest));
+    std::vector<char> msg = BuildIntMessage("/bench/value", 1);
+    for (int i = 0; i < burst; i++) send(sender, msg.data(), msg.size(), 0);
+
+    std::thread listener([&] { trigger.Listen(); });
+    auto waitForQuiet = [&] {
+        uint64_t seen = ~0ull;
+        while (trigger.GetDatagramCount() != seen) {
+            seen = trigger.GetDatagramCount();
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    };
+    waitForQuiet();
+    send(sender, msg.data(), msg.size(), 0);
+    waitForQuiet();
+    trigger.RequestStop();
+    listener.join();
+    close(sender);
+
+    BufferResult result;
+    result.socket = trigger.GetSocketStats()[0];
+    result.received = trigger.GetDatagramCount();
+    result.kernelDrops = trigger.GetMetrics().Total(CounterKernelDrops);
+    result.overloads = trigger.GetMetrics().Total(CounterOverloads);
+    return result;
+}
+
+static int RunBuffersBench(int argc, char** argv) {
+    int port = atoi(ArgValue(argc, argv, "--port", "57825"));
+    int burst = atoi(ArgValue(argc, argv, "--burst", "20000"));
+    const int sizes[] = {0, 64 * 1024, 256 * 1024, 1024 * 1024, 4 * 1024 * 1024};
+
+    printf("buffers: a %d-datagram burst queued before the listener runs, then one more\n", burst);
+    printf("%-12s %12s %10s %12s %12s %10s\n", "asked", "effective", "received", "kernel drops", "lost", "overloads");
+    bool ok = true;
+    for (int size : sizes) {
+        BufferResult r = MeasureBuffer(port, size, burst);
+        uint64_t lost = burst + 1 - r.received;
+        printf("%-12s %12d %10llu %12llu %12llu %10llu\n", size ? std::to_string(size).c_str() : "default",
+               r.socket.receiveBufferBytes, (unsigned long long)r.received, (unsigned long long)r.socket.kernelDrops,
+               (unsigned long long)lost, (unsigned long long)r.overloads);
+        // Every lost datagram must show up as a kernel drop, once, with one overload event
+        if (r.socket.kernelDrops != lost || r.kernelDrops != lost || r.overloads != (lost ? 1u : 0u)) {
+            printf("  FAIL: drops not accounted for\n");
+            ok = false;
+        }
+    }
+    return ok ? 0 : 1;
+}
+
+// ---------------------------------------------------------------------------
+// shards: SO_REUSEPORT receive scaling
+// ---------------------------------------------------------------------------
+
+struct ShardResult {
+    uint64_t received;
+    double seconds;
+    std::vector<uint64_t> perShard;
+};
+
+// Floods the port from several sockets at once. The kernel picks a shard by
+// source address hash, so each sender needs its own socket to spread.
+static ShardResult MeasureShards(int port, int shardCount, int senders, int packets) {
+    Config config;
+    config.ipAddress = "127.0.0.1";
+    config.port = port;
+    config.continuousMode = true;
+    config.recvShards = shardCount;
+
+    OSCTrigger trigger(g_quietLog, std::make_unique<NullSink>());
+    if (!trigger.Start(config)) {
+        fprintf(stderr, "Failed to bind 127.0.0.1:%d\n", port);
+        exit(1);
+    }
+    std::thread listener([&] { trigger.Listen(); });
+
+    std::vector<char> msg = BuildIntMessage("/bench/other", 0);
+    uint64_t start = NowNs();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < senders; t++) {
+        threads.emplace_back([&, t] {
+            int sender = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+            sockaddr_in dest = {};
+            dest.sin_family = AF_INET;
+            dest.sin_port = htons(port);
+            inet_pton(AF_INET, "127.0.0.1", &dest.sin_addr);
+            connect(sender, (sockaddr*)&dest, sizeof(dest));
+
+            const int kSendBatch = 64;
+            std::vector<mmsghdr> headers(kSendBatch);
+            std::vector<iovec> iov(kSendBatch);
+            for (int i = 0; i < kSendBatch; i++) {
+                iov[i].iov_base = msg.data();
+                iov[i].iov_len = msg.size();
+                headers[i].msg_hdr.msg_iov = &iov[i];
+                headers[i].msg_hdr.msg_iovlen = 1;
+            }
+            int quota = packets / senders + (t < packets % senders ? 1 : 0);
+            int sent = 0;
+            while (sent < quota) {
+                int n = sendmmsg(sender, headers.data(), (std::min)(kSendBatch, quota - sent), 0);
+                if (n > 0) sent += n;
+            }
+            close(sender);
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    uint64_t lastCount = 0;
+    uint64_t lastChangeNs = NowNs();
+    while (NowNs() - lastChangeNs < 200000000ull) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        uint64_t count = trigger.GetDatagramCount();
+        if (count != lastCount) {
+            lastCount = count;
+            lastChangeNs = NowNs();
+        }
+    }
+
+    trigger.Stop();
+    listener.join();
+
+    ShardResult result;
+    result.received = trigger.GetDatagramCount();
+    result.seconds = (lastChangeNs - start) / 1e9;
+    result.perShard = trigger.GetShardDatagramCounts();
+    return result;
+}
+
+static int RunShardsBench(int argc, char** argv) {
+    int port = atoi(ArgValue(argc, argv, "--port", "57425"));
+    int packets = atoi(ArgValue(argc, argv, "--packets", "2000000"));
+    int senders = atoi(ArgValue(argc, argv, "--senders", "8"));
+    int maxShards = atoi(ArgValue(argc, argv, "--max-shards", "4"));
+
+    printf("shards: %d packets from %d sender sockets over loopback, %u CPUs online\n", packets, senders,
+           std::thread::hardware_concurrency());
+    printf("%-8s %12s %14s %10s %8s  %s\n", "shards", "received", "packets/sec", "scaling", "drops", "per shard");
+
+    double baseline = 0;
+    for (int shards = 1; shards <= maxShards; shards *= 2) {
+        ShardResult r = MeasureShards(port, shards, senders, packets);
+        double rate = r.received / r.seconds;
+        if (shards == 1) baseline = rate;
+
+        std::string split;
+        for (uint64_t count : r.perShard) split += std::to_string(count) + " ";
+        printf("%-8d %12llu %14.0f %9.2fx %7.1f%%  %s\n", shards, (unsigned long long)r.received, rate, rate / baseline,
+               100.0 * (packets - (double)r.received) / packets, split.c_str());
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// multicast: group joins, IPv6 and dual-stack binding on one machine
+// ---------------------------------------------------------------------------
+
+// First interface that is up, multicast-capable and has an IPv6 address.
+// Loopback has no IFF_MULTICAST, so IPv6 groups need a real interface; the
+// kernel still loops our own sends back to it.
+static std::string FindIPv6MulticastInterface() {
+    ifaddrs* list = nullptr;
+    if (getifaddrs(&list) != 0) return "";
+    std::string name;
+    for (ifaddrs* a = list; a && name.empty(); a = a->ifa_next) {
+        if (a->ifa_addr && a->ifa_addr->sa_family == AF_INET6 && (a->ifa_flags & IFF_UP) &&
+            (a->ifa_flags & IFF_MULTICAST) && !(a->ifa_flags & IFF_LOOPBACK)) {
+            name = a->ifa_name;
+        }
+    }
+    freeifaddrs(list);
+    return name;
+}
+
+// Sends count copies of msg to an IP:PORT[@IF] spec, pausing every 64 so
+// the receive queue never overflows. Returns the number sent.
+static int SendToEndpoint(const std::string& spec, const std::vector<char>& msg, int count) {
+    Endpoint endpoint;
+    EndpointAddress address;
+    MulticastInterface iface;
+    std::string error;
+    if (!ParseEndpoint(spec, endpoint, error) || !ResolveEndpointAddress(endpoint, address, error) ||
+        !ResolveMulticastInterface(endpoint.interfaceName, address.family, iface, error)) {
+        printf("  %s: %s\n", spec.c_str(), error.c_str());
+        return 0;
+    }
+    int sender = socket(address.family, SOCK_DGRAM, IPPROTO_UDP);
+    if (address.multicast) SetMulticastSendInterface(sender, address.family, iface);
+    int sent = 0;
+    for (int i = 0; i < count; i++) {
+        if (sendto(sender, msg.data(), msg.size(), 0, (sockaddr*)&address.destination, address.bindLength) > 0) sent++;
+        if (i % 64 == 63) std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+    close(sender);
+    return sent;
+}
+
+struct MulticastTarget {
+    std::string spec;  // Where to send
+    int triggerKey;    // The rule key these datagrams should fire
+};
+
+// Starts a listener for config, sends messages to every target and checks
+// each rule key fired exactly once per datagram sent to it.
+static bool RunMulticastCase(const char* name, const Config& config, const std::vector<MulticastTarget>& targets, int messages) {
+    auto recorder = std::make_unique<RecordingSink>();
+    RecordingSink* sink = recorder.get();
+    OSCTrigger trigger(g_quietLog, std::move(recorder));
+    if (!trigger.Start(config)) {
+        printf("%-34s bind or join failed\n", name);
+        return false;
+    }
+    std::thread listener([&] { trigger.Listen(); });
+
+    std::vector<char> msg = BuildIntMessage("/mc/go", 1);
+    size_t expected = 0;
+    for (const MulticastTarget& target : targets) expected += SendToEndpoint(target.spec, msg, messages);
+
+    uint64_t deadline = NowNs() + 2000000000ull;
+    while (sink->Count() < expected && NowNs() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20)); // Catch any extra deliveries
+    trigger.RequestStop();
+    listener.join();
+
+    std::vector<RecordingSink::Record> records = sink->Records();
+    bool ok = expected == static_cast<size_t>(messages) * targets.size() && records.size() == expected;
+    for (const MulticastTarget& target : targets) {
+        size_t fired = std::count_if(records.begin(), records.end(),
+                                     [&](const RecordingSink::Record& r) { return r.triggerKey == target.triggerKey; });
+        ok = ok && fired == static_cast<size_t>(messages);
+    }
+    printf("%-34s %8zu %8zu %8llu  %s\n", name, expected, records.size(),
+           (unsigned long long)trigger.GetDatagramCount(), ok ? "ok" : "FAIL");
+    return ok;
+}
+
+static TriggerRule MulticastRule(const char* key, const char* endpoint) {
+    TriggerRule rule;
+    std::string error;
+    ParseRule(std::string("/mc/go 1 ") + key + (endpoint ? std::string(" endpoint=") + endpoint : ""), rule, error);
+    return rule;
+}
+
+static int RunMulticastBench(int argc, char** argv) {
+    int port = atoi(ArgValue(argc, argv, "--port", "57525"));
+    int messages = atoi(ArgValue(argc, argv, "--messages", "1000"));
+    std::string if6 = ArgValue(argc, argv, "--if6", "");
+    if (if6.empty()) if6 = FindIPv6MulticastInterface();
+
+    printf("multicast: %d datagrams per target, each must fire its endpoint's rule exactly once\n", messages);
+    printf("%-34s %8s %8s %8s  %s\n", "case", "sent", "fired", "received", "result");
+    bool ok = true;
+
+    // Two groups on one port, joined on loopback: each socket sees only its group
+    Config groups;
+    groups.ipAddress = "239.255.77.1";
+    groups.port = port;
+    groups.multicastInterface = "127.0.0.1";
+    groups.continuousMode = true;
+    groups.oscAddress.clear();
+    Endpoint second;
+    std::string error;
+    ParseEndpoint("b=239.255.77.2:" + std::to_string(port) + "@127.0.0.1", second, error);
+    groups.extraEndpoints.push_back(second);
+    groups.rules = {MulticastRule("F1", "main"), MulticastRule("F2", "b")};
+    ok &= RunMulticastCase("IPv4 groups on loopback", groups,
+                           {{"239.255.77.1:" + std::to_string(port) + "@127.0.0.1", VK_F1},
+                            {"239.255.77.2:" + std::to_string(port) + "@127.0.0.1", VK_F2}}, messages);
+
+    if (if6.empty()) {
+        printf("%-34s skipped: no multicast-capable IPv6 interface\n", "IPv6 group");
+    } else {
+        Config group6 = groups;
+        group6.ipAddress = "ff15::7731";
+        group6.port = port + 1;
+        group6.multicastInterface = if6;
+        group6.extraEndpoints.clear();
+        group6.rules = {MulticastRule("F1", nullptr)};
+        std::string name = "IPv6 group on " + if6;
+        ok &= RunMulticastCase(name.c_str(), group6, {{"[ff15::7731]:" + std::to_string(port + 1) + "@" + if6, VK_F1}}, messages);
+    }
+
+    // One :: socket takes both families
+    Config dual = groups;
+    dual.ipAddress = "::";
+    dual.port = port + 2;
+    dual.multicastInterface.clear();
+    dual.extraEndpoints.clear();
+    dual.rules = {MulticastRule("F1", nullptr)};
+    ok &= RunMulticastCase("dual-stack :: via 127.0.0.1", dual, {{"127.0.0.1:" + std::to_string(port + 2), VK_F1}}, messages);
+    ok &= RunMulticastCase("dual-stack :: via ::1", dual, {{"[::1]:" + std::to_string(port + 2), VK_F1}}, messages);
+    return ok ? 0 : 1;
+}
+
+// ---------------------------------------------------------------------------
+// decode: zero-copy decoder over every argument type
+// ---------------------------------------------------------------------------
+
+static bool CheckAllTypes(const std::vector<char>& msg) {
+    OSCMessageView view;
+    if (!view.Parse(msg.data(), static_cast<int>(msg.size()))) return false;
+
+    OSCArgument a;
+    OSCMessageView::Iterator it = view.Arguments();
+    bool ok = true;
+    ok &= it.Next(a) && a.type == 'i' && a.intValue == 42;
+    ok &= it.Next(a) && a.type == 'f' && a.floatValue == 0.5f;
+    ok &= it.Next(a) && a.type == 'h' && a.longValue == -1234567890123ll;
+    ok &= it.Next(a) && a.type == 'd' && a.doubleValue == 2.25;
+    ok &= it.Next(a) && a.type == 's' && a.stringValue == "go";
+    ok &= it.Next(a) && a.type == 'S' && a.stringValue == "symbol";
+    ok &= it.Next(a) && a.type == 'b' && a.blobSize == 3 && a.blobData[2] == 3;
+    ok &= it.Next(a) && a.type == 't' && a.timetag == 1;
+    ok &= it.Next(a) && a.type == 'T' && a.boolValue;
+    ok &= it.Next(a) && a.type == 'F' && !a.boolValue;
+    ok &= it.Next(a) && a.type == 'N';
+    ok &= it.Next(a) && a.type == 'I';
+    ok &= it.Next(a) && a.type == 'c' && a.intValue == 'x';
+    ok &= it.Next(a) && a.type == 'r' && a.rgba == 0xff8000ffu;
+    ok &= it.Next(a) && a.type == 'm' && a.midi[1] == 0x90 && a.midi[3] == 127;
+    ok &= it.Next(a) && a.type == 'i' && a.intValue == 7 && a.arrayDepth == 1 && a.index == 15;
+    ok &= it.Next(a) && a.type == 'i' && a.intValue == 8 && a.arrayDepth == 1;
+    ok &= !it.Next(a);
+
+    // Every truncation of a valid message must decode cleanly or stop early
+    for (size_t cut = 0; cut < msg.size(); cut++) {
+        OSCMessageView partial;
+        if (!partial.Parse(msg.data(), static_cast<int>(cut))) continue;
+        OSCMessageView::Iterator pit = partial.Arguments();
+        int count = 0;
+        while (pit.Next(a)) count++;
+        ok &= count < 17;
+    }
+    return ok;
+}
+
+static int RunDecodeBench(int argc, char** argv) {
+    int iterations = atoi(ArgValue(argc, argv, "--iterations", "2000000"));
+    std::vector<char> msg = BuildAllTypesMessage();
+
+    if (!CheckAllTypes(msg)) {
+        fprintf(stderr, "decode: all-types message decoded incorrectly\n");
+        return 1;
+    }
+
+    OSCMessageView view;
+    OSCArgument arg;
+    uint64_t checksum = 0;
+    uint64_t allocsBefore = g_allocations.load();
+    uint64_t start = NowNs();
+    for (int i = 0; i < iterations; i++) {
+        view.Parse(msg.data(), static_cast<int>(msg.size()));
+        OSCMessageView::Iterator it = view.Arguments();
+        while (it.Next(arg)) checksum += static_cast<uint8_t>(arg.type);
+    }
+    uint64_t elapsed = NowNs() - start;
+    uint64_t allocs = g_allocations.load() - allocsBefore;
+
+    printf("decode: %d x %zu-byte message, 17 arguments of every type (checksum %llu)\n",
+           iterations, msg.size(), (unsigned long long)checksum);
+    printf("  %-26s %8.1f ns/message %12.0f messages/sec %8.3f allocations/message\n", "iterate all arguments",
+           (double)elapsed / iterations, iterations * 1e9 / elapsed, (double)allocs / iterations);
+
+    // The engine's non-triggering path: right address but wrong value, and
+    // an address that doesn't match at all
+    Config config;
+    config.continuousMode = true;
+    OSCEngine engine(g_quietLog, [](const TriggerRule&, uint64_t, uint64_t) {});
+    engine.Reset(config);
+    std::vector<char> wrongValue = BuildIntMessage(config.oscAddress, config.targetValue + 1);
+    std::vector<char> wrongAddress = BuildIntMessage("/other/address", config.targetValue);
+    const std::vector<char>* corpora[] = {&wrongValue, &wrongAddress};
+    const char* names[] = {"engine, value mismatch", "engine, address mismatch"};
+
+    for (int c = 0; c < 2; c++) {
+        const std::vector<char>& m = *corpora[c];
+        uint64_t engineAllocsBefore = g_allocations.load();
+        uint64_t engineStart = NowNs();
+        for (int i = 0; i < iterations; i++) {
+            engine.ProcessOSCData(m.data(), static_cast<int>(m.size()));
+        }
+        uint64_t engineElapsed = NowNs() - engineStart;
+        uint64_t engineAllocs = g_allocations.load() - engineAllocsBefore;
+        allocs += engineAllocs;
+        printf("  %-26s %8.1f ns/message %12.0f messages/sec %8.3f allocations/message\n", names[c],
+               (double)engineElapsed / iterations, iterations * 1e9 / engineElapsed,
+               (double)engineAllocs / iterations);
+    }
+    return allocs == 0 ? 0 : 1;
+}
+
+// ---------------------------------------------------------------------------
+// rules: dispatch cost as the rule table grows
+// ---------------------------------------------------------------------------
+
+static int RunRulesBench(int argc, char** argv) {
+    int iterations = atoi(ArgValue(argc, argv, "--iterations", "2000000"));
+    int ruleCounts[] = {1, 10, 100, 1000, 10000};
+
+    printf("rules: %d messages per table size, half to loaded addresses (value mismatch), half unknown\n", iterations);
+    printf("%-10s %14s %16s %14s\n", "rules", "ns/message", "messages/sec", "allocs/msg");
+
+    for (int ruleCount : ruleCounts) {
+        Config config;
+        config.oscAddress.clear();
+        config.continuousMode = true;
+        for (int i = 0; i < ruleCount; i++) {
+            TriggerRule rule;
+            rule.address = "/cue/" + std::to_string(i) + "/go";
+            rule.targetValue = 1;
+            config.rules.push_back(rule);
+        }
+
+        OSCEngine engine(g_quietLog, [](const TriggerRule&, uint64_t, uint64_t) {});
+        engine.Reset(config);
+
+        std::vector<std::vector<char>> corpus;
+        for (int i = 0; i < 256; i++) {
+            int cue = (i * 7919) % ruleCount;
+            corpus.push_back(BuildIntMessage(i % 2 ? "/cue/" + std::to_string(cue) + "/go"
+                                                   : "/unknown/" + std::to_string(i), 0));
+        }
+
+        uint64_t allocsBefore = g_allocations.load();
+        uint64_t start = NowNs();
+        for (int i = 0; i < iterations; i++) {
+            const std::vector<char>& m = corpus[i & 255];
+            engine.ProcessOSCData(m.data(), static_cast<int>(m.size()));
+        }
+        uint64_t elapsed = NowNs() - start;
+        uint64_t allocs = g_allocations.load() - allocsBefore;
+
+        printf("%-10d %14.1f %16.0f %14.3f\n", ruleCount, (double)elapsed / iterations,
+               iterations * 1e9 / elapsed, (double)allocs / iterations);
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// parse: engine entry points over synthetic corpora
+// ---------------------------------------------------------------------------
+
+static std::vector<char> BuildFloatMessage(const std::string& address, float value) {
+    std::vector<char> msg;
+    AppendPadded(msg, address);
+    AppendPadded(msg, ",f");
+    AppendFloat(msg, value);
+    return msg;
+}
+
+static std::vector<char> BuildBundle(const std::vector<std::vector<char>>& messages, uint64_t timetag = kTimetagImmediate) {
+    std::vector<char> bundle;
+    AppendPadded(bundle, "#bundle");
+    AppendInt64(bundle, static_cast<int64_t>(timetag));
+    for (const std::vector<char>& m : messages) {
+        AppendInt32(bundle, static_cast<int32_t>(m.size()));
+        bundle.insert(bundle.end(), m.begin(), m.end());
+    }
+    return bundle;
+}
+
+// A corpus is a set of datagrams cycled through; messagesPer counts the OSC
+// messages in each one, so bundles report per contained message.
+struct ParseCorpus {
+    const char* name;
+    std::vector<std::vector<char>> datagrams;
+    int messagesPer;
+    bool isBundle;
+};
+
+static std::vector<ParseCorpus> BuildParseCorpora(int bundleSize, int argCount) {
+    std::vector<ParseCorpus> corpora;
+
+    ParseCorpus single = {"single message", {BuildIntMessage("/flair/runstate", 0)}, 1, false};
+    corpora.push_back(single);
+
+    ParseCorpus bundle = {"bundle", {}, bundleSize, true};
+    std::vector<std::vector<char>> contents;
+    for (int i = 0; i < bundleSize; i++) {
+        contents.push_back(BuildIntMessage("/mix/" + std::to_string(i % 16) + "/fader", i));
+    }
+    bundle.datagrams.push_back(BuildBundle(contents));
+    corpora.push_back(bundle);
+
+    // Rule compares the last argument, so every message walks all of them
+    ParseCorpus manyArgs = {"many arguments", {}, 1, false};
+    std::vector<char> wide;
+    AppendPadded(wide, "/wide");
+    std::string tags = ",";
+    for (int i = 0; i < argCount; i++) tags += i % 2 ? 'f' : 'i';
+    AppendPadded(wide, tags);
+    for (int i = 0; i < argCount; i++) {
+        if (i % 2) AppendFloat(wide, i * 0.5f);
+        else AppendInt32(wide, i);
+    }
+    manyArgs.datagrams.push_back(wide);
+    corpora.push_back(manyArgs);
+
+    ParseCorpus nonMatching = {"non-matching", {}, 1, false};
+    for (int i = 0; i < 256; i++) {
+        nonMatching.datagrams.push_back(BuildIntMessage("/unknown/" + std::to_string(i) + "/value", i));
+    }
+    corpora.push_back(nonMatching);
+
+    ParseCorpus mixed = {"mixed int/float", {}, 1, false};
+    for (int i = 0; i < 256; i++) {
+        std::string address = "/mix/" + std::to_string(i % 16) + "/fader";
+        mixed.datagrams.push_back(i % 2 ? BuildFloatMessage(address, i * 0.25f) : BuildIntMessage(address, i));
+    }
+    corpora.push_back(mixed);
+
+    return corpora;
+}
+
+static int RunParseBench(int argc, char** argv) {
+    int iterations = atoi(ArgValue(argc, argv, "--iterations", "1000000"));
+    int bundleSize = atoi(ArgValue(argc, argv, "--bundle", "64"));
+    int argCount = atoi(ArgValue(argc, argv, "--args", "64"));
+
+    // Rules on every address the corpora use, with values that never match,
+    // so each message is parsed, looked up and compared but never fires
+    Config config;
+    config.continuousMode = true;
+    for (int i = 0; i < 16; i++) {
+        TriggerRule rule;
+        rule.address = "/mix/" + std::to_string(i) + "/fader";
+        rule.targetValue = -1;
+        config.rules.push_back(rule);
+    }
+    TriggerRule wideRule;
+    wideRule.address = "/wide";
+    wideRule.argIndex = argCount - 1;
+    wideRule.targetValue = -1;
+    config.rules.push_back(wideRule);
+
+    OSCEngine engine(g_quietLog, [](const TriggerRule&, uint64_t, uint64_t) {
+        fprintf(stderr, "parse: unexpected trigger\n");
+    });
+    engine.Reset(config);
+
+    std::vector<ParseCorpus> corpora = BuildParseCorpora(bundleSize, argCount);
+
+    printf("parse: %d datagrams per row, %d-message bundles, %d-argument messages\n",
+           iterations, bundleSize, argCount);
+    printf("%-18s %-16s %14s %16s %14s\n", "corpus", "entry point", "ns/message", "messages/sec", "allocs/msg");
+
+    uint64_t totalAllocs = 0;
+    for (const ParseCorpus& corpus : corpora) {
+        // Every corpus goes through ProcessOSCData(), then through the
+        // entry point it would reach after the bundle check
+        for (int entry = 0; entry < 2; entry++) {
+            const char* entryName = entry == 0 ? "ProcessOSCData" : corpus.isBundle ? "ProcessBundle" : "ProcessMessage";
+            size_t mask = corpus.datagrams.size() - 1; // Sizes are 1 or 256
+
+            uint64_t allocsBefore = g_allocations.load();
+            uint64_t start = NowNs();
+            for (int i = 0; i < iterations; i++) {
+                const std::vector<char>& d = corpus.datagrams[i & mask];
+                int length = static_cast<int>(d.size());
+                if (entry == 0) engine.ProcessOSCData(d.data(), length);
+                else if (corpus.isBundle) engine.ProcessBundle(d.data(), length);
+                else engine.ProcessMessage(d.data(), length);
+            }
+            uint64_t elapsed = NowNs() - start;
+            uint64_t allocs = g_allocations.load() - allocsBefore;
+            totalAllocs += allocs;
+
+            double messages = (double)iterations * corpus.messagesPer;
+            printf("%-18s %-16s %14.1f %16.0f %14.3f\n", corpus.name, entryName, elapsed / messages,
+                   messages * 1e9 / elapsed, allocs / messages);
+        }
+    }
+
+    if (totalAllocs != 0) {
+        fprintf(stderr, "parse: %llu allocation(s) on the non-triggering path\n", (unsigned long long)totalAllocs);
+        return 1;
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// vector: byte-swap kernels and any/all/channel predicates on wide messages
+// ---------------------------------------------------------------------------
+
+static std::vector<char> BuildFloatBank(const std::string& address, const std::vector<float>& values) {
+    std::vector<char> msg;
+    AppendPadded(msg, address);
+    AppendPadded(msg, "," + std::string(values.size(), 'f'));
+    for (float value : values) AppendFloat(msg, value);
+    return msg;
+}
+
+static bool CheckVectorDecode() {
+    bool ok = true;
+    auto expect = [&](bool condition, const char* what) {
+        if (!condition) {
+            printf("  FAIL: %s\n", what);
+            ok = false;
+        }
+    };
+
+    // Every count and source alignment against the scalar kernel
+    std::vector<char> bytes(4 * 80 + 3);
+    for (size_t i = 0; i < bytes.size(); i++) bytes[i] = static_cast<char>(i * 37 + 11);
+    bool same = true;
+    for (int offset = 0; offset < 4; offset++) {
+        for (int count = 0; count <= 77; count++) {
+            std::vector<uint32_t> vector(count + 1, 0xdeadbeef), scalar(count + 1, 0xdeadbeef);
+            ByteSwap32Run(bytes.data() + offset, vector.data(), count);
+            ByteSwap32RunScalar(bytes.data() + offset, scalar.data(), count);
+            same = same && vector == scalar;
+        }
+    }
+    expect(same, "vector kernel matches the scalar one at every length and alignment");
+
+    std::vector<char> words;
+    AppendPadded(words, "/words");
+    AppendPadded(words, ",i[ff]");
+    AppendInt32(words, -7);
+    AppendFloat(words, 0.25f);
+    AppendFloat(words, 1.5f);
+    std::vector<char> withString;
+    AppendPadded(withString, "/words");
+    AppendPadded(withString, ",i[ff]s");
+    withString.insert(withString.end(), words.end() - 12, words.end());
+    AppendPadded(withString, "x");
+
+    OSCMessageView view;
+    uint32_t decoded[8];
+    char types[8];
+    view.Parse(words.data(), static_cast<int>(words.size()));
+    float third = 0;
+    bool read = view.ReadWords(decoded, types, 8) == 3;
+    memcpy(&third, &decoded[2], sizeof(third));
+    expect(read && static_cast<int32_t>(decoded[0]) == -7 && types[2] == 'f' && third == 1.5f, "array brackets take no slot");
+    expect(view.ReadWords(decoded, types, 2) == -1, "more arguments than capacity take the slow path");
+    view.Parse(withString.data(), static_cast<int>(withString.size()));
+    expect(view.ReadWords(decoded, types, 8) == -1, "strings send a message down the slow path");
+
+    // Rules fed one message; returns how many fired
+    auto fires = [](const char* spec, const std::vector<std::vector<char>>& stream) {
+        Config config;
+        config.oscAddress.clear();
+        config.continuousMode = true;
+        TriggerRule rule;
+        std::string error;
+        if (!ParseRule(spec, rule, error)) return -1;
+        config.rules.push_back(rule);
+        int count = 0;
+        OSCEngine engine(g_quietLog, [&](const TriggerRule&, uint64_t, uint64_t) { count++; });
+        engine.Reset(config);
+        for (const std::vector<char>& msg : stream) engine.ProcessOSCData(msg.data(), static_cast<int>(msg.size()));
+        return count;
+    };
+
+    std::vector<float> quiet(32, 0.1f);
+    std::vector<float> loud = quiet;
+    loud[17] = 0.95f;
+    std::vector<char> quietBank = BuildFloatBank("/faders", quiet);
+    std::vector<char> loudBank = BuildFloatBank("/faders", loud);
+
+    expect(fires("/faders >0.9 F1 arg=any", {quietBank, loudBank}) == 1, "any > 0.9");
+    expect(fires("/faders <0.5 F1 arg=all", {quietBank, loudBank}) == 1, "all < 0.5");
+    expect(fires("/faders >=0.95 F1 arg=17", {loudBank}) == 1, "channel 17 >= 0.95");
+    expect(fires("/faders 0.1 F1 arg=16", {loudBank}) == 1, "float equality within 0.01");
+    expect(fires("/faders !=0.1 F1 arg=16", {loudBank}) == 0, "!=");
+    expect(fires("/faders 1 F1 arg=40", {loudBank}) == 0, "channel past the last argument never fires");
+    expect(fires("/faders >0.9 F1 arg=any edge hysteresis=0.2", {loudBank, loudBank, quietBank, loudBank}) == 2,
+           "edge on any re-arms once every channel is below the band");
+    std::vector<char> allTypes = BuildAllTypesMessage();
+    OSCMessageView allView;
+    allView.Parse(allTypes.data(), static_cast<int>(allTypes.size()));
+    std::string allAddress(allView.Address());
+    expect(fires((allAddress + " ==-1234567890123 F1 arg=any").c_str(), {allTypes}) == 1, "any walks mixed-type messages");
+    expect(fires((allAddress + " >1 F1 arg=all").c_str(), {allTypes}) == 0, "all fails on the first small argument");
+    return ok;
+}
+
+static int RunVectorBench(int argc, char** argv) {
+    int iterations = atoi(ArgValue(argc, argv, "--iterations", "1000000"));
+
+    printf("vector: decode checks (%s kernel)\n", ByteSwapKernelName());
+    if (!CheckVectorDecode()) return 1;
+    printf("  ok\n");
+
+    printf("vector: byte-swap kernels, %d runs per size\n", iterations);
+    printf("%-10s %16s %16s %10s\n", "words", "scalar words/s", "vector words/s", "speedup");
+    for (int words : {8, 64, 1024}) {
+        std::vector<char> source(words * 4 + 1);
+        for (size_t i = 0; i < source.size(); i++) source[i] = static_cast<char>(i);
+        std::vector<uint32_t> out(words);
+        int runs = (std::max)(1, static_cast<int>(static_cast<int64_t>(iterations) * 64 / words));
+        volatile uint32_t sink = 0; // Keeps the runs from being optimised away
+
+        // Odd source offset: datagram arguments are rarely 16-byte aligned
+        uint64_t start = NowNs();
+        for (int r = 0; r < runs; r++) {
+            ByteSwap32RunScalar(source.data() + 1, out.data(), words);
+            sink = out[r % words];
+        }
+        uint64_t scalarNs = NowNs() - start;
+        start = NowNs();
+        for (int r = 0; r < runs; r++) {
+            ByteSwap32Run(source.data() + 1, out.data(), words);
+            sink = out[r % words];
+        }
+        uint64_t vectorNs = NowNs() - start;
+        (void)sink;
+
+        double total = static_cast<double>(runs) * words;
+        printf("%-10d %16.3g %16.3g %9.2fx\n", words, total * 1e9 / scalarNs, total * 1e9 / vectorNs,
+               (double)scalarNs / vectorNs);
+    }
+
+    // A 64-fader bank against predicates over all its arguments. The last
+    // row is the per-argument walk the engine falls back to for messages
+    // with other types, and the only decode path it had before.
+    std::vector<float> faders(64, 0.2f);
+    std::vector<char> bank = BuildFloatBank("/faders", faders);
+    const struct {
+        const char* name;
+        const char* spec;
+    } cases[] = {
+        {"channel 63", "/faders 1 F1 arg=63"},
+        {"any > 0.9", "/faders >0.9 F1 arg=any"},
+        {"all < 0.9", "/faders <0.1 F1 arg=all"},
+    };
+
+    printf("vector: 64-float message, %d messages per predicate\n", iterations);
+    printf("%-14s %14s %16s %14s\n", "predicate", "ns/message", "messages/sec", "allocs/msg");
+    uint64_t allocs = 0;
+    for (const auto& c : cases) {
+        Config config;
+        config.oscAddress.clear();
+        config.continuousMode = true;
+        TriggerRule rule;
+        std::string error;
+        ParseRule(c.spec, rule, error);
+        config.rules.push_back(rule);
+        OSCEngine engine(g_quietLog, [](const TriggerRule&, uint64_t, uint64_t) {});
+        engine.Reset(config);
+
+        uint64_t allocsBefore = g_allocations.load();
+        uint64_t start = NowNs();
+        for (int i = 0; i < iterations; i++) engine.ProcessOSCData(bank.data(), static_cast<int>(bank.size()));
+        uint64_t elapsed = NowNs() - start;
+        uint64_t caseAllocs = g_allocations.load() - allocsBefore;
+        allocs += caseAllocs;
+        printf("%-14s %14.1f %16.0f %14.3f\n", c.name, (double)elapsed / iterations, iterations * 1e9 / elapsed,
+               (double)caseAllocs / iterations);
+    }
+
+    OSCMessageView view;
+    view.Parse(bank.data(), static_cast<int>(bank.size()));
+    OSCArgument arg;
+    volatile float sink = 0;
+    uint64_t start = NowNs();
+    for (int i = 0; i < iterations; i++) {
+        OSCMessageView::Iterator it = view.Arguments();
+        while (it.Next(arg)) sink = arg.floatValue;
+    }
+    uint64_t walkNs = NowNs() - start;
+    (void)sink;
+    printf("%-14s %14.1f %16.0f %14s\n", "walk, scalar", (double)walkNs / iterations, iterations * 1e9 / walkNs, "-");
+    return allocs == 0 ? 0 : 1;
+}
+
+// ---------------------------------------------------------------------------
+// predicate: compiled ranges, strings, booleans and AND/OR clause lists
+// ---------------------------------------------------------------------------
+
+// "/mix" carrying s, f, i and T or F
+static std::vector<char> BuildMixMessage(const std::string& name, float level, int32_t channel, bool on) {
+    std::vector<char> msg;
+    AppendPadded(msg, "/mix");
+    AppendPadded(msg, std::string(",sfi") + (on ? "T" : "F"));
+    AppendPadded(msg, name);
+    AppendFloat(msg, level);
+    AppendInt32(msg, channel);
+    return msg;
+}
+
+// A rule fed a stream of messages; returns how many times it fired, -1 if
+// the rule doesn't parse
+static int FireCount(const char* spec, const std::vector<std::vector<char>>& stream) {
+    Config config;
+    config.oscAddress.clear();
+    config.continuousMode = true;
+    TriggerRule rule;
+    std::string error;
+    if (!ParseRule(spec, rule, error)) return -1;
+    config.rules.push_back(rule);
+    int count = 0;
+    OSCEngine engine(g_quietLog, [&](const TriggerRule&, uint64_t, uint64_t) { count++; });
+    engine.Reset(config);
+    for (const std::vector<char>& msg : stream) engine.ProcessOSCData(msg.data(), static_cast<int>(msg.size()));
+    return count;
+}
+
+static bool CheckPredicates() {
+    bool ok = true;
+    auto expect = [&](bool condition, const char* what) {
+        if (!condition) {
+            printf("  FAIL: %s\n", what);
+            ok = false;
+        }
+    };
+
+    std::vector<char> mix = BuildMixMessage("go", 0.5f, -3, true);
+    expect(FireCount("/mix -3 F1 arg=2", {mix}) == 1, "negative integer target");
+    expect(FireCount("/mix 0.4..0.6 F1 arg=1", {mix}) == 1, "inside a range");
+    expect(FireCount("/mix 0.6..0.9 F1 arg=1", {mix}) == 0, "below a range");
+    expect(FireCount("/mix !=0.4..0.6 F1 arg=1", {mix}) == 0, "!= range is outside it");
+    expect(FireCount("/mix -5..-3 F1 arg=2", {mix}) == 1, "range bounds are inclusive");
+    expect(FireCount("/mix go F1", {mix}) == 1 && FireCount("/mix 'stop' F1", {mix}) == 0, "string equality");
+    expect(FireCount("/mix !=go F1", {mix}) == 0, "string !=");
+    expect(FireCount("/mix go F1 arg=1", {mix}) == 0, "a string target never matches a float");
+    expect(FireCount("/mix true F1 arg=3", {mix}) == 1 && FireCount("/mix false F1 arg=3", {mix}) == 0, "T against true and false");
+    expect(FireCount("/mix 0.52 F1 arg=1", {mix}) == 0 && FireCount("/mix 0.52 F1 arg=1 tolerance=0.05", {mix}) == 1,
+           "float tolerance");
+    expect(FireCount("/mix \"0:go & 1:>0.4\" F1", {mix}) == 1 && FireCount("/mix \"0:go & 1:>0.6\" F1", {mix}) == 0, "AND");
+    expect(FireCount("/mix \"0:stop | 2:<0\" F1", {mix}) == 1 && FireCount("/mix \"0:stop | 2:>0\" F1", {mix}) == 0, "OR");
+    expect(FireCount("/mix \"0:stop & 1:0.5 | 3:true\" F1", {mix}) == 1, "& binds tighter than |");
+    expect(FireCount("/mix \"0:'a|b' | 3:false\" F1", {mix}) == 0, "quoted strings keep & and |");
+    expect(FireCount("/mix any:go F1", {mix}) == 1, "any over strings");
+    expect(FireCount("/mix all:true F1", {mix}) == 1, "all over booleans");
+    std::vector<char> faders = BuildFloatBank("/faders", std::vector<float>(8, 0.5f));
+    expect(FireCount("/faders any:go F1", {faders}) == 0, "a string clause finds nothing in a float bank");
+    expect(FireCount("/faders \"all:0.4..0.6 & 7:0.5\" F1", {faders}) == 1, "range over all decoded words");
+
+    std::vector<char> quiet = BuildMixMessage("go", 0.1f, -3, true);
+    expect(FireCount("/mix \"0:go & 1:>0.4\" F1 edge", {mix, mix, quiet, mix}) == 2, "a clause list re-arms an edge rule when it fails");
+    auto fader = [](float value) { return BuildFloatBank("/fader", {value}); };
+    expect(FireCount("/fader 0.4..0.6 F1 edge hysteresis=0.1", {fader(0.5f), fader(0.65f), fader(0.5f), fader(0.8f), fader(0.5f)}) == 2,
+           "a range re-arms only past its hysteresis band");
+
+    const char* invalid[] = {"/mix >go F1", "/mix 1..0 F1", "/mix 0:>true F1", "/mix 9x F1", "/mix 'go F1", "/mix \"foo:1\" F1",
+                             "/mix \"0:go &\" F1", "/mix 1 F1 tolerance=-1"};
+    bool rejected = true;
+    for (const char* spec : invalid) rejected = rejected && FireCount(spec, {mix}) == -1;
+    expect(rejected, "malformed conditions are rejected");
+    return ok;
+}
+
+static int RunPredicateBench(int argc, char** argv) {
+    int iterations = atoi(ArgValue(argc, argv, "--iterations", "2000000"));
+
+    printf("predicate: checks\n");
+    if (!CheckPredicates()) return 1;
+    printf("  ok\n");
+
+    // Each case misses, so every clause the evaluator reaches is run
+    std::vector<char> mix = BuildMixMessage("go", 0.5f, -3, true);
+    const struct {
+        const char* name;
+        const char* spec;
+    } cases[] = {
+        {"number", "/mix 9 F1 arg=2"},
+        {"range", "/mix 0.6..0.9 F1 arg=1"},
+        {"string", "/mix 'stop' F1"},
+        {"boolean", "/mix false F1 arg=3"},
+        {"a & b", "/mix \"0:go & 1:>0.6\" F1"},
+        {"a & b | c & d", "/mix \"0:go & 1:>0.6 | 2:<0 & 3:false\" F1"},
+        {"any string", "/mix any:stop F1"},
+    };
+
+    printf("predicate: %d messages per predicate, none matching\n", iterations);
+    printf("%-16s %14s %16s %14s\n", "predicate", "ns/message", "messages/sec", "allocs/msg");
+    uint64_t allocs = 0;
+    for (const auto& c : cases) {
+        Config config;
+        config.oscAddress.clear();
+        config.continuousMode = true;
+        TriggerRule rule;
+        std::string error;
+        ParseRule(c.spec, rule, error);
+        config.rules.push_back(rule);
+        OSCEngine engine(g_quietLog, [](const TriggerRule&, uint64_t, uint64_t) {});
+        engine.Reset(config);
+
+        uint64_t allocsBefore = g_allocations.load();
+        uint64_t start = NowNs();
+        for (int i = 0; i < iterations; i++) engine.ProcessOSCData(mix.data(), static_cast<int>(mix.size()));
+        uint64_t elapsed = NowNs() - start;
+        uint64_t caseAllocs = g_allocations.load() - allocsBefore;
+        allocs += caseAllocs;
+        printf("%-16s %14.1f %16.0f %14.3f\n", c.name, (double)elapsed / iterations, iterations * 1e9 / elapsed,
+               (double)caseAllocs / iterations);
+    }
+    return allocs == 0 ? 0 : 1;
+}
+
+// ---------------------------------------------------------------------------
+// patterns: address-pattern dispatch with and without the match cache
+// ---------------------------------------------------------------------------
+
+static bool CheckPatterns() {
+    bool ok = true;
+    auto expect = [&](bool condition, const char* what) {
+        if (!condition) {
+            printf("  FAIL: %s\n", what);
+            ok = false;
+        }
+    };
+    auto matches = [](const char* pattern, const std::string& address) {
+        CompiledPattern compiled;
+        return compiled.Compile(pattern) && compiled.Matches(address);
+    };
+
+    expect(matches("/a/*/c", "/a/bbb/c") && !matches("/a/*/c", "/a/b/b/c"), "* stays inside a segment");
+    expect(matches("/x/*b*c", "/x/abbbc") && !matches("/x/*b*c", "/x/abcb"), "star backtracking");
+    expect(matches("/x/a**b", "/x/ab") && matches("/x/*", "/x/") && !matches("/x/?", "/x/"), "empty stars");
+    expect(matches("/cue/{go,stop}?", "/cue/stopX") && !matches("/cue/{go,stop}?", "/cue/go"), "alternatives then ?");
+    expect(matches("/m/{a,b}{1,2}[!3]", "/m/b2x") && !matches("/m/{a,b}{1,2}[!3]", "/m/b23"), "stacked alternatives");
+    expect(matches("/m/ch[0-9]*", "/m/ch7fader") && !matches("/m/ch[0-9]*", "/m/chx"), "sets");
+
+    CompiledPattern tooMany;
+    expect(!tooMany.Compile("/{a,b}{a,b}{a,b}{a,b}{a,b}{a,b}{a,b}"), "more than 64 alternatives is rejected");
+
+    // Many stars against a long near-miss segment: backtracking recursion
+    // would never finish, the greedy-star scan is quadratic at worst
+    std::string stars = "/x/";
+    for (int i = 0; i < 12; i++) stars += "*a";
+    stars += "b";
+    std::string segment = "/x/" + std::string(CompiledPattern::kMaxAddressBytes - 3, 'a');
+    uint64_t start = NowNs();
+    expect(!matches(stars.c_str(), segment), "pathological near miss");
+    uint64_t elapsed = NowNs() - start;
+    expect(elapsed < 10000000, "pathological near miss is fast");
+    printf("pathological pattern (12 stars, %zu-byte segment): %.1f us\n", segment.size(), elapsed / 1e3);
+
+    expect(matches("/x/*", "/x/" + std::string(CompiledPattern::kMaxAddressBytes - 3, 'a')), "address at the cap");
+    expect(!matches("/x/*", "/x/" + std::string(CompiledPattern::kMaxAddressBytes, 'a')), "address over the cap");
+
+    // The trie must report exactly what running every pattern would, in
+    // rule order: overlapping literal and wildcard branches, shared
+    // wildcard segments and patterns ending at inner nodes included
+    const char* segments[] = {"a", "b", "ab", "*", "?", "[ab]", "{a,b}", "a*", "*b", "[!a]"};
+    const char* parts[] = {"a", "b", "ab", "ba", "c", ""};
+    std::vector<TriggerRule> rules;
+    uint32_t seed = 12345;
+    auto next = [&](uint32_t range) {
+        seed = seed * 1103515245 + 12345;
+        return (seed >> 16) % range;
+    };
+    for (int i = 0; i < 300; i++) {
+        TriggerRule rule;
+        for (uint32_t s = 0, count = 1 + next(3); s < count; s++) rule.address += std::string("/") + segments[next(10)];
+        rules.push_back(rule);
+    }
+    RuleTable table;
+    table.Build(rules);
+    bool same = true;
+    std::vector<int> matched;
+    for (int i = 0; i < 2000; i++) {
+        std::string address;
+        for (uint32_t s = 0, count = 1 + next(3); s < count; s++) address += std::string("/") + parts[next(6)];
+        std::vector<int> expected;
+        for (size_t r = 0; r < rules.size(); r++) {
+            CompiledPattern pattern;
+            if (IsAddressPattern(rules[r].address) && pattern.Compile(rules[r].address) && pattern.Matches(address)) {
+                expected.push_back(static_cast<int>(r));
+            }
+        }
+        table.MatchPatterns(address, matched);
+        same = same && matched == expected;
+    }
+    expect(same, "the trie matches what every pattern alone does");
+    return ok;
+}
+
+static int RunPatternsBench(int argc, char** argv) {
+    if (!CheckPatterns()) return 1;
+    int iterations = atoi(ArgValue(argc, argv, "--iterations", "1000000"));
+    int patternCount = atoi(ArgValue(argc, argv, "--patterns", "1000"));
+
+    // A mix of the shapes show-control senders use: wildcard segments, channel
+    // ranges and alternative lists, spread over a few hundred namespaces.
+    Config config;
+    config.oscAddress.clear();
+    config.continuousMode = true;
+    for (int i = 0; i < patternCount; i++) {
+        TriggerRule rule;
+        std::string ns = std::to_string(i / 4);
+        switch (i % 4) {
+        case 0: rule.address = "/flair/" + ns + "/*/runstate"; break;
+        case 1: rule.address = "/cue/" + ns + "/{go,stop,pause}"; break;
+        case 2: rule.address = "/mixer/" + ns + "/ch[0-9]/fader"; break;
+        case 3: rule.address = "/light/" + ns + "/dimmer?"; break;
+        }
+        rule.targetValue = 1;
+        config.rules.push_back(rule);
+    }
+
+    // A few senders repeating a small working set, plus chatter nothing matches
+    std::vector<std::vector<char>> corpus;
+    for (int i = 0; i < 256; i++) {
+        std::string ns = std::to_string((i * 7919) % (patternCount / 4 > 0 ? patternCount / 4 : 1));
+        switch (i % 5) {
+        case 0: corpus.push_back(BuildIntMessage("/flair/" + ns + "/axis" + std::to_string(i % 3) + "/runstate", 0)); break;
+        case 1: corpus.push_back(BuildIntMessage("/cue/" + ns + (i % 2 ? "/go" : "/stop"), 0)); break;
+        case 2: corpus.push_back(BuildIntMessage("/mixer/" + ns + "/ch" + std::to_string(i % 10) + "/fader", 0)); break;
+        case 3: corpus.push_back(BuildIntMessage("/light/" + ns + "/dimmer" + std::to_string(i % 8), 0)); break;
+        case 4: corpus.push_back(BuildIntMessage("/meter/" + std::to_string(i) + "/level", 0)); break;
+        }
+    }
+
+    printf("patterns: %d patterns, %d messages over %zu distinct addresses (value mismatch)\n",
+           patternCount, iterations, corpus.size());
+    printf("%-10s %14s %16s %14s %10s\n", "cache", "ns/message", "messages/sec", "allocs/msg", "hit rate");
+
+    int cacheSizes[] = {0, 1024};
+    for (int cacheSize : cacheSizes) {
+        config.patternCacheSize = cacheSize;
+        OSCEngine engine(g_quietLog, [](const TriggerRule&, uint64_t, uint64_t) {});
+        engine.Reset(config);
+
+        // Warm-up pass so the scratch buffers and cache entries are allocated
+        for (const std::vector<char>& m : corpus) {
+            engine.ProcessOSCData(m.data(), static_cast<int>(m.size()));
+        }
+
+        uint64_t hitsBefore = engine.GetPatternCache().Hits();
+        uint64_t missesBefore = engine.GetPatternCache().Misses();
+        uint64_t allocsBefore = g_allocations.load();
+        uint64_t start = NowNs();
+        for (int i = 0; i < iterations; i++) {
+            const std::vector<char>& m = corpus[i & 255];
+            engine.ProcessOSCData(m.data(), static_cast<int>(m.size()));
+        }
+        uint64_t elapsed = NowNs() - start;
+        uint64_t allocs = g_allocations.load() - allocsBefore;
+        uint64_t hits = engine.GetPatternCache().Hits() - hitsBefore;
+        uint64_t lookups = hits + engine.GetPatternCache().Misses() - missesBefore;
+
+        printf("%-10s %14.1f %16.0f %14.3f %9.1f%%\n", cacheSize ? std::to_string(cacheSize).c_str() : "off",
+               (double)elapsed / iterations, iterations * 1e9 / elapsed, (double)allocs / iterations,
+               lookups ? 100.0 * hits / lookups : 0.0);
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// dispatch: receive-to-dispatch latency and listener decoupling from the sink
+// ---------------------------------------------------------------------------
+
+// Stands in for SetForegroundWindow + keybd_event, which can block for
+// hundreds of microseconds.
+class SlowSink : public ActionSink {
+private:
+    int delayUs;
+
+public:
+    explicit SlowSink(int us) : delayUs(us) {}
+    void Fire(const TriggerRule&) override {
+        std::this_thread::sleep_for(std::chrono::microseconds(delayUs));
+    }
+};
+
+static void RunDispatchScenario(const char* name, int port, int messages, int gapUs, int sinkUs) {
+    Config config;
+    config.ipAddress = "127.0.0.1";
+    config.port = port;
+    config.continuousMode = true;
+    config.oscAddress = "/cue/go";
+    config.targetValue = 1;
+
+    OSCTrigger trigger(g_quietLog, std::make_unique<SlowSink>(sinkUs));
+    if (!trigger.Start(config)) {
+        fprintf(stderr, "Failed to bind 127.0.0.1:%d\n", port);
+        exit(1);
+    }
+    std::thread listener([&] { trigger.Listen(); });
+
+    int sender = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    sockaddr_in dest = {};
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &dest.sin_addr);
+    connect(sender, (sockaddr*)&dest, sizeof(dest));
+
+    std::vector<char> msg = BuildIntMessage("/cue/go", 1);
+    uint64_t start = NowNs();
+    for (int i = 0; i < messages; i++) {
+        send(sender, msg.data(), msg.size(), 0);
+        if (gapUs > 0) std::this_thread::sleep_for(std::chrono::microseconds(gapUs));
+    }
+
+    // The listener should have read everything long before the sink finishes
+    uint64_t deadline = NowNs() + 5000000000ull;
+    while (trigger.GetDatagramCount() < static_cast<uint64_t>(messages) && NowNs() < deadline) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    double readMs = (NowNs() - start) / 1e6;
+
+    trigger.RequestStop();
+    listener.join(); // Listen() flushes the queue before returning
+    close(sender);
+
+    DispatchStats stats = trigger.GetDispatchStats();
+    printf("%-8s %8llu %8.1f %10llu %8llu %8zu %12.0f %12.0f\n", name, (unsigned long long)trigger.GetDatagramCount(), readMs,
+           (unsigned long long)stats.dispatched, (unsigned long long)stats.dropped, stats.maxDepth,
+           stats.avgLatencyUs, stats.maxLatencyUs);
+}
+
+static int RunDispatchBench(int argc, char** argv) {
+    int port = atoi(ArgValue(argc, argv, "--port", "57225"));
+    int messages = atoi(ArgValue(argc, argv, "--messages", "500"));
+    int sinkUs = atoi(ArgValue(argc, argv, "--sink-us", "200"));
+
+    printf("dispatch: %d matching messages per scenario, sink takes %d us per action\n", messages, sinkUs);
+    printf("%-8s %8s %8s %10s %8s %8s %12s %12s\n", "", "read", "read ms", "dispatched", "dropped",
+           "max q", "avg lat us", "max lat us");
+    RunDispatchScenario("paced", port, messages, 1000, 0);
+    RunDispatchScenario("burst", port, messages, 0, sinkUs);
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// latency: per-stage receive-to-inject histograms over loopback
+// ---------------------------------------------------------------------------
+
+static int RunLatencyBench(int argc, char** argv) {
+    int port = atoi(ArgValue(argc, argv, "--port", "57325"));
+    int messages = atoi(ArgValue(argc, argv, "--messages", "5000"));
+    int gapUs = atoi(ArgValue(argc, argv, "--gap-us", "200"));
+    int sinkUs = atoi(ArgValue(argc, argv, "--sink-us", "0"));
+
+    Config config;
+    config.ipAddress = "127.0.0.1";
+    config.port = port;
+    config.continuousMode = true;
+    config.oscAddress = "/cue/go";
+    config.targetValue = 1;
+    config.latencyStats = true;
+
+    OSCTrigger trigger(g_quietLog, std::make_unique<SlowSink>(sinkUs));
+    if (!trigger.Start(config)) {
+        fprintf(stderr, "Failed to bind 127.0.0.1:%d\n", port);
+        return 1;
+    }
+    std::thread listener([&] { trigger.Listen(); });
+
+    int sender = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    sockaddr_in dest = {};
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &dest.sin_addr);
+    connect(sender, (sockaddr*)&dest, sizeof(dest));
+
+    // Every other message matches, so parse and match see both paths
+    std::vector<char> hit = BuildIntMessage("/cue/go", 1);
+    std::vector<char> miss = BuildIntMessage("/cue/go", 0);
+    for (int i = 0; i < messages; i++) {
+        const std::vector<char>& msg = i % 2 ? miss : hit;
+        send(sender, msg.data(), msg.size(), 0);
+        if (gapUs > 0) std::this_thread::sleep_for(std::chrono::microseconds(gapUs));
+    }
+
+    uint64_t deadline = NowNs() + 5000000000ull;
+    while (trigger.GetDatagramCount() < static_cast<uint64_t>(messages) && NowNs() < deadline) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    trigger.RequestStop();
+    listener.join();
+    close(sender);
+
+    const LatencyStats& stats = trigger.GetLatencyStats();
+    printf("latency: %d messages %d us apart, half matching, sink takes %d us\n", messages, gapUs, sinkUs);
+    for (int stage = 0; stage < StageCount; stage++) {
+        printf("  %s\n", stats.FormatStage(static_cast<LatencyStage>(stage)).c_str());
+    }
+    return stats.stages[StageReceive].Count() > 0 ? 0 : 1;
+}
+
+// ---------------------------------------------------------------------------
+// timetag: bundle scheduling and firing jitter against the timetag
+// ---------------------------------------------------------------------------
+
+static uint64_t TimetagFromNow(int64_t offsetUs) {
+    return UnixNsToTimetag(SystemNowNs() + offsetUs * 1000);
+}
+
+// Checks the due times the engine hands out for immediate, future, late,
+// out-of-horizon and nested bundles.
+static bool CheckTimetagScheduling() {
+    uint64_t lastDue = 0;
+    int fired = 0;
+    Config config;
+    config.continuousMode = true;
+    config.oscAddress = "/cue/go";
+    config.targetValue = 1;
+    OSCEngine engine(g_quietLog, [&](const TriggerRule&, uint64_t, uint64_t dueNs) {
+        lastDue = dueNs;
+        fired++;
+    });
+    engine.Reset(config);
+
+    bool ok = true;
+    auto expect = [&](bool condition, const char* what) {
+        if (!condition) {
+            printf("  FAIL: %s\n", what);
+            ok = false;
+        }
+    };
+    auto run = [&](const std::vector<char>& datagram) {
+        fired = 0;
+        lastDue = ~0ull;
+        engine.ProcessOSCData(datagram.data(), static_cast<int>(datagram.size()));
+        return lastDue;
+    };
+    auto near = [](uint64_t due, int64_t offsetUs) {
+        int64_t error = static_cast<int64_t>(due) - static_cast<int64_t>(SteadyNowNs()) - offsetUs * 1000;
+        return error > -2000000 && error < 2000000;
+    };
+
+    std::vector<char> msg = BuildIntMessage("/cue/go", 1);
+    expect(run(BuildBundle({msg})) == 0, "immediate bundle fires now");
+    expect(near(run(BuildBundle({msg}, TimetagFromNow(50000))), 50000), "future bundle is due at its timetag");
+    uint64_t late = run(BuildBundle({msg}, TimetagFromNow(-5000)));
+    expect(late > 0 && late <= SteadyNowNs(), "late bundle is due in the past, so it fires now and counts as jitter");
+    expect(run(BuildBundle({msg}, TimetagFromNow(3600000000ll))) == 0, "bundle beyond the horizon fires now");
+    expect(near(run(BuildBundle({BuildBundle({msg})}, TimetagFromNow(10000))), 10000), "immediate inner bundle waits for its outer one");
+    expect(near(run(BuildBundle({BuildBundle({msg}, TimetagFromNow(30000))})), 30000), "later inner bundle keeps its own time");
+    expect(run(msg) == 0, "plain message after a bundle fires now");
+
+    std::vector<char> deep = msg;
+    for (int i = 0; i < OSCEngine::kMaxBundleDepth + 1; i++) deep = BuildBundle({deep});
+    run(deep);
+    expect(fired == 0, "bundles nested too deep are dropped");
+
+    config.honorTimetags = false;
+    engine.Reset(config);
+    expect(run(BuildBundle({msg}, TimetagFromNow(50000))) == 0, "--ignore-timetags fires on arrival");
+    return ok;
+}
+
+static int RunTimetagBench(int argc, char** argv) {
+    int port = atoi(ArgValue(argc, argv, "--port", "57625"));
+    int messages = atoi(ArgValue(argc, argv, "--messages", "200"));
+    int leadUs = atoi(ArgValue(argc, argv, "--lead-us", "20000"));
+    int gapUs = atoi(ArgValue(argc, argv, "--gap-us", "2000"));
+
+    printf("timetag: scheduling checks\n");
+    if (!CheckTimetagScheduling()) return 1;
+    printf("  ok\n");
+
+    Config config;
+    config.ipAddress = "127.0.0.1";
+    config.port = port;
+    config.continuousMode = true;
+    config.oscAddress = "/cue/go";
+    config.targetValue = 1;
+
+    auto recorder = std::make_unique<RecordingSink>();
+    RecordingSink* sink = recorder.get();
+    OSCTrigger trigger(g_quietLog, std::move(recorder));
+    if (!trigger.Start(config)) {
+        fprintf(stderr, "Failed to bind 127.0.0.1:%d\n", port);
+        return 1;
+    }
+    std::thread listener([&] { trigger.Listen(); });
+
+    int sender = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    sockaddr_in dest = {};
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &dest.sin_addr);
+    connect(sender, (sockaddr*)&dest, sizeof(dest));
+
+    // Each bundle is sent leadUs ahead of its timetag, so several are
+    // waiting in the timer heap at once
+    std::vector<char> msg = BuildIntMessage("/cue/go", 1);
+    for (int i = 0; i < messages; i++) {
+        std::vector<char> bundle = BuildBundle({msg}, TimetagFromNow(leadUs));
+        send(sender, bundle.data(), bundle.size(), 0);
+        std::this_thread::sleep_for(std::chrono::microseconds(gapUs));
+    }
+
+    uint64_t deadline = NowNs() + 5000000000ull;
+    while (sink->Count() < static_cast<size_t>(messages) && NowNs() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    trigger.RequestStop();
+    listener.join();
+    close(sender);
+
+    DispatchStats stats = trigger.GetDispatchStats();
+    printf("timetag: %d bundles sent %d us ahead of their timetag, %d us apart\n", messages, leadUs, gapUs);
+    printf("%-10s %10s %10s %10s %10s\n", "", "fired", "p50 us", "p99 us", "max us");
+    printf("%-10s %10llu %10.1f %10.1f %10.1f\n", "jitter", (unsigned long long)stats.scheduled, stats.jitterP50Us,
+           stats.jitterP99Us, stats.jitterMaxUs);
+    return stats.scheduled == static_cast<uint64_t>(messages) ? 0 : 1;
+}
+
+// ---------------------------------------------------------------------------
+// repeat: edge, hysteresis, interval and rate limits on a repeating state
+// ---------------------------------------------------------------------------
+
+static bool CheckFireLimits() {
+    bool ok = true;
+    auto expect = [&](bool condition, const char* what) {
+        if (!condition) {
+            printf("  FAIL: %s\n", what);
+            ok = false;
+        }
+    };
+
+    // Feeds (value, receive time in ms) pairs through one rule and counts fires
+    auto fires = [](const char* spec, const std::vector<std::pair<float, int>>& stream, CounterShard* countersOut = nullptr) {
+        Config config;
+        config.oscAddress.clear();
+        config.continuousMode = true;
+        TriggerRule rule;
+        std::string error;
+        ParseRule(spec, rule, error);
+        config.rules.push_back(rule);
+        int count = 0;
+        OSCEngine engine(g_quietLog, [&](const TriggerRule&, uint64_t, uint64_t) { count++; });
+        engine.Reset(config);
+        for (const std::pair<float, int>& sample : stream) {
+            std::vector<char> msg = BuildFloatMessage("/state", sample.first);
+            engine.ProcessOSCData(msg.data(), static_cast<int>(msg.size()), 1000000000ull + sample.second * 1000000ull);
+        }
+        if (countersOut) {
+            for (int c = 0; c < CounterCount; c++) countersOut->Add(static_cast<Counter>(c), engine.GetCounters().Get(static_cast<Counter>(c)));
+        }
+        return count;
+    };
+
+    TriggerRule parsed;
+    std::string error;
+    expect(ParseRule("/state 9 SPACE edge hysteresis=0.5 interval=100 rate=10/3", parsed, error) && parsed.edge &&
+           parsed.hysteresis == 0.5 && parsed.minIntervalMs == 100 && parsed.ratePerSec == 10 && parsed.rateBurst == 3,
+           "rule tokens parse");
+    expect(!ParseRule("/state 9 SPACE burst=0", parsed, error), "burst below 1 is rejected");
+
+    expect(fires("/state 9 SPACE", {{9, 0}, {9, 33}, {9, 66}}) == 3, "plain continuous rule fires on every repeat");
+    CounterShard edgeCounters;
+    expect(fires("/state 9 SPACE edge", {{9, 0}, {9, 33}, {9, 66}, {0, 100}, {9, 133}}, &edgeCounters) == 2,
+           "edge rule fires on entering the target only");
+    expect(edgeCounters.Get(CounterRepeatsSuppressed) == 2 && edgeCounters.Get(CounterMatches) == 4,
+           "suppressed repeats are counted as matches that did not fire");
+    expect(fires("/state 9 SPACE edge hysteresis=0.5", {{9, 0}, {8.8f, 33}, {9, 66}}) == 1, "value inside the band does not re-arm");
+    expect(fires("/state 9 SPACE edge hysteresis=0.5", {{9, 0}, {8, 33}, {9, 66}}) == 2, "value outside the band re-arms");
+    expect(fires("/state 9 SPACE interval=100", {{9, 0}, {9, 50}, {9, 100}, {9, 150}}) == 2, "minimum interval");
+    CounterShard rateCounters;
+    expect(fires("/state 9 SPACE rate=10/2", {{9, 0}, {9, 1}, {9, 2}, {9, 3}, {9, 103}}, &rateCounters) == 3,
+           "token bucket allows a burst, then refills at the rate");
+    expect(rateCounters.Get(CounterRateLimited) == 2, "rate-limited matches are counted");
+    return ok;
+}
+
+static int RunRepeatBench(int argc, char** argv) {
+    int iterations = atoi(ArgValue(argc, argv, "--iterations", "1000000"));
+    int hz = atoi(ArgValue(argc, argv, "--hz", "30"));
+    int holdMessages = atoi(ArgValue(argc, argv, "--hold", "90"));
+
+    printf("repeat: limit checks\n");
+    if (!CheckFireLimits()) return 1;
+    printf("  ok\n");
+
+    // A sender repeating its state at hz, switching between 0 and the
+    // target every holdMessages repeats
+    std::vector<char> on = BuildIntMessage("/state", 9);
+    std::vector<char> off = BuildIntMessage("/state", 0);
+    uint64_t periodNs = 1000000000ull / (hz > 0 ? hz : 30);
+
+    struct Mode {
+        const char* name;
+        const char* spec;
+    };
+    const Mode modes[] = {
+        {"continuous", "/state 9 SPACE"},
+        {"edge", "/state 9 SPACE edge"},
+        {"interval", "/state 9 SPACE interval=500"},
+        {"rate", "/state 9 SPACE rate=1/2"},
+    };
+
+    printf("repeat: %d messages at %d Hz, value held for %d repeats\n", iterations, hz, holdMessages);
+    printf("%-12s %10s %12s %12s %14s %12s\n", "mode", "fired", "suppressed", "limited", "ns/message", "allocs/msg");
+    for (const Mode& mode : modes) {
+        Config config;
+        config.oscAddress.clear();
+        config.continuousMode = true;
+        TriggerRule rule;
+        std::string error;
+        ParseRule(mode.spec, rule, error);
+        config.rules.push_back(rule);
+        uint64_t fired = 0;
+        OSCEngine engine(g_quietLog, [&](const TriggerRule&, uint64_t, uint64_t) { fired++; });
+        engine.Reset(config);
+
+        uint64_t allocsBefore = g_allocations.load();
+        uint64_t start = NowNs();
+        for (int i = 0; i < iterations; i++) {
+            const std::vector<char>& m = (i / holdMessages) % 2 ? off : on;
+            engine.ProcessOSCData(m.data(), static_cast<int>(m.size()), 1000000000ull + i * periodNs);
+        }
+        uint64_t elapsed = NowNs() - start;
+        uint64_t allocs = g_allocations.load() - allocsBefore;
+
+        const CounterShard& counters = engine.GetCounters();
+        printf("%-12s %10llu %12llu %12llu %14.1f %12.3f\n", mode.name, (unsigned long long)fired,
+               (unsigned long long)counters.Get(CounterRepeatsSuppressed), (unsigned long long)counters.Get(CounterRateLimited),
+               (double)elapsed / iterations, (double)allocs / iterations);
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// reload: rule hot reload while a loopback stream keeps arriving
+// ---------------------------------------------------------------------------
+
+static bool CheckRuleReload() {
+    bool ok = true;
+    auto expect = [&](bool condition, const char* what) {
+        if (!condition) {
+            printf("  FAIL: %s\n", what);
+            ok = false;
+        }
+    };
+
+    std::string path = "/tmp/osc_bench_rules." + std::to_string(getpid());
+    auto writeFile = [&](const char* text) {
+        FILE* file = fopen(path.c_str(), "wb");
+        fputs(text, file);
+        fclose(file);
+    };
+    std::vector<TriggerRule> rules;
+    std::string error;
+    writeFile("# cues\n/cue/a 1 SPACE\n\n  /cue/b >0.5 F1 edge\n");
+    expect(LoadRulesFile(path, rules, error) && rules.size() == 2 && rules[1].edge, "rules file loads, skipping comments and blanks");
+    writeFile("/cue/a 1 SPACE\n/cue/b 1 NOSUCHKEY\n");
+    expect(!LoadRulesFile(path, rules, error) && rules.size() == 2 && error.find(":2:") != std::string::npos,
+           "a bad line rejects the whole file and names the line");
+    remove(path.c_str());
+
+    Config config;
+    config.oscAddress.clear();
+    config.continuousMode = true;
+    ParseRule("/cue/a 1 SPACE", rules[0], error);
+    config.rules = {rules[0]};
+    std::string fired;
+    OSCEngine engine(g_quietLog, [&](const TriggerRule& rule, uint64_t, uint64_t) { fired += rule.address; });
+    engine.Reset(config);
+    std::vector<char> a = BuildIntMessage("/cue/a", 1);
+    std::vector<char> b = BuildIntMessage("/cue/b", 1);
+    engine.ProcessOSCData(a.data(), static_cast<int>(a.size()));
+    engine.ProcessOSCData(b.data(), static_cast<int>(b.size()));
+    expect(fired == "/cue/a", "initial rules match");
+
+    ParseRule("/cue/b 1 SPACE", rules[0], error);
+    config.rules = {rules[0]};
+    engine.PublishRules(config);
+    fired.clear();
+    engine.ProcessOSCData(a.data(), static_cast<int>(a.size()));
+    engine.ProcessOSCData(b.data(), static_cast<int>(b.size()));
+    expect(fired == "/cue/b", "the next datagram sees the published rules");
+    expect(engine.ReclaimRules() == 1 && engine.ReclaimRules() == 0, "the replaced table is retired until reclaimed");
+
+    // Reloading an unchanged rules file keeps edge history, even with the
+    // rules reordered; a changed rule re-arms
+    auto reload = [&](const char* text) {
+        writeFile(text);
+        config.rules.clear();
+        bool loaded = LoadRulesFile(path, config.rules, error);
+        remove(path.c_str());
+        engine.PublishRules(config);
+        return loaded;
+    };
+    std::vector<char> e = BuildIntMessage("/cue/e", 1);
+    std::vector<char> f = BuildIntMessage("/cue/f", 1);
+    auto send = [&] {
+        fired.clear();
+        engine.ProcessOSCData(e.data(), static_cast<int>(e.size()));
+        engine.ProcessOSCData(f.data(), static_cast<int>(f.size()));
+        return fired;
+    };
+    expect(reload("/cue/e 1 F1 edge\n/cue/f 1 F2 edge\n") && send() == "/cue/e/cue/f", "edge rules fire on entering");
+    expect(reload("/cue/f 1 F2 edge\n/cue/e 1 F1 edge\n") && send().empty(), "an unchanged reload keeps edge state");
+    expect(reload("/cue/e 1 F1 edge\n/cue/f 1 F3 edge\n") && send() == "/cue/f", "a changed rule re-arms");
+
+    // Reloads hand reclamation to the dispatcher's worker, which frees only
+    // the tables retired before the request once it runs dry
+    SlowSink sink(0);
+    ActionDispatcher dispatcher;
+    dispatcher.Start(sink);
+    uint64_t liveVersion = engine.GetRules().Version();
+    std::atomic<int> freed{-1};
+    dispatcher.WhenIdle([&] { freed = static_cast<int>(engine.ReclaimRules(liveVersion)); });
+    uint64_t deadline = NowNs() + 1000000000;
+    while (freed < 0 && NowNs() < deadline) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    expect(freed == 3, "the idle worker frees the retired tables");
+    engine.PublishRules(config);
+    expect(engine.ReclaimRules(liveVersion) == 0 && engine.ReclaimRules() == 1, "a table retired later is kept");
+    dispatcher.Stop();
+    return ok;
+}
+
+static int RunReloadBench(int argc, char** argv) {
+    int port = atoi(ArgValue(argc, argv, "--port", "57725"));
+    int messages = atoi(ArgValue(argc, argv, "--messages", "200000"));
+    int rulesPerTable = atoi(ArgValue(argc, argv, "--rules", "1000"));
+
+    printf("reload: checks\n");
+    if (!CheckRuleReload()) return 1;
+    printf("  ok\n");
+
+    // Two tables of rulesPerTable rules that differ in which /cue/go value fires
+    Config configs[2];
+    for (int t = 0; t < 2; t++) {
+        configs[t].ipAddress = "127.0.0.1";
+        configs[t].port = port;
+        configs[t].continuousMode = true;
+        configs[t].oscAddress = "/cue/go";
+        configs[t].targetValue = t;
+        for (int i = 0; i < rulesPerTable; i++) {
+            TriggerRule rule;
+            std::string error;
+            ParseRule("/bank/" + std::to_string(i) + " 1 F1", rule, error);
+            configs[t].rules.push_back(rule);
+        }
+    }
+
+    std::atomic<uint64_t> fired{0};
+    struct CountingSink : ActionSink {
+        std::atomic<uint64_t>& count;
+        explicit CountingSink(std::atomic<uint64_t>& c) : count(c) {}
+        void Fire(const TriggerRule&) override { count.fetch_add(1, std::memory_order_relaxed); }
+    };
+    OSCTrigger trigger(g_quietLog, std::make_unique<CountingSink>(fired));
+    if (!trigger.Start(configs[0])) {
+        fprintf(stderr, "Failed to bind 127.0.0.1:%d\n", port);
+        return 1;
+    }
+    std::thread listener([&] { trigger.Listen(); });
+
+    // Paced so the socket buffer never overflows: any shortfall is a reload's fault
+    std::atomic<bool> sending{true};
+    std::thread sender([&] {
+        int fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        sockaddr_in dest = {};
+        dest.sin_family = AF_INET;
+        dest.sin_port = htons(port);
+        inet_pton(AF_INET, "127.0.0.1", &dest.sin_addr);
+        connect(fd, (sockaddr*)&dest, sizeof(dest));
+        std::vector<char> msgs[2] = {BuildIntMessage("/cue/go", 0), BuildIntMessage("/cue/go", 1)};
+        for (int i = 0; i < messages; i++) {
+            send(fd, msgs[i & 1].data(), msgs[i & 1].size(), 0);
+            if (i % 64 == 63) {
+                while (trigger.GetDatagramCount() + 64 < static_cast<uint64_t>(i)) std::this_thread::yield();
+            }
+        }
+        close(fd);
+        sending = false;
+    });
+
+    uint64_t reloads = 0;
+    uint64_t publishSumNs = 0;
+    uint64_t publishMaxNs = 0;
+    uint64_t start = NowNs();
+    while (sending) {
+        uint64_t before = NowNs();
+        trigger.ApplyRules(configs[++reloads & 1]);
+        uint64_t took = NowNs() - before;
+        publishSumNs += took;
+        publishMaxNs = (std::max)(publishMaxNs, took);
+    }
+    sender.join();
+    uint64_t deadline = NowNs() + 5000000000ull;
+    while (trigger.GetDatagramCount() < static_cast<uint64_t>(messages) && NowNs() < deadline) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    double elapsedMs = (NowNs() - start) / 1e6;
+    trigger.RequestStop();
+    listener.join();
+
+    uint64_t received = trigger.GetDatagramCount();
+    printf("reload: %d datagrams over loopback while swapping %d-rule tables back to back\n", messages, rulesPerTable + 1);
+    printf("  %llu reloads in %.0f ms, build+publish avg %.0f us, max %.0f us\n", (unsigned long long)reloads, elapsedMs,
+           reloads ? publishSumNs / 1e3 / reloads : 0.0, publishMaxNs / 1e3);
+    printf("  received %llu of %d datagrams (%lld dropped), %llu actions fired\n", (unsigned long long)received, messages,
+           (long long)messages - (long long)received, (unsigned long long)fired.load());
+    return received == static_cast<uint64_t>(messages) ? 0 : 1;
+}
+
+// ---------------------------------------------------------------------------
+// large: datagrams up to the UDP maximum through the receive buffer pool
+// ---------------------------------------------------------------------------
+
+// A bundle of /large/go messages, as close to bytes long as whole messages allow.
+static std::vector<char> BuildLargeBundle(int bytes, int* messageCount) {
+    std::vector<char> message = BuildIntMessage("/large/go", 1);
+    int count = (bytes - 16) / static_cast<int>(message.size() + 4);
+    *messageCount = count;
+    return BuildBundle(std::vector<std::vector<char>>(count, message));
+}
+
+static uint64_t ResidentKb() {
+    FILE* status = fopen("/proc/self/status", "r");
+    if (!status) return 0;
+    char line[256];
+    uint64_t kb = 0;
+    while (fgets(line, sizeof(line), status)) {
+        if (sscanf(line, "VmRSS: %llu kB", (unsigned long long*)&kb) == 1) break;
+    }
+    fclose(status);
+    return kb;
+}
+
+struct LargeRun {
+    uint64_t received = 0;
+    uint64_t messages = 0;
+    uint64_t malformed = 0;
+    uint64_t truncated = 0;
+    uint64_t allocations = 0; // While the stream was arriving
+    double seconds = 0;
+    int64_t residentGrowthKb = 0; // From just after Start() to the end of the stream
+};
+
+// Sends each datagram in order, paced so the socket buffer never overflows.
+static LargeRun SendLarge(int port, int batchSize, int maxDatagramBytes, const std::vector<const std::vector<char>*>& datagrams) {
+    Config config;
+    config.ipAddress = "127.0.0.1";
+    config.port = port;
+    config.continuousMode = true;
+    config.oscAddress = "/large/go";
+    config.targetValue = 2; // Every message is looked up and compared, none fire
+    config.recvBatchSize = batchSize;
+    config.maxDatagramBytes = maxDatagramBytes;
+    config.recvBufferBytes = 4 * 1024 * 1024;
+
+    OSCTrigger trigger(g_quietLog, std::make_unique<NullSink>());
+    if (!trigger.Start(config)) {
+        fprintf(stderr, "Failed to bind 127.0.0.1:%d\n", port);
+        exit(1);
+    }
+    std::thread listener([&] { trigger.Listen(); });
+
+    int sender = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    int sendBuffer = 4 * 1024 * 1024;
+    setsockopt(sender, SOL_SOCKET, SO_SNDBUF, &sendBuffer, sizeof(sendBuffer));
+    sockaddr_in dest = {};
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &dest.sin_addr);
+    connect(sender, (sockaddr*)&dest, sizeof(dest));
+
+    LargeRun run;
+    uint64_t residentBefore = ResidentKb();
+    uint64_t allocsBefore = g_allocations.load();
+    uint64_t start = NowNs();
+    for (size_t i = 0; i < datagrams.size(); i++) {
+        send(sender, datagrams[i]->data(), datagrams[i]->size(), 0);
+        while (trigger.GetDatagramCount() + 16 < i) std::this_thread::yield();
+    }
+    uint64_t deadline = NowNs() + 5000000000ull;
+    while (trigger.GetDatagramCount() < datagrams.size() && NowNs() < deadline) std::this_thread::yield();
+    run.seconds = (NowNs() - start) / 1e9;
+    run.allocations = g_allocations.load() - allocsBefore;
+    run.residentGrowthKb = static_cast<int64_t>(ResidentKb()) - static_cast<int64_t>(residentBefore);
+
+    trigger.RequestStop();
+    listener.join();
+    close(sender);
+
+    const MetricsRegistry& metrics = trigger.GetMetrics();
+    run.received = trigger.GetDatagramCount() + metrics.Total(CounterTruncatedDatagrams);
+    run.messages = metrics.Total(CounterMessages);
+    run.malformed = metrics.Total(CounterMalformed) + metrics.Total(CounterTruncatedBundles);
+    run.truncated = metrics.Total(CounterTruncatedDatagrams);
+    return run;
+}
+
+static bool CheckLargeDatagrams(int port) {
+    bool ok = true;
+    auto expect = [&](bool condition, const char* what) {
+        if (!condition) {
+            printf("  FAIL: %s\n", what);
+            ok = false;
+        }
+    };
+
+    const int sizes[] = {1000, 4096, 8000, 32000, 65000};
+    std::vector<std::vector<char>> bundles;
+    uint64_t expected = 0;
+    for (int size : sizes) {
+        int count;
+        bundles.push_back(BuildLargeBundle(size, &count));
+        expected += count;
+    }
+    std::vector<const std::vector<char>*> stream;
+    for (const std::vector<char>& bundle : bundles) stream.push_back(&bundle);
+    for (int batch : {1, 32}) {
+        LargeRun run = SendLarge(port, batch, ReceiveBufferPool::kMaxDatagramBytes, stream);
+        expect(run.received == bundles.size() && run.messages == expected && run.malformed == 0 && run.truncated == 0,
+               batch == 1 ? "bundles up to 65000 bytes arrive whole (recvmsg)" : "bundles up to 65000 bytes arrive whole (recvmmsg)");
+    }
+
+    std::vector<char> small = BuildIntMessage("/large/go", 1);
+    stream = {&bundles[2], &small, &bundles[0]};
+    for (int batch : {1, 32}) {
+        LargeRun run = SendLarge(port, batch, 4096, stream);
+        int firstCount;
+        BuildLargeBundle(sizes[0], &firstCount);
+        expect(run.truncated == 1 && run.malformed == 0 && run.messages == static_cast<uint64_t>(firstCount) + 1,
+               "a datagram over --max-datagram is counted and dropped, the rest go through");
+    }
+    return ok;
+}
+
+static int RunLargeBench(int argc, char** argv) {
+    int port = atoi(ArgValue(argc, argv, "--port", "57925"));
+    int datagrams = atoi(ArgValue(argc, argv, "--datagrams", "5000"));
+    int bytes = atoi(ArgValue(argc, argv, "--bytes", "65000"));
+
+    printf("large: checks\n");
+    if (!CheckLargeDatagrams(port)) return 1;
+    printf("  ok\n");
+
+    int count;
+    std::vector<char> bundle = BuildLargeBundle(bytes, &count);
+    std::vector<const std::vector<char>*> stream(datagrams, &bundle);
+    printf("large: %d bundles of %zu bytes (%d messages each) over loopback\n", datagrams, bundle.size(), count);
+    printf("%-8s %10s %12s %10s %14s %14s\n", "batch", "received", "MB/s", "us/dgram", "allocs/dgram", "RSS growth KB");
+    for (int batch : {1, 32}) {
+        LargeRun run = SendLarge(port, batch, ReceiveBufferPool::kMaxDatagramBytes, stream);
+        printf("%-8d %10llu %12.0f %10.1f %14.3f %14lld\n", batch, (unsigned long long)run.received,
+               run.received * bundle.size() / run.seconds / 1e6, run.seconds * 1e6 / datagrams,
+               (double)run.allocations / datagrams, (long long)run.residentGrowthKb);
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// tcp: OSC 1.0 length-prefixed and OSC 1.1 SLIP streams from many clients
+// ---------------------------------------------------------------------------
+
+static void AppendFramed(std::vector<char>& out, const std::vector<char>& packet, StreamFraming framing) {
+    if (framing == FramingLengthPrefix) {
+        AppendInt32(out, static_cast<int32_t>(packet.size()));
+        out.insert(out.end(), packet.begin(), packet.end());
+        return;
+    }
+    out.push_back(static_cast<char>(StreamDeframer::kSlipEnd));
+    for (char c : packet) {
+        uint8_t byte = static_cast<uint8_t>(c);
+        if (byte == StreamDeframer::kSlipEnd || byte == StreamDeframer::kSlipEsc) {
+            out.push_back(static_cast<char>(StreamDeframer::kSlipEsc));
+            out.push_back(static_cast<char>(byte == StreamDeframer::kSlipEnd ? StreamDeframer::kSlipEscEnd : StreamDeframer::kSlipEscEsc));
+        } else {
+            out.push_back(c);
+        }
+    }
+    out.push_back(static_cast<char>(StreamDeframer::kSlipEnd));
+}
+
+// Feeds stream to a de-framer chunk bytes at a time and collects the packets.
+static bool Deframe(StreamDeframer& deframer, const std::vector<char>& stream, size_t chunk, std::vector<std::vector<char>>& packets) {
+    std::vector<char> scratch(StreamDeframer::RingLimit(ReceiveBufferPool::kMaxDatagramBytes));
+    size_t offset = 0;
+    while (offset < stream.size()) {
+        char* spans[2];
+        size_t lengths[2];
+        int count = deframer.ReadSpans(spans, lengths);
+        for (int i = 0; i < count && offset < stream.size(); i++) {
+            size_t n = (std::min)((std::min)(lengths[i], chunk), stream.size() - offset);
+            memcpy(spans[i], stream.data() + offset, n);
+            deframer.Commit(n);
+            offset += n;
+            if (n < lengths[i]) break;
+        }
+        bool framed = deframer.Drain(scratch.data(), [&](const char* data, int length) { packets.emplace_back(data, data + length); });
+        if (!framed) return false;
+    }
+    return true;
+}
+
+static bool CheckStreamDeframer() {
+    bool ok = true;
+    auto expect = [&](bool condition, const char* what) {
+        if (!condition) {
+            printf("  FAIL: %s\n", what);
+            ok = false;
+        }
+    };
+
+    // Small and large packets, SLIP's special bytes inside, and one longer than the initial ring
+    std::vector<std::vector<char>> packets;
+    for (int i = 0; i < 200; i++) packets.push_back(BuildIntMessage("/tcp/check", static_cast<int32_t>(0xC0DB0000u + i)));
+    int count;
+    packets.push_back(BuildLargeBundle(20000, &count));
+    packets.push_back(BuildIntMessage("/tcp/after", static_cast<int32_t>(0xDBDBC0C0u)));
+    packets.push_back(BuildLargeBundle(65000, &count));
+    packets.push_back(BuildIntMessage("/tcp/last", 1));
+
+    for (StreamFraming framing : {FramingLengthPrefix, FramingSlip}) {
+        std::vector<char> stream;
+        for (const std::vector<char>& packet : packets) AppendFramed(stream, packet, framing);
+        if (framing == FramingLengthPrefix) AppendInt32(stream, 0); // An empty packet is skipped
+        for (size_t chunk : {size_t(1), size_t(3), size_t(7), size_t(1000), size_t(4096), stream.size()}) {
+            StreamDeframer deframer(framing, ReceiveBufferPool::kMaxDatagramBytes);
+            std::vector<std::vector<char>> received;
+            bool framed = Deframe(deframer, stream, chunk, received);
+            expect(framed && received == packets, framing == FramingSlip ? "SLIP packets come out whole in any chunking"
+                                                                         : "length-prefixed packets come out whole in any chunking");
+            expect(deframer.Buffered() == 0, "nothing is left buffered after the last packet");
+        }
+    }
+
+    std::vector<char> bad;
+    AppendInt32(bad, 70000);
+    bad.resize(bad.size() + 100, 0);
+    StreamDeframer lengthDeframer(FramingLengthPrefix, ReceiveBufferPool::kMaxDatagramBytes);
+    std::vector<std::vector<char>> received;
+    expect(!Deframe(lengthDeframer, bad, 4096, received), "a length prefix over the limit ends the stream");
+
+    std::vector<char> endless(1, static_cast<char>(StreamDeframer::kSlipEnd));
+    endless.resize(StreamDeframer::RingLimit(1000) + 1, 'x');
+    StreamDeframer slipDeframer(FramingSlip, 1000);
+    expect(!Deframe(slipDeframer, endless, 4096, received), "a SLIP packet that outgrows the ring ends the stream");
+    expect(received.empty(), "no packet is handed on from a stream that can't be framed");
+    return ok;
+}
+
+static int ConnectTcp(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    sockaddr_in dest = {};
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &dest.sin_addr);
+    if (connect(fd, (sockaddr*)&dest, sizeof(dest)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int OpenConnections(const OSCTrigger& trigger, const std::string& endpoint) {
+    int open = 0;
+    for (const SocketStats& stats : trigger.GetSocketStats()) {
+        if (stats.endpoint == endpoint) open += stats.connections;
+    }
+    return open;
+}
+
+struct TcpRun {
+    uint64_t received = 0;
+    uint64_t malformed = 0;
+    uint64_t refused = 0;
+    uint64_t framingErrors = 0;
+    uint64_t allocations = 0; // While the streams were arriving
+    double seconds = 0;
+};
+
+// Connects clients to a stream endpoint, waits until all are accepted, then
+// has each send the same stream in chunk-sized writes, round robin, so
+// packets straddle reads and wrap the connection rings.
+static TcpRun StreamClients(int port, StreamFraming framing, int clients, int maxConnections, const std::vector<char>& stream,
+                            uint64_t expected, size_t chunk) {
+    Config config;
+    config.ipAddress = "127.0.0.1";
+    config.port = port;
+    config.continuousMode = true;
+    config.oscAddress = "/tcp/go";
+    config.targetValue = -1; // Every message is looked up and compared, none fire
+    config.maxTcpConnections = maxConnections;
+    Endpoint endpoint;
+    std::string error;
+    ParseEndpoint(std::string("tcp=") + (framing == FramingSlip ? "slip://" : "tcp://") + "127.0.0.1:" + std::to_string(port + 1), endpoint, error);
+    config.extraEndpoints.push_back(endpoint);
+
+    OSCTrigger trigger(g_quietLog, std::make_unique<NullSink>());
+    if (!trigger.Start(config)) {
+        fprintf(stderr, "Failed to bind 127.0.0.1:%d-%d\n", port, port + 1);
+        exit(1);
+    }
+    std::thread listener([&] { trigger.Listen(); });
+
+    std::vector<int> sockets;
+    for (int i = 0; i < clients; i++) sockets.push_back(ConnectTcp(port + 1));
+    uint64_t deadline = NowNs() + 2000000000ull;
+    while (OpenConnections(trigger, "tcp") + static_cast<int>(trigger.GetMetrics().Total(CounterTcpRefused)) < clients && NowNs() < deadline) {
+        std::this_thread::yield();
+    }
+
+    TcpRun run;
+    uint64_t allocsBefore = g_allocations.load();
+    uint64_t start = NowNs();
+    for (size_t offset = 0; offset < stream.size(); offset += chunk) {
+        size_t n = (std::min)(chunk, stream.size() - offset);
+        for (int fd : sockets) {
+            if (fd >= 0) send(fd, stream.data() + offset, n, MSG_NOSIGNAL);
+        }
+    }
+    deadline = NowNs() + 5000000000ull;
+    while (trigger.GetDatagramCount() < expected && NowNs() < deadline) std::this_thread::yield();
+    run.seconds = (NowNs() - start) / 1e9;
+    run.allocations = g_allocations.load() - allocsBefore;
+
+    for (int fd : sockets) {
+        if (fd >= 0) close(fd);
+    }
+    trigger.RequestStop();
+    listener.join();
+
+    const MetricsRegistry& metrics = trigger.GetMetrics();
+    run.received = trigger.GetDatagramCount();
+    run.malformed = metrics.Total(CounterMalformed);
+    run.refused = metrics.Total(CounterTcpRefused);
+    run.framingErrors = metrics.Total(CounterTcpFramingErrors);
+    return run;
+}
+
+static std::vector<char> BuildClientStream(StreamFraming framing, int messages) {
+    std::vector<char> stream;
+    for (int i = 0; i < messages; i++) AppendFramed(stream, BuildIntMessage("/tcp/go", i), framing);
+    return stream;
+}
+
+static bool CheckTcpClients(int port) {
+    bool ok = true;
+    auto expect = [&](bool condition, const char* what) {
+        if (!condition) {
+            printf("  FAIL: %s\n", what);
+            ok = false;
+        }
+    };
+
+    for (StreamFraming framing : {FramingLengthPrefix, FramingSlip}) {
+        std::vector<char> stream = BuildClientStream(framing, 500);
+        TcpRun run = StreamClients(port, framing, 8, 256, stream, 8 * 500, 333);
+        expect(run.received == 8 * 500 && run.malformed == 0 && run.framingErrors == 0,
+               framing == FramingSlip ? "every SLIP packet from 8 clients arrives" : "every length-prefixed packet from 8 clients arrives");
+    }
+
+    std::vector<char> stream = BuildClientStream(FramingLengthPrefix, 100);
+    TcpRun run = StreamClients(port, FramingLengthPrefix, 6, 4, stream, 4 * 100, 4096);
+    expect(run.refused == 2 && run.received == 4 * 100, "clients past --max-connections are refused, the rest served");
+    return ok;
+}
+
+static int RunTcpBench(int argc, char** argv) {
+    int port = atoi(ArgValue(argc, argv, "--port", "58025"));
+    int messages = atoi(ArgValue(argc, argv, "--messages", "2000"));
+    int maxClients = atoi(ArgValue(argc, argv, "--clients", "256"));
+    size_t chunk = static_cast<size_t>(atoi(ArgValue(argc, argv, "--chunk", "1024")));
+
+    printf("tcp: checks\n");
+    if (!CheckStreamDeframer() || !CheckTcpClients(port)) return 1;
+    printf("  ok\n");
+
+    printf("tcp: %d messages per client, written %zu bytes at a time, over loopback\n", messages, chunk);
+    printf("%-8s %8s %12s %12s %10s %14s\n", "framing", "clients", "received", "msgs/s", "MB/s", "allocs/packet");
+    for (StreamFraming framing : {FramingLengthPrefix, FramingSlip}) {
+        std::vector<char> stream = BuildClientStream(framing, messages);
+        for (int clients = 1; clients <= maxClients; clients *= 4) {
+            uint64_t expected = static_cast<uint64_t>(clients) * messages;
+            TcpRun run = StreamClients(port, framing, clients, maxClients, stream, expected, chunk);
+            printf("%-8s %8d %12llu %12.0f %10.1f %14.3f%s\n", framing == FramingSlip ? "slip" : "length", clients,
+                   (unsigned long long)run.received, run.received / run.seconds, run.received * (stream.size() / messages) / run.seconds / 1e6,
+                   (double)run.allocations / expected, run.received < expected ? "  (short)" : "");
+        }
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// relay: forwarding received datagrams to other UDP destinations
+// ---------------------------------------------------------------------------
+
+struct RelayRun {
+    uint64_t received = 0;
+    uint64_t relayed = 0;
+    uint64_t dropped = 0;
+    uint64_t allocations = 0; // While the stream was arriving
+    double seconds = 0;
+    std::vector<std::vector<std::vector<char>>> delivered; // Per destination, in arrival order
+};
+
+// Listens on port (UDP) and port+1 (length-prefixed TCP) with a relay to
+// each of destinations, "FILTER:" prefixes allowed, on ports from port+2 up.
+// Sends the datagrams, paced so no socket buffer overflows, then the TCP
+// stream in chunk-sized writes, and counts what each destination receives.
+// keep holds on to the payloads, so only checks should set it.
+static RelayRun RelayStream(int port, const std::vector<std::string>& filters, const std::vector<std::vector<char>>& datagrams,
+                            int repeat, const std::vector<char>& tcpStream, uint64_t tcpPackets, bool keep) {
+    Config config;
+    config.ipAddress = "127.0.0.1";
+    config.port = port;
+    config.continuousMode = true;
+    config.oscAddress = "/relay/go";
+    config.targetValue = 1;
+    config.recvBufferBytes = 4 * 1024 * 1024;
+    Endpoint endpoint;
+    std::string error;
+    ParseEndpoint("tcp=tcp://127.0.0.1:" + std::to_string(port + 1), endpoint, error);
+    config.extraEndpoints.push_back(endpoint);
+
+    std::vector<int> receivers;
+    for (size_t i = 0; i < filters.size(); i++) {
+        std::string spec = (filters[i].empty() ? "" : filters[i] + ":") + "127.0.0.1:" + std::to_string(port + 2 + static_cast<int>(i));
+        RelayDestination destination;
+        ParseRelayDestination(spec, destination, error);
+        config.relayDestinations.push_back(destination);
+
+        int fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        int receiveBuffer = 16 * 1024 * 1024;
+        if (setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &receiveBuffer, sizeof(receiveBuffer)) < 0) {
+            setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof(receiveBuffer));
+        }
+        sockaddr_in local = {};
+        local.sin_family = AF_INET;
+        local.sin_port = htons(port + 2 + static_cast<int>(i));
+        inet_pton(AF_INET, "127.0.0.1", &local.sin_addr);
+        bind(fd, (sockaddr*)&local, sizeof(local));
+        receivers.push_back(fd);
+    }
+
+    OSCTrigger trigger(g_quietLog, std::make_unique<NullSink>());
+    if (!trigger.Start(config)) {
+        fprintf(stderr, "Failed to bind 127.0.0.1:%d-%d\n", port, port + 1);
+        exit(1);
+    }
+    std::thread listener([&] { trigger.Listen(); });
+
+    RelayRun run;
+    run.delivered.resize(filters.size());
+    std::vector<uint64_t> counts(filters.size(), 0);
+    std::atomic<bool> draining(true);
+    std::thread drainer([&] {
+        static char buffer[ReceiveBufferPool::kMaxDatagramBytes];
+        for (bool last = false; !last;) {
+            last = !draining.load();
+            bool idle = true;
+            for (size_t i = 0; i < receivers.size(); i++) {
+                ssize_t bytes;
+                while ((bytes = recv(receivers[i], buffer, sizeof(buffer), MSG_DONTWAIT)) >= 0) {
+                    counts[i]++;
+                    if (keep) run.delivered[i].emplace_back(buffer, buffer + bytes);
+                    idle = false;
+                }
+            }
+            if (idle) std::this_thread::yield();
+        }
+    });
+
+    int sender = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    sockaddr_in dest = {};
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &dest.sin_addr);
+    connect(sender, (sockaddr*)&dest, sizeof(dest));
+    int client = tcpStream.empty() ? -1 : ConnectTcp(port + 1);
+
+    uint64_t expected = static_cast<uint64_t>(datagrams.size()) * repeat + tcpPackets;
+    uint64_t allocsBefore = g_allocations.load();
+    uint64_t start = NowNs();
+    uint64_t sent = 0;
+    for (int r = 0; r < repeat; r++) {
+        for (const std::vector<char>& datagram : datagrams) {
+            send(sender, datagram.data(), datagram.size(), 0);
+            sent++;
+            while (trigger.GetDatagramCount() + 256 < sent) std::this_thread::yield();
+        }
+    }
+    for (size_t offset = 0; client >= 0 && offset < tcpStream.size(); offset += 333) {
+        send(client, tcpStream.data() + offset, (std::min)(static_cast<size_t>(333), tcpStream.size() - offset), MSG_NOSIGNAL);
+    }
+    const MetricsRegistry& metrics = trigger.GetMetrics();
+    uint64_t deadline = NowNs() + 5000000000ull;
+    while (trigger.GetDatagramCount() < expected && NowNs() < deadline) std::this_thread::yield();
+    uint64_t forwarded = 0;
+    for (int i = 0; i < 100 && forwarded != metrics.Total(CounterRelayed) + metrics.Total(CounterRelayDropped); i++) {
+        forwarded = metrics.Total(CounterRelayed) + metrics.Total(CounterRelayDropped);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1)); // Until the last flush has been counted
+    }
+    run.seconds = (NowNs() - start) / 1e9;
+    run.allocations = g_allocations.load() - allocsBefore;
+
+    if (client >= 0) close(client);
+    trigger.RequestStop();
+    listener.join();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    draining = false;
+    drainer.join();
+    close(sender);
+    for (int fd : receivers) close(fd);
+
+    run.received = trigger.GetDatagramCount();
+    run.relayed = metrics.Total(CounterRelayed);
+    run.dropped = metrics.Total(CounterRelayDropped);
+    if (!keep) {
+        for (size_t i = 0; i < counts.size(); i++) run.delivered[i].resize(counts[i]);
+    }
+    return run;
+}
+
+static bool CheckRelay(int port) {
+    bool ok = true;
+    auto expect = [&](bool condition, const char* what) {
+        if (!condition) {
+            printf("  FAIL: %s\n", what);
+            ok = false;
+        }
+    };
+
+    std::vector<std::vector<char>> datagrams;
+    size_t matched = 0;
+    for (int i = 0; i < 10; i++) {
+        int value = i % 3 == 0 ? 1 : 2;
+        datagrams.push_back(BuildIntMessage(i == 5 ? "/relay/other" : "/relay/go", value));
+        if (value == 1 && i != 5) matched++;
+    }
+    RelayRun run = RelayStream(port, {"", "matched", "unmatched"}, datagrams, 1, {}, 0, true);
+    expect(run.delivered[0] == datagrams, "all: every datagram arrives unchanged and in order");
+    expect(run.delivered[1].size() == matched && run.delivered[2].size() == datagrams.size() - matched,
+           "matched/unmatched: each datagram goes to exactly one of the two");
+    bool routed = true;
+    for (const std::vector<char>& datagram : run.delivered[1]) routed &= datagram == datagrams[0] || datagram == datagrams[3] || datagram == datagrams[9];
+    expect(routed, "matched: only datagrams a rule matched");
+    expect(run.relayed == datagrams.size() * 2 && run.dropped == 0, "relayed counter counts once per destination");
+
+    // Packets around one that outgrows the connection ring must reach the
+    // relay intact, and the grown ring must not move packets still queued.
+    int count;
+    std::vector<char> bundle = BuildLargeBundle(20000, &count);
+    std::vector<std::vector<char>> packets;
+    std::vector<char> stream;
+    for (int i = 0; i < 40; i++) {
+        packets.push_back(i == 30 ? bundle : BuildIntMessage("/relay/go", i));
+        AppendFramed(stream, packets.back(), FramingLengthPrefix);
+    }
+    run = RelayStream(port, {""}, {}, 0, stream, packets.size(), true);
+    expect(run.delivered[0] == packets, "TCP packets are relayed unchanged across ring growth");
+    return ok;
+}
+
+static int RunRelayBench(int argc, char** argv) {
+    int port = atoi(ArgValue(argc, argv, "--port", "58125"));
+    int messages = atoi(ArgValue(argc, argv, "--messages", "200000"));
+
+    printf("relay: checks\n");
+    if (!CheckRelay(port)) return 1;
+    printf("  ok\n");
+
+    std::vector<std::vector<char>> datagrams;
+    for (int i = 0; i < 64; i++) datagrams.push_back(BuildIntMessage("/relay/go", i + 2)); // Looked up, never fired
+    int repeat = (std::max)(1, messages / 64);
+    uint64_t expected = static_cast<uint64_t>(repeat) * 64;
+    printf("relay: %llu datagrams over loopback, relayed to every destination\n", (unsigned long long)expected);
+    printf("%-12s %10s %12s %12s %10s %14s\n", "destinations", "received", "msgs/s", "relayed", "dropped", "allocs/dgram");
+    for (int destinations : {0, 1, 3}) {
+        RelayRun run = RelayStream(port, std::vector<std::string>(destinations), datagrams, repeat, {}, 0, false);
+        uint64_t delivered = 0;
+        for (const auto& received : run.delivered) delivered += received.size();
+        printf("%-12d %10llu %12.0f %12llu %10llu %14.3f%s\n", destinations, (unsigned long long)run.received, run.received / run.seconds,
+               (unsigned long long)run.relayed, (unsigned long long)run.dropped, (double)run.allocations / expected,
+               delivered < run.relayed ? "  (receiver buffers overflowed)" : "");
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// window: cached target-window resolution against a fake window list
+// ---------------------------------------------------------------------------
+
+static bool CheckWindowInvalidation() {
+    FakeWindowRegistry windows;
+    CachedWindowResolver resolver(windows);
+    bool ok = true;
+    auto expect = [&](bool condition, const char* what) {
+        if (!condition) {
+            printf("  FAIL: %s\n", what);
+            ok = false;
+        }
+    };
+
+    WindowHandle show = windows.Open("Show Control");
+    WindowHandle other = windows.Open("Editor");
+    expect(resolver.Resolve("Show Control") == show, "first resolve finds the window");
+    expect(resolver.Resolve("Show Control") == show && windows.findCalls == 1, "second resolve is served from the cache");
+
+    windows.Close(show);
+    expect(resolver.Resolve("Show Control") == 0, "closed window is not returned");
+    WindowHandle reopened = windows.Open("Show Control");
+    expect(resolver.Resolve("Show Control") == reopened, "reopened window is found again");
+
+    windows.Rename(reopened, "Show Control - modified");
+    expect(resolver.Resolve("Show Control") == 0, "renamed window no longer matches its old title");
+    expect(resolver.Resolve("Show Control - modified") == reopened, "renamed window matches its new title");
+
+    expect(resolver.Resolve("Editor") == other, "a second title resolves independently");
+    return ok;
+}
+
+static int RunWindowBench(int argc, char** argv) {
+    int iterations = atoi(ArgValue(argc, argv, "--iterations", "1000000"));
+    int windowCount = atoi(ArgValue(argc, argv, "--windows", "200"));
+
+    printf("window: invalidation checks\n");
+    if (!CheckWindowInvalidation()) return 1;
+    printf("  ok\n");
+
+    FakeWindowRegistry windows;
+    for (int i = 0; i < windowCount - 1; i++) {
+        windows.Open("Window " + std::to_string(i));
+    }
+    windows.Open("Show Control"); // Last, so a full lookup walks the whole list
+    CachedWindowResolver resolver(windows);
+    std::string title = "Show Control";
+
+    printf("window: %d resolves of one title among %d windows\n", iterations, windowCount);
+    printf("%-10s %14s %12s\n", "", "ns/resolve", "full finds");
+
+    windows.findCalls = 0;
+    uint64_t start = NowNs();
+    WindowHandle sink = 0;
+    for (int i = 0; i < iterations; i++) sink ^= windows.Find(title);
+    uint64_t elapsed = NowNs() - start;
+    printf("%-10s %14.1f %12llu\n", "uncached", (double)elapsed / iterations, (unsigned long long)windows.findCalls);
+
+    windows.findCalls = 0;
+    start = NowNs();
+    for (int i = 0; i < iterations; i++) sink ^= resolver.Resolve(title);
+    elapsed = NowNs() - start;
+    printf("%-10s %14.1f %12llu\n", "cached", (double)elapsed / iterations, (unsigned long long)windows.findCalls);
+    return sink == 0x12345 ? 2 : 0; // Keeps the loops from being optimised away
+}
+
+// ---------------------------------------------------------------------------
+// log: cost of per-packet debug lines, disabled and enabled
+// ---------------------------------------------------------------------------
+
+static int RunLogBench(int argc, char** argv) {
+    int iterations = atoi(ArgValue(argc, argv, "--iterations", "2000000"));
+
+    Config config;
+    config.continuousMode = true;
+    std::vector<char> msg = BuildIntMessage("/flair/runstate", 0); // Value mismatch: no trigger lines
+
+    printf("log: %d non-matching messages through the engine\n", iterations);
+    printf("%-20s %14s %14s %14s\n", "", "ns/message", "allocs/msg", "lines kept");
+
+    LogLevel levels[] = {LogInfo, LogDebug};
+    for (LogLevel level : levels) {
+        LogRing ring(4096, level);
+        OSCEngine engine(ring, [](const TriggerRule&, uint64_t, uint64_t) {});
+        engine.Reset(config);
+        ring.Drain([](const LogEntry&) {});
+
+        uint64_t kept = 0;
+        uint64_t allocsBefore = g_allocations.load();
+        uint64_t start = NowNs();
+        for (int i = 0; i < iterations; i++) {
+            engine.ProcessOSCData(msg.data(), static_cast<int>(msg.size()));
+            if ((i & 1023) == 1023) kept += ring.Drain([](const LogEntry&) {}); // Reader keeping up
+        }
+        kept += ring.Drain([](const LogEntry&) {});
+        uint64_t elapsed = NowNs() - start;
+        uint64_t allocs = g_allocations.load() - allocsBefore;
+
+        std::string name = std::string("level ") + LogLevelName(level);
+        printf("%-20s %14.1f %14.3f %14llu\n", name.c_str(), (double)elapsed / iterations,
+               (double)allocs / iterations, (unsigned long long)kept);
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// stop: idle cost and stop-to-exit latency of the listener loop
+// ---------------------------------------------------------------------------
+
+static double ProcessCpuSeconds() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+static int RunStopBench(int argc, char** argv) {
+    int port = atoi(ArgValue(argc, argv, "--port", "57125"));
+    int rounds = atoi(ArgValue(argc, argv, "--rounds", "200"));
+    double idleSeconds = atof(ArgValue(argc, argv, "--idle", "2"));
+
+    Config config;
+    config.ipAddress = "127.0.0.1";
+    config.port = port;
+    config.continuousMode = true;
+
+    // Idle: the listener should sleep in the kernel, not spin on a timeout
+    {
+        OSCTrigger trigger(g_quietLog, std::make_unique<NullSink>());
+        if (!trigger.Start(config)) {
+            fprintf(stderr, "Failed to bind 127.0.0.1:%d\n", port);
+            return 1;
+        }
+        std::thread listener([&] { trigger.Listen(); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        double cpuStart = ProcessCpuSeconds();
+        std::this_thread::sleep_for(std::chrono::duration<double>(idleSeconds));
+        double cpu = ProcessCpuSeconds() - cpuStart;
+
+        trigger.RequestStop();
+        listener.join();
+        printf("stop: idle listener used %.3f ms CPU over %.1f s\n", cpu * 1e3, idleSeconds);
+    }
+
+    // Latency: RequestStop() on another thread until Listen() has returned
+    std::vector<double> external;
+    std::vector<double> internal;
+    for (int r = 0; r < rounds; r++) {
+        OSCTrigger trigger(g_quietLog, std::make_unique<NullSink>());
+        if (!trigger.Start(config)) {
+            fprintf(stderr, "Failed to bind 127.0.0.1:%d\n", port);
+            return 1;
+        }
+        std::thread listener([&] { trigger.Listen(); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(2)); // Let it block
+
+        uint64_t start = NowNs();
+        trigger.RequestStop();
+        listener.join();
+        external.push_back((NowNs() - start) / 1e3);
+        internal.push_back(static_cast<double>(trigger.GetLastStopLatencyUs()));
+    }
+
+    std::sort(external.begin(), external.end());
+    std::sort(internal.begin(), internal.end());
+    auto at = [](const std::vector<double>& v, double q) { return v[static_cast<size_t>(q * (v.size() - 1))]; };
+    printf("stop: %d rounds, microseconds\n", rounds);
+    printf("%-28s %10s %10s %10s %10s\n", "", "min", "p50", "p99", "max");
+    printf("%-28s %10.0f %10.0f %10.0f %10.0f\n", "request -> loop exit", at(internal, 0), at(internal, 0.5), at(internal, 0.99), internal.back());
+    printf("%-28s %10.0f %10.0f %10.0f %10.0f\n", "request -> thread joined", at(external, 0), at(external, 0.5), at(external, 0.99), external.back());
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    std::string suite = argc > 1 ? argv[1] : "";
+
+    if (suite == "recv") return RunRecvBench(argc, argv);
+    if (suite == "buffers") return RunBuffersBench(argc, argv);
+    if (suite == "shards") return RunShardsBench(argc, argv);
+    if (suite == "multicast") return RunMulticastBench(argc, argv);
+    if (suite == "decode") return RunDecodeBench(argc, argv);
+    if (suite == "rules") return RunRulesBench(argc, argv);
+    if (suite == "parse") return RunParseBench(argc, argv);
+    if (suite == "vector") return RunVectorBench(argc, argv);
+    if (suite == "predicate") return RunPredicateBench(argc, argv);
+    if (suite == "patterns") return RunPatternsBench(argc, argv);
+    if (suite == "stop") return RunStopBench(argc, argv);
+    if (suite == "dispatch") return RunDispatchBench(argc, argv);
+    if (suite == "latency") return RunLatencyBench(argc, argv);
+    if (suite == "timetag") return RunTimetagBench(argc, argv);
+    if (suite == "repeat") return RunRepeatBench(argc, argv);
+    if (suite == "reload") return RunReloadBench(argc, argv);
+    if (suite == "large") return RunLargeBench(argc, argv);
+    if (suite == "tcp") return RunTcpBench(argc, argv);
+    if (suite == "relay") return RunRelayBench(argc, argv);
+    if (suite == "window") return RunWindowBench(argc, argv);
+    if (suite == "log") return RunLogBench(argc, argv);
+
+    printf("Usage: %s SUITE [options]\n"
+           "  recv [--packets N] [--batch N] [--burst N] [--rounds N] [--port P]\n"
+           "      Loopback UDP throughput, unbatched recvmsg() vs batched recvmmsg()\n"
+           "  buffers [--burst N] [--port P]\n"
+           "      Receive buffer sizes against a queued burst; fails if any loss isn't counted as a kernel drop\n"
+           "  shards [--packets N] [--senders N] [--max-shards N] [--port P]\n"
+           "      SO_REUSEPORT receive throughput with 1, 2, 4... shards\n"
+           "  multicast [--messages N] [--if6 IF] [--port P]\n"
+           "      Checks IPv4 and IPv6 group joins and dual-stack binding over this machine's loopback\n"
+           "  decode [--iterations N]\n"
+           "      Decodes a message carrying every OSC type; checks values and zero allocations\n"
+           "  rules [--iterations N]\n"
+           "      Per-message dispatch cost with 1 to 10000 rules loaded\n"
+           "  parse [--iterations N] [--bundle N] [--args N]\n"
+           "      ProcessOSCData/ProcessBundle/ProcessMessage over single, bundled, wide, non-matching\n"
+           "      and mixed int/float corpora; fails on any allocation\n"
+           "  vector [--iterations N]\n"
+           "      Checks vectorized argument decoding and any/all/channel predicates, then scalar vs\n"
+           "      vector byte-swap throughput and predicate cost on a 64-float message\n"
+           "  predicate [--iterations N]\n"
+           "      Checks ranges, strings, booleans, tolerances and AND/OR conditions, then the cost of\n"
+           "      each compiled predicate shape; fails on any allocation\n"
+           "  patterns [--iterations N] [--patterns N]\n"
+           "      Address-pattern dispatch, match cache off vs on\n"
+           "  dispatch [--messages N] [--sink-us N] [--port P]\n"
+           "      Receive-to-dispatch latency, and a matching burst against a slow sink\n"
+           "  latency [--messages N] [--gap-us N] [--sink-us N] [--port P]\n"
+           "      Per-stage p50/p99/p99.9/max from kernel receive timestamp to sink Fire()\n"
+           "  timetag [--messages N] [--lead-us N] [--gap-us N] [--port P]\n"
+           "      Checks bundle timetag scheduling, then firing jitter against the timetag\n"
+           "  repeat [--iterations N] [--hz N] [--hold N]\n"
+           "      Checks edge/hysteresis/interval/rate limits, then their cost on a repeating state stream\n"
+           "  reload [--messages N] [--rules N] [--port P]\n"
+           "      Checks rules files and table publishing, then reloads back to back under a loopback\n"
+           "      stream; fails if any datagram is lost\n"
+           "  large [--datagrams N] [--bytes N] [--port P]\n"
+           "      Checks bundles up to the UDP maximum arrive whole and oversized ones are counted, then\n"
+           "      large-bundle throughput, allocations and resident memory growth\n"
+           "  tcp [--messages N] [--clients N] [--chunk N] [--port P]\n"
+           "      Checks the length-prefix and SLIP de-framers and the connection limit, then stream\n"
+           "      throughput and allocations from 1 to N loopback clients (uses ports P and P+1)\n"
+           "  relay [--messages N] [--port P]\n"
+           "      Checks all/matched/unmatched relaying from UDP and TCP, then receive throughput and\n"
+           "      allocations relaying to 0, 1 and 3 loopback destinations (uses ports P to P+4)\n"
+           "  window [--iterations N] [--windows N]\n"
+           "      Checks target-window cache invalidation, then cached vs uncached resolve cost\n"
+           "  log [--iterations N]\n"
+           "      Engine cost with per-packet debug logging disabled vs enabled\n"
+           "  stop [--rounds N] [--idle SECONDS] [--port P]\n"
+           "      Idle listener CPU and stop-to-exit latency in microseconds\n", argv[0]);
+    return 1;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+
+// Receive buffers for one batch of datagrams, carved from a single
+// allocation made when the socket opens and reused by every receive call,
+// so the receive loop never allocates and memory stays at slots x size
+// however long a burst lasts. The allocation is never written up front:
+// the OS commits a slot's pages only as datagrams reach them, so a stream
+// of small datagrams costs about a page per slot even with room for the
+// largest.
+class ReceiveBufferPool {
+public:
+    static constexpr int kMaxDatagramBytes = 65535; // Largest UDP payload: 65527 over IPv6, 65507 over IPv4
+    static constexpr size_t kPageBytes = 4096;
+
+private:
+    std::unique_ptr<char[]> arena;
+    size_t slotBytes = 0; // Slot stride, rounded up to whole pages
+    int slots = 0;
+    int datagramBytes = 0;
+
+public:
+    void Allocate(int count, int maxDatagramBytes) {
+        datagramBytes = (std::max)(1, (std::min)(maxDatagramBytes, kMaxDatagramBytes));
+        slotBytes = (static_cast<size_t>(datagramBytes) + kPageBytes - 1) / kPageBytes * kPageBytes;
+        slots = (std::max)(1, count);
+        arena.reset(new char[slotBytes * slots]); // Not value-initialized, so nothing is committed yet
+    }
+
+    char* Slot(int index) const { return arena.get() + slotBytes * index; }
+
+    // Capacity of each slot; longer datagrams are truncated by the kernel.
+    int DatagramBytes() const { return datagramBytes; }
+
+    int Slots() const { return slots; }
+
+    size_t ReservedBytes() const { return slotBytes * slots; }
+};
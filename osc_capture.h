@@ -0,0 +1,225 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
+// Capture file format, all integers little-endian:
+//
+//   file header  "OSCCAP01" (8 bytes)
+//   record       uint64 receive time (ns, monotonic; only deltas matter)
+//                uint16 payload length
+//                uint8  address family (4 or 6)
+//                uint8  receive endpoint index (0 = --ip/--port)
+//                uint16 source port
+//                4 or 16 bytes source address
+//                payload
+//
+// Records are written back to back with no padding, so a capture costs
+// 18 bytes of overhead per IPv4 datagram.
+
+static const char kCaptureMagic[8] = {'O', 'S', 'C', 'C', 'A', 'P', '0', '1'};
+
+struct CaptureSource {
+    uint8_t family = 0; // 4, 6, or 0 when unknown
+    uint16_t port = 0;
+    uint8_t address[16] = {};
+
+    static CaptureSource From(const sockaddr_in& addr) {
+        CaptureSource source;
+        source.family = 4;
+        source.port = ntohs(addr.sin_port);
+        memcpy(source.address, &addr.sin_addr, 4);
+        return source;
+    }
+
+    static CaptureSource From(const sockaddr_in6& addr) {
+        CaptureSource source;
+        source.family = 6;
+        source.port = ntohs(addr.sin6_port);
+        memcpy(source.address, &addr.sin6_addr, 16);
+        return source;
+    }
+
+    // A recvmsg() source of either family.
+    static CaptureSource From(const sockaddr_storage& addr) {
+        if (addr.ss_family == AF_INET6) {
+            sockaddr_in6 v6;
+            memcpy(&v6, &addr, sizeof(v6));
+            return From(v6);
+        } else if (addr.ss_family == AF_INET) {
+            sockaddr_in v4;
+            memcpy(&v4, &addr, sizeof(v4));
+            return From(v4);
+        }
+        return CaptureSource();
+    }
+
+    std::string ToString() const {
+        char text[64];
+        if (family == 4) {
+            snprintf(text, sizeof(text), "%u.%u.%u.%u:%u", address[0], address[1], address[2], address[3], port);
+        } else if (family == 6) {
+            int n = 0;
+            text[n++] = '[';
+            for (int i = 0; i < 16; i += 2) {
+                n += snprintf(text + n, sizeof(text) - n, i ? ":%x" : "%x", (address[i] << 8) | address[i + 1]);
+            }
+            snprintf(text + n, sizeof(text) - n, "]:%u", port);
+        } else {
+            return "unknown";
+        }
+        return text;
+    }
+};
+
+// Appends received datagrams to a capture file through a large in-memory
+// buffer, so the listener thread only touches the file once per buffer.
+class CaptureWriter {
+private:
+    static const size_t kBufferSize = 1 << 20;
+
+    FILE* file = nullptr;
+    std::vector<char> buffer;
+    size_t used = 0;
+    uint64_t records = 0;
+    uint64_t bytes = 0;
+
+    void Put(const void* data, size_t size) {
+        memcpy(buffer.data() + used, data, size);
+        used += size;
+    }
+
+    void PutLE(uint64_t value, int size) {
+        for (int i = 0; i < size; i++) {
+            buffer[used++] = static_cast<char>(value >> (8 * i));
+        }
+    }
+
+public:
+    ~CaptureWriter() { Close(); }
+
+    bool Open(const std::string& path) {
+        Close();
+        file = fopen(path.c_str(), "wb");
+        if (!file) return false;
+        buffer.resize(kBufferSize);
+        used = 0;
+        records = bytes = 0;
+        Put(kCaptureMagic, sizeof(kCaptureMagic));
+        return true;
+    }
+
+    bool IsOpen() const { return file != nullptr; }
+
+    void Write(uint64_t receivedNs, const CaptureSource& source, const char* data, int length, int endpoint = 0) {
+        if (!file || length < 0 || length > 0xFFFF) return;
+        size_t addressSize = source.family == 6 ? 16 : 4;
+        size_t recordSize = 14 + addressSize + length;
+        if (used + recordSize > buffer.size()) Flush();
+
+        PutLE(receivedNs, 8);
+        PutLE(static_cast<uint64_t>(length), 2);
+        PutLE(source.family, 1);
+        PutLE(static_cast<uint64_t>(endpoint), 1);
+        PutLE(source.port, 2);
+        Put(source.address, addressSize);
+        Put(data, length);
+        records++;
+        bytes += recordSize;
+    }
+
+    void Flush() {
+        if (file && used > 0) {
+            fwrite(buffer.data(), 1, used, file);
+            used = 0;
+        }
+    }
+
+    void Close() {
+        if (!file) return;
+        Flush();
+        fclose(file);
+        file = nullptr;
+    }
+
+    uint64_t Records() const { return records; }
+    uint64_t Bytes() const { return bytes; }
+};
+
+struct CaptureRecord {
+    uint64_t receivedNs = 0;
+    CaptureSource source;
+    int endpoint = 0;
+    const char* data = nullptr; // Points into the reader's copy of the file
+    int length = 0;
+};
+
+// Loads a whole capture into memory and walks it record by record, so
+// replay measures the engine rather than the disk.
+class CaptureReader {
+private:
+    std::vector<char> contents;
+    size_t pos = 0;
+
+    uint64_t GetLE(size_t at, int size) const {
+        uint64_t value = 0;
+        for (int i = 0; i < size; i++) {
+            value |= static_cast<uint64_t>(static_cast<uint8_t>(contents[at + i])) << (8 * i);
+        }
+        return value;
+    }
+
+public:
+    bool Open(const std::string& path, std::string& error) {
+        FILE* file = fopen(path.c_str(), "rb");
+        if (!file) {
+            error = "Cannot open capture: " + path;
+            return false;
+        }
+        contents.clear();
+        char chunk[65536];
+        size_t n;
+        while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+            contents.insert(contents.end(), chunk, chunk + n);
+        }
+        fclose(file);
+
+        if (contents.size() < sizeof(kCaptureMagic) || memcmp(contents.data(), kCaptureMagic, sizeof(kCaptureMagic)) != 0) {
+            error = "Not a capture file: " + path;
+            return false;
+        }
+        Rewind();
+        return true;
+    }
+
+    void Rewind() { pos = sizeof(kCaptureMagic); }
+
+    // False at the end of the file or at a truncated final record.
+    bool Next(CaptureRecord& record) {
+        if (pos + 14 > contents.size()) return false;
+        record.receivedNs = GetLE(pos, 8);
+        record.length = static_cast<int>(GetLE(pos + 8, 2));
+        record.source.family = static_cast<uint8_t>(GetLE(pos + 10, 1));
+        record.endpoint = static_cast<int>(GetLE(pos + 11, 1));
+        record.source.port = static_cast<uint16_t>(GetLE(pos + 12, 2));
+        size_t addressSize = record.source.family == 6 ? 16 : 4;
+        if (pos + 14 + addressSize + record.length > contents.size()) return false;
+
+        memcpy(record.source.address, contents.data() + pos + 14, addressSize);
+        record.data = contents.data() + pos + 14 + addressSize;
+        pos += 14 + addressSize + record.length;
+        return true;
+    }
+
+    size_t SizeBytes() const { return contents.size(); }
+};
@@ -0,0 +1,271 @@
+#pragma once
+
+#include "osc_simd.h"
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// Zero-copy OSC 1.0/1.1 message decoder. Everything here points back into the
+// caller's datagram buffer; nothing is copied and nothing touches the heap.
+
+inline uint32_t ReadBigEndian32(const char* p) {
+    return (static_cast<uint32_t>(static_cast<uint8_t>(p[0])) << 24) |
+           (static_cast<uint32_t>(static_cast<uint8_t>(p[1])) << 16) |
+           (static_cast<uint32_t>(static_cast<uint8_t>(p[2])) << 8) |
+           static_cast<uint32_t>(static_cast<uint8_t>(p[3]));
+}
+
+inline uint64_t ReadBigEndian64(const char* p) {
+    return (static_cast<uint64_t>(ReadBigEndian32(p)) << 32) | ReadBigEndian32(p + 4);
+}
+
+// OSC timetags are NTP timestamps: seconds since 1900 in the high 32 bits,
+// fractions of a second in the low 32. The value 1 means "immediately".
+static const uint64_t kTimetagImmediate = 1;
+static const int64_t kNtpUnixOffsetSeconds = 2208988800LL; // 1900 -> 1970
+
+inline int64_t TimetagToUnixNs(uint64_t timetag) {
+    int64_t seconds = static_cast<int64_t>(timetag >> 32) - kNtpUnixOffsetSeconds;
+    uint64_t fractionNs = ((timetag & 0xFFFFFFFFull) * 1000000000ull) >> 32;
+    return seconds * 1000000000LL + static_cast<int64_t>(fractionNs);
+}
+
+inline uint64_t UnixNsToTimetag(int64_t unixNs) {
+    uint64_t seconds = static_cast<uint64_t>(unixNs / 1000000000LL + kNtpUnixOffsetSeconds);
+    uint64_t fraction = (static_cast<uint64_t>(unixNs % 1000000000LL) << 32) / 1000000000ull;
+    return (seconds << 32) | fraction;
+}
+
+// Length of a null-terminated, 4-byte padded OSC string starting at data,
+// or -1 if the terminator is missing inside [data, data + available).
+inline int PaddedStringSize(const char* data, int available) {
+    if (available <= 0) return -1;
+    const char* end = static_cast<const char*>(memchr(data, 0, available));
+    if (!end) return -1;
+    int size = static_cast<int>(end - data) + 1;
+    size = (size + 3) & ~3;
+    return size <= available ? size : -1;
+}
+
+// One decoded argument. Only the member matching `type` is meaningful.
+struct OSCArgument {
+    char type = 0;        // OSC type tag character
+    int index = 0;        // Position among value-bearing arguments (array brackets don't count)
+    int arrayDepth = 0;   // Nesting level inside [ ] arrays
+
+    int32_t intValue = 0;       // i, and c as a code point
+    int64_t longValue = 0;      // h
+    float floatValue = 0;       // f
+    double doubleValue = 0;     // d
+    uint64_t timetag = 0;       // t
+    uint32_t rgba = 0;          // r
+    uint8_t midi[4] = {0, 0, 0, 0}; // m: port id, status, data1, data2
+    bool boolValue = false;     // T / F
+    std::string_view stringValue; // s, S
+    const uint8_t* blobData = nullptr; // b
+    int blobSize = 0;
+
+    bool IsNumeric() const {
+        return type == 'i' || type == 'f' || type == 'h' || type == 'd';
+    }
+
+    bool IsInteger() const { return type == 'i' || type == 'h'; }
+
+    // Numeric view of i/f/h/d and T/F as 1/0; false for anything else.
+    bool AsDouble(double& out) const {
+        switch (type) {
+        case 'i': out = intValue; return true;
+        case 'h': out = static_cast<double>(longValue); return true;
+        case 'f': out = floatValue; return true;
+        case 'd': out = doubleValue; return true;
+        case 'T': out = 1; return true;
+        case 'F': out = 0; return true;
+        default: return false;
+        }
+    }
+};
+
+class OSCMessageView {
+private:
+    const char* data;
+    int length;
+    std::string_view address;
+    std::string_view typeTags; // Without the leading ','
+    int argumentsPos;
+
+public:
+    OSCMessageView() : data(nullptr), length(0), argumentsPos(0) {}
+
+    // Validates the address and type tag string. Messages without a type tag
+    // string (pre-1.0 senders) parse with no arguments.
+    bool Parse(const char* message, int messageLength) {
+        data = message;
+        length = messageLength;
+        typeTags = std::string_view();
+        if (length < 4 || data[0] != '/') return false;
+
+        int addressSize = PaddedStringSize(data, length);
+        if (addressSize < 0) return false;
+        address = std::string_view(data, strlen(data));
+
+        argumentsPos = addressSize;
+        if (addressSize >= length || data[addressSize] != ',') {
+            return true;
+        }
+
+        int tagSize = PaddedStringSize(data + addressSize, length - addressSize);
+        if (tagSize < 0) return false;
+        typeTags = std::string_view(data + addressSize + 1, strlen(data + addressSize) - 1);
+        argumentsPos = addressSize + tagSize;
+        return true;
+    }
+
+    std::string_view Address() const { return address; }
+    std::string_view TypeTags() const { return typeTags; }
+
+    // Walks the arguments in order. Next() returns false at the end or as
+    // soon as an argument would run past the datagram.
+    class Iterator {
+    private:
+        const char* data;
+        int length;
+        std::string_view tags;
+        size_t tagPos;
+        int pos;
+        int index;
+        int depth;
+
+    public:
+        Iterator(const char* d, int len, std::string_view t, int start)
+            : data(d), length(len), tags(t), tagPos(0), pos(start), index(0), depth(0) {}
+
+        bool Next(OSCArgument& arg) {
+            while (tagPos < tags.size()) {
+                char type = tags[tagPos++];
+                if (type == '[') { depth++; continue; }
+                if (type == ']') { if (depth > 0) depth--; continue; }
+
+                arg.type = type;
+                arg.index = index++;
+                arg.arrayDepth = depth;
+                int remaining = length - pos;
+                const char* p = data + pos;
+
+                switch (type) {
+                case 'i':
+                    if (remaining < 4) return false;
+                    arg.intValue = static_cast<int32_t>(ReadBigEndian32(p));
+                    pos += 4;
+                    return true;
+                case 'f': {
+                    if (remaining < 4) return false;
+                    uint32_t raw = ReadBigEndian32(p);
+                    memcpy(&arg.floatValue, &raw, sizeof(raw));
+                    pos += 4;
+                    return true;
+                }
+                case 'c':
+                    if (remaining < 4) return false;
+                    arg.intValue = static_cast<int32_t>(ReadBigEndian32(p));
+                    pos += 4;
+                    return true;
+                case 'r':
+                    if (remaining < 4) return false;
+                    arg.rgba = ReadBigEndian32(p);
+                    pos += 4;
+                    return true;
+                case 'm':
+                    if (remaining < 4) return false;
+                    memcpy(arg.midi, p, 4);
+                    pos += 4;
+                    return true;
+                case 'h':
+                    if (remaining < 8) return false;
+                    arg.longValue = static_cast<int64_t>(ReadBigEndian64(p));
+                    pos += 8;
+                    return true;
+                case 'd': {
+                    if (remaining < 8) return false;
+                    uint64_t raw = ReadBigEndian64(p);
+                    memcpy(&arg.doubleValue, &raw, sizeof(raw));
+                    pos += 8;
+                    return true;
+                }
+                case 't':
+                    if (remaining < 8) return false;
+                    arg.timetag = ReadBigEndian64(p);
+                    pos += 8;
+                    return true;
+                case 's':
+                case 'S': {
+                    int size = PaddedStringSize(p, remaining);
+                    if (size < 0) return false;
+                    arg.stringValue = std::string_view(p, strlen(p));
+                    pos += size;
+                    return true;
+                }
+                case 'b': {
+                    if (remaining < 4) return false;
+                    uint32_t size = ReadBigEndian32(p);
+                    uint32_t padded = (size + 3) & ~3u;
+                    if (size > padded || padded > static_cast<uint32_t>(remaining - 4)) return false; // size > padded only on overflow
+                    arg.blobData = reinterpret_cast<const uint8_t*>(p + 4);
+                    arg.blobSize = static_cast<int>(size);
+                    pos += 4 + static_cast<int>(padded);
+                    return true;
+                }
+                case 'T':
+                case 'F':
+                    arg.boolValue = (type == 'T');
+                    return true;
+                case 'N':
+                case 'I':
+                    return true;
+                default:
+                    return false; // Unknown tag: its size is unknown, so stop here
+                }
+            }
+            return false;
+        }
+    };
+
+    Iterator Arguments() const { return Iterator(data, length, typeTags, argumentsPos); }
+
+    // Decodes a message whose arguments are all 'i' and 'f' (array brackets
+    // allowed) in one vectorized pass: words[k] holds flat argument k as a
+    // native-endian word and types[k] its tag. Returns the argument count,
+    // or -1 if the message has other types, runs past the datagram or has
+    // more than capacity arguments; walk it with Arguments() instead.
+    int ReadWords(uint32_t* words, char* types, int capacity) const {
+        int count = 0;
+        if (typeTags.size() <= static_cast<size_t>(capacity) && !memchr(typeTags.data(), '[', typeTags.size())) {
+            // No arrays: check every tag without branching, then copy them
+            bool other = false;
+            for (char type : typeTags) other |= (type != 'i') & (type != 'f');
+            if (other) return -1;
+            count = static_cast<int>(typeTags.size());
+            memcpy(types, typeTags.data(), typeTags.size());
+        } else {
+            for (char type : typeTags) {
+                if (type == 'i' || type == 'f') {
+                    if (count == capacity) return -1;
+                    types[count++] = type;
+                } else if (type != '[' && type != ']') {
+                    return -1;
+                }
+            }
+        }
+        if (count > (length - argumentsPos) / 4) return -1;
+        ByteSwap32Run(data + argumentsPos, words, count);
+        return count;
+    }
+
+    // Finds the argument at a flat index, decoding only what precedes it.
+    bool GetArgument(int index, OSCArgument& arg) const {
+        Iterator it = Arguments();
+        while (it.Next(arg)) {
+            if (arg.index == index) return true;
+        }
+        return false;
+    }
+};
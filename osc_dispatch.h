@@ -0,0 +1,316 @@
+#pragma once
+
+#include "osc_engine.h"
+#include "osc_histogram.h"
+#include "osc_queue.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <windows.h>
+#include <timeapi.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+// Where matched triggers end up: key injection, a virtual keyboard, or a
+// recorder. Fire() runs on the dispatcher's worker thread, never on the
+// listener thread, so a slow sink delays actions but not packet reads.
+class ActionSink {
+public:
+    virtual ~ActionSink() {}
+    virtual void Fire(const TriggerRule& rule) = 0;
+};
+
+// A matched trigger waiting for the worker. rule points into one of the
+// engine's published rule tables, which stays allocated until Idle() says
+// no action can still be waiting on it.
+struct TriggerAction {
+    const TriggerRule* rule = nullptr;
+    uint64_t receivedNs = 0; // SteadyNowNs() when the datagram was read
+    uint64_t queuedNs = 0;   // When Submit() ran; only set while latency stats are on
+    uint64_t dueNs = 0;      // Bundle timetag on the SteadyNowNs() clock, 0 = fire now
+};
+
+struct DispatchStats {
+    uint64_t submitted = 0;
+    uint64_t dispatched = 0;
+    uint64_t dropped = 0;      // Queue was full
+    size_t depth = 0;          // Actions waiting right now
+    size_t maxDepth = 0;
+    double avgLatencyUs = 0;   // Datagram read -> sink Fire(), over unscheduled actions
+    double maxLatencyUs = 0;
+    uint64_t scheduled = 0;    // Fired at a bundle timetag rather than on arrival
+    uint64_t cancelled = 0;    // Still waiting for their timetag at Stop()
+    size_t pending = 0;        // Waiting for their timetag right now
+    double jitterP50Us = 0;    // Fire time - timetag, over scheduled actions
+    double jitterP99Us = 0;
+    double jitterMaxUs = 0;
+};
+
+// Moves sink calls off the listener thread. Submit() is lock-free; the
+// worker sleeps on a condition variable only when the queue is empty, so
+// producers take the mutex only to wake it. Actions from future-dated
+// bundles wait in a min-heap owned by the worker, which sleeps until just
+// before the earliest is due and spins the rest of the way, since a timed
+// wait alone can overshoot by a scheduler tick. On Windows the worker asks
+// for a 1 ms tick while actions are waiting, so the spin stays that short
+// instead of covering the default 15.6 ms tick.
+class ActionDispatcher {
+private:
+#ifdef _WIN32
+    static const uint64_t kSpinNs = 2000000; // Two ticks at the 1 ms period held while timers wait
+#else
+    static const uint64_t kSpinNs = 200000;
+#endif
+
+    MpscQueue<TriggerAction> queue;
+    std::vector<TriggerAction> timers; // Min-heap on dueNs; worker thread only
+    size_t timerCapacity;
+    ActionSink* sink = nullptr;
+    LatencyStats* latencyStats = nullptr;
+    std::thread worker;
+    std::atomic<bool> running{false};
+    std::atomic<bool> sleeping{false};
+    std::atomic<bool> cancelScheduled{true};
+    bool fineTicks = false; // timeBeginPeriod(1) is held; worker thread only
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+    std::function<void()> idleTask; // See WhenIdle(); guarded by wakeMutex
+
+    std::atomic<uint64_t> submitted{0};
+    std::atomic<uint64_t> dispatched{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<size_t> maxDepth{0};
+    std::atomic<uint64_t> latencySumNs{0};
+    std::atomic<uint64_t> latencyMaxNs{0};
+    std::atomic<uint64_t> scheduled{0};
+    std::atomic<uint64_t> cancelled{0};
+    std::atomic<size_t> pending{0};
+    std::atomic<uint64_t> outstanding{0}; // Submitted and not yet delivered, dropped or cancelled
+    LatencyHistogram jitter;
+
+    static bool DueLater(const TriggerAction& a, const TriggerAction& b) { return a.dueNs > b.dueNs; }
+
+    // Raises the Windows scheduler tick to 1 ms while hold is set. It costs
+    // power system-wide, so it is held only while timers are pending.
+    void HoldFineTicks(bool hold) {
+        if (hold == fineTicks) return;
+        fineTicks = hold;
+#ifdef _WIN32
+        if (hold) timeBeginPeriod(1);
+        else timeEndPeriod(1);
+#endif
+    }
+
+    void Wake() {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        wakeCondition.notify_one();
+    }
+
+    void WorkerLoop() {
+        TriggerAction action;
+        for (;;) {
+            if (queue.TryPop(action)) {
+                if (action.dueNs > SteadyNowNs()) {
+                    Schedule(action);
+                } else {
+                    Deliver(action);
+                    outstanding.fetch_sub(1, std::memory_order_release);
+                }
+                if (!timers.empty()) FireDueTimers();
+                continue;
+            }
+            uint64_t nextDueNs = FireDueTimers();
+            if (!running && (timers.empty() || cancelScheduled)) break; // Stop() drains what was queued first
+
+            HoldFineTicks(nextDueNs != 0);
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            if (idleTask && Idle()) {
+                std::function<void()> task = std::move(idleTask);
+                idleTask = nullptr;
+                lock.unlock();
+                task();
+                continue;
+            }
+            sleeping = true;
+            if (queue.Empty() && (running || !timers.empty())) {
+                if (nextDueNs == 0) {
+                    wakeCondition.wait(lock);
+                } else {
+                    wakeCondition.wait_until(lock, std::chrono::steady_clock::time_point(
+                        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(nextDueNs - kSpinNs))));
+                }
+            }
+            sleeping = false;
+        }
+        cancelled.fetch_add(timers.size(), std::memory_order_relaxed);
+        outstanding.fetch_sub(timers.size(), std::memory_order_release);
+        timers.clear();
+        pending = 0;
+        HoldFineTicks(false);
+    }
+
+    void Schedule(const TriggerAction& action) {
+        if (timers.size() >= timerCapacity) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            outstanding.fetch_sub(1, std::memory_order_release);
+            return;
+        }
+        timers.push_back(action);
+        std::push_heap(timers.begin(), timers.end(), DueLater);
+        pending = timers.size();
+    }
+
+    // Delivers every timer due within the spin window, spinning out the
+    // last stretch. Returns the next due time, or 0 when none are left.
+    uint64_t FireDueTimers() {
+        while (!timers.empty()) {
+            uint64_t due = timers.front().dueNs;
+            uint64_t now = SteadyNowNs();
+            if (due > now + kSpinNs) return due;
+            while (now < due) {
+                std::this_thread::yield();
+                now = SteadyNowNs();
+            }
+            std::pop_heap(timers.begin(), timers.end(), DueLater);
+            TriggerAction action = timers.back();
+            timers.pop_back();
+            pending = timers.size();
+            Deliver(action);
+            outstanding.fetch_sub(1, std::memory_order_release);
+        }
+        return 0;
+    }
+
+    // Scheduled actions are timed against their timetag instead: their
+    // wait is intended, so it stays out of the receive-to-dispatch and
+    // stage latencies.
+    void Deliver(const TriggerAction& action) {
+        uint64_t now = SteadyNowNs();
+        if (action.dueNs) {
+            jitter.Record(now - action.dueNs);
+            scheduled.fetch_add(1, std::memory_order_relaxed);
+            sink->Fire(*action.rule);
+            dispatched.fetch_add(1, std::memory_order_relaxed);
+            if (latencyStats) latencyStats->Record(StageInject, SteadyNowNs() - now);
+            return;
+        }
+
+        uint64_t latency = now - action.receivedNs;
+        latencySumNs.fetch_add(latency, std::memory_order_relaxed);
+        uint64_t previousMax = latencyMaxNs.load(std::memory_order_relaxed);
+        if (latency > previousMax) latencyMaxNs.store(latency, std::memory_order_relaxed);
+
+        sink->Fire(*action.rule);
+        dispatched.fetch_add(1, std::memory_order_relaxed);
+
+        if (latencyStats) {
+            uint64_t done = SteadyNowNs();
+            latencyStats->Record(StageDispatch, now - action.queuedNs);
+            latencyStats->Record(StageInject, done - now);
+            latencyStats->Record(StageTotal, done - action.receivedNs);
+        }
+    }
+
+public:
+    explicit ActionDispatcher(size_t capacity = 1024) : queue(capacity), timerCapacity(capacity) {
+        timers.reserve(capacity);
+    }
+    ~ActionDispatcher() { Stop(); }
+
+    // With stats set, each delivery records its dispatch, inject and total
+    // stages there.
+    void Start(ActionSink& actionSink, LatencyStats* stats = nullptr) {
+        Stop();
+        sink = &actionSink;
+        latencyStats = stats;
+        submitted = dispatched = dropped = 0;
+        maxDepth = 0;
+        latencySumNs = latencyMaxNs = 0;
+        scheduled = cancelled = 0;
+        pending = 0;
+        jitter.Reset();
+        cancelScheduled = true;
+        running = true;
+        worker = std::thread([this] { WorkerLoop(); });
+    }
+
+    // Delivers everything already queued, then joins the worker. Actions
+    // still waiting for their timetag are dropped, or with cancel false,
+    // fired on time before this returns.
+    void Stop(bool cancel = true) {
+        if (!worker.joinable()) return;
+        cancelScheduled = cancel;
+        running = false;
+        Wake();
+        worker.join();
+        idleTask = nullptr;
+    }
+
+    // Runs task on the worker thread once no action submitted before this
+    // call is still held here, without blocking the caller. Replaces a
+    // task that hasn't run yet; one still waiting at Stop() never runs.
+    void WhenIdle(std::function<void()> task) {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        idleTask = std::move(task);
+        wakeCondition.notify_one();
+    }
+
+    // Returns false (and counts a drop) if the queue is full. A dueNs in
+    // the future holds the action until then.
+    bool Submit(const TriggerRule& rule, uint64_t receivedNs, uint64_t dueNs = 0) {
+        TriggerAction action;
+        action.rule = &rule;
+        action.receivedNs = receivedNs;
+        action.dueNs = dueNs;
+        if (latencyStats) action.queuedNs = SteadyNowNs();
+        submitted.fetch_add(1, std::memory_order_relaxed);
+        outstanding.fetch_add(1, std::memory_order_relaxed);
+        if (!queue.TryPush(action)) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            outstanding.fetch_sub(1, std::memory_order_release);
+            return false;
+        }
+
+        size_t depth = queue.Size();
+        if (depth > maxDepth.load(std::memory_order_relaxed)) maxDepth.store(depth, std::memory_order_relaxed);
+
+        if (sleeping) Wake();
+        return true;
+    }
+
+    size_t Depth() const { return queue.Size(); }
+
+    // True when every submitted action has been delivered, dropped or
+    // cancelled, so no rule pointer is still held here.
+    bool Idle() const { return outstanding.load(std::memory_order_acquire) == 0; }
+
+    DispatchStats GetStats() const {
+        DispatchStats stats;
+        stats.submitted = submitted.load(std::memory_order_relaxed);
+        stats.dispatched = dispatched.load(std::memory_order_relaxed);
+        stats.dropped = dropped.load(std::memory_order_relaxed);
+        stats.depth = queue.Size();
+        stats.maxDepth = maxDepth.load(std::memory_order_relaxed);
+        stats.scheduled = scheduled.load(std::memory_order_relaxed);
+        if (stats.dispatched > stats.scheduled) {
+            stats.avgLatencyUs = latencySumNs.load(std::memory_order_relaxed) / 1e3 / (stats.dispatched - stats.scheduled);
+        }
+        stats.maxLatencyUs = latencyMaxNs.load(std::memory_order_relaxed) / 1e3;
+        stats.cancelled = cancelled.load(std::memory_order_relaxed);
+        stats.pending = pending.load(std::memory_order_relaxed);
+        stats.jitterP50Us = jitter.PercentileNs(0.5) / 1e3;
+        stats.jitterP99Us = jitter.PercentileNs(0.99) / 1e3;
+        stats.jitterMaxUs = jitter.MaxNs() / 1e3;
+        return stats;
+    }
+};
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Log-linear latency histogram in nanoseconds, HDR style: every power of two
+// is split into 32 linear sub-buckets, so any recorded value is reported
+// within about 3%. Fixed size, no allocation; Record() is a couple of
+// relaxed atomic adds and may be called from any number of threads.
+class LatencyHistogram {
+public:
+    static const int kSubBits = 5;
+    static const int kSubBuckets = 1 << kSubBits;
+    static const int kMaxExponent = 40; // ~18 minutes; larger values land in the last bucket
+    static const int kBuckets = (kMaxExponent - kSubBits + 1) * kSubBuckets;
+
+private:
+    std::atomic<uint64_t> counts[kBuckets];
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> maxNs{0};
+
+    static int BucketIndex(uint64_t ns) {
+        if (ns < kSubBuckets) return static_cast<int>(ns);
+        int exponent = 63 - CountLeadingZeros(ns);
+        if (exponent >= kMaxExponent) return kBuckets - 1;
+        int sub = static_cast<int>((ns >> (exponent - kSubBits)) & (kSubBuckets - 1));
+        return (exponent - kSubBits + 1) * kSubBuckets + sub;
+    }
+
+    // Highest value that maps to a bucket, so percentiles never under-report.
+    static uint64_t BucketUpperBound(int index) {
+        if (index < kSubBuckets) return static_cast<uint64_t>(index);
+        int exponent = index / kSubBuckets + kSubBits - 1;
+        uint64_t sub = static_cast<uint64_t>(index % kSubBuckets) | kSubBuckets;
+        int shift = exponent - kSubBits;
+        return ((sub + 1) << shift) - 1;
+    }
+
+    static int CountLeadingZeros(uint64_t value) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        return 63 - static_cast<int>(index);
+#else
+        return __builtin_clzll(value);
+#endif
+    }
+
+public:
+    LatencyHistogram() { Reset(); }
+
+    void Record(uint64_t ns) {
+        counts[BucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        uint64_t previous = maxNs.load(std::memory_order_relaxed);
+        while (ns > previous && !maxNs.compare_exchange_weak(previous, ns, std::memory_order_relaxed)) {}
+    }
+
+    void Reset() {
+        for (std::atomic<uint64_t>& count : counts) count.store(0, std::memory_order_relaxed);
+        total.store(0, std::memory_order_relaxed);
+        maxNs.store(0, std::memory_order_relaxed);
+    }
+
+    uint64_t Count() const { return total.load(std::memory_order_relaxed); }
+    uint64_t MaxNs() const { return maxNs.load(std::memory_order_relaxed); }
+
+    // Smallest bucket bound covering the given fraction (0.5, 0.99, ...) of
+    // samples. Safe to call while writers are recording.
+    uint64_t PercentileNs(double fraction) const {
+        uint64_t count = Count();
+        if (count == 0) return 0;
+        uint64_t target = static_cast<uint64_t>(fraction * count + 0.5);
+        if (target < 1) target = 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < kBuckets; i++) {
+            seen += counts[i].load(std::memory_order_relaxed);
+            if (seen >= target) {
+                uint64_t bound = BucketUpperBound(i);
+                uint64_t max = MaxNs();
+                return bound < max ? bound : max;
+            }
+        }
+        return MaxNs();
+    }
+};
+
+// The stages a cue passes through between the NIC and the key press.
+enum LatencyStage : int {
+    StageReceive,  // Kernel receive timestamp -> datagram read by the listener (Linux only)
+    StageParse,    // OSC message decode
+    StageMatch,    // Rule lookup, argument compare and enqueue
+    StageDispatch, // Queued -> picked up by the dispatcher worker
+    StageInject,   // Sink Fire(), e.g. window focus and key injection
+    StageTotal,    // Kernel receive (or read, without kernel timestamps) -> Fire() returned
+    StageCount
+};
+
+inline const char* LatencyStageName(LatencyStage stage) {
+    switch (stage) {
+    case StageReceive: return "receive";
+    case StageParse: return "parse";
+    case StageMatch: return "match";
+    case StageDispatch: return "dispatch";
+    case StageInject: return "inject";
+    default: return "total";
+    }
+}
+
+// One histogram per stage, shared by the listener, engine and dispatcher.
+struct LatencyStats {
+    LatencyHistogram stages[StageCount];
+
+    void Record(LatencyStage stage, uint64_t ns) { stages[stage].Record(ns); }
+
+    void Reset() {
+        for (LatencyHistogram& histogram : stages) histogram.Reset();
+    }
+
+    // "parse     n=1200  p50 0.1 us  p99 0.3 us  p99.9 0.6 us  max 4.2 us"
+    std::string FormatStage(LatencyStage stage) const {
+        const LatencyHistogram& h = stages[stage];
+        char line[160];
+        snprintf(line, sizeof(line), "%-9s n=%-8llu p50 %.1f us  p99 %.1f us  p99.9 %.1f us  max %.1f us",
+                 LatencyStageName(stage), (unsigned long long)h.Count(), h.PercentileNs(0.5) / 1e3,
+                 h.PercentileNs(0.99) / 1e3, h.PercentileNs(0.999) / 1e3, h.MaxNs() / 1e3);
+        return line;
+    }
+};
@@ -0,0 +1,150 @@
+#pragma once
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <windows.h>
+#pragma comment(lib, "user32.lib")
+#endif
+#include <algorithm>
+#include <cctype>
+#include <string>
+
+#ifndef _WIN32
+// Virtual-key codes used by the key parser. Values match the Win32 VK_*
+// constants so a Config means the same thing on every platform.
+#define VK_BACK     0x08
+#define VK_TAB      0x09
+#define VK_RETURN   0x0D
+#define VK_SHIFT    0x10
+#define VK_CONTROL  0x11
+#define VK_MENU     0x12
+#define VK_ESCAPE   0x1B
+#define VK_SPACE    0x20
+#define VK_PRIOR    0x21
+#define VK_NEXT     0x22
+#define VK_END      0x23
+#define VK_HOME     0x24
+#define VK_LEFT     0x25
+#define VK_UP       0x26
+#define VK_RIGHT    0x27
+#define VK_DOWN     0x28
+#define VK_INSERT   0x2D
+#define VK_DELETE   0x2E
+#define VK_NUMPAD0  0x60
+#define VK_NUMPAD1  0x61
+#define VK_NUMPAD2  0x62
+#define VK_NUMPAD3  0x63
+#define VK_NUMPAD4  0x64
+#define VK_NUMPAD5  0x65
+#define VK_NUMPAD6  0x66
+#define VK_NUMPAD7  0x67
+#define VK_NUMPAD8  0x68
+#define VK_NUMPAD9  0x69
+#define VK_F1       0x70
+#define VK_F2       0x71
+#define VK_F3       0x72
+#define VK_F4       0x73
+#define VK_F5       0x74
+#define VK_F6       0x75
+#define VK_F7       0x76
+#define VK_F8       0x77
+#define VK_F9       0x78
+#define VK_F10      0x79
+#define VK_F11      0x7A
+#define VK_F12      0x7B
+#endif
+
+inline int StringToVK(const std::string& key) {
+    // Basic keys
+    if (key == "SPACE") return VK_SPACE;
+    if (key == "ENTER") return VK_RETURN;
+    if (key == "TAB") return VK_TAB;
+    if (key == "ESC" || key == "ESCAPE") return VK_ESCAPE;
+    if (key == "BACKSPACE") return VK_BACK;
+    if (key == "DELETE") return VK_DELETE;
+    if (key == "INSERT") return VK_INSERT;
+    if (key == "HOME") return VK_HOME;
+    if (key == "END") return VK_END;
+    if (key == "PAGEUP") return VK_PRIOR;
+    if (key == "PAGEDOWN") return VK_NEXT;
+
+    // Function keys
+    if (key == "F1") return VK_F1;
+    if (key == "F2") return VK_F2;
+    if (key == "F3") return VK_F3;
+    if (key == "F4") return VK_F4;
+    if (key == "F5") return VK_F5;
+    if (key == "F6") return VK_F6;
+    if (key == "F7") return VK_F7;
+    if (key == "F8") return VK_F8;
+    if (key == "F9") return VK_F9;
+    if (key == "F10") return VK_F10;
+    if (key == "F11") return VK_F11;
+    if (key == "F12") return VK_F12;
+
+    // Arrow keys
+    if (key == "LEFT") return VK_LEFT;
+    if (key == "RIGHT") return VK_RIGHT;
+    if (key == "UP") return VK_UP;
+    if (key == "DOWN") return VK_DOWN;
+
+    // Number pad
+    if (key == "NUM0") return VK_NUMPAD0;
+    if (key == "NUM1") return VK_NUMPAD1;
+    if (key == "NUM2") return VK_NUMPAD2;
+    if (key == "NUM3") return VK_NUMPAD3;
+    if (key == "NUM4") return VK_NUMPAD4;
+    if (key == "NUM5") return VK_NUMPAD5;
+    if (key == "NUM6") return VK_NUMPAD6;
+    if (key == "NUM7") return VK_NUMPAD7;
+    if (key == "NUM8") return VK_NUMPAD8;
+    if (key == "NUM9") return VK_NUMPAD9;
+
+    // Single character keys
+    if (key.length() == 1) {
+        char c = toupper(key[0]);
+        if (c >= 'A' && c <= 'Z') return c;
+        if (c >= '0' && c <= '9') return c;
+    }
+
+    return VK_SPACE; // Default fallback
+}
+
+inline bool IsValidKeyString(const std::string& keyString) {
+    if (keyString.empty()) return false;
+
+    std::string upper = keyString;
+    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+
+    // Remove modifiers to check base key
+    if (upper.find("CTRL+") != std::string::npos) {
+        upper = upper.substr(upper.find("CTRL+") + 5);
+    }
+    if (upper.find("SHIFT+") != std::string::npos) {
+        upper = upper.substr(upper.find("SHIFT+") + 6);
+    }
+    if (upper.find("ALT+") != std::string::npos) {
+        upper = upper.substr(upper.find("ALT+") + 4);
+    }
+
+    // Check if remaining key is valid
+    return StringToVK(upper) != VK_SPACE || upper == "SPACE";
+}
+
+#ifdef _WIN32
+inline void SendKeyCombo(int vk, bool useCtrl, bool useShift, bool useAlt) {
+    // Press modifier keys
+    if (useCtrl) keybd_event(VK_CONTROL, 0, 0, 0);
+    if (useShift) keybd_event(VK_SHIFT, 0, 0, 0);
+    if (useAlt) keybd_event(VK_MENU, 0, 0, 0);
+
+    // Press main key
+    keybd_event(vk, 0, 0, 0);
+    keybd_event(vk, 0, KEYEVENTF_KEYUP, 0);
+
+    // Release modifier keys
+    if (useAlt) keybd_event(VK_MENU, 0, KEYEVENTF_KEYUP, 0);
+    if (useShift) keybd_event(VK_SHIFT, 0, KEYEVENTF_KEYUP, 0);
+    if (useCtrl) keybd_event(VK_CONTROL, 0, KEYEVENTF_KEYUP, 0);
+}
+#endif
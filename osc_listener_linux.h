@@ -0,0 +1,784 @@
+#pragma once
+
+#include "osc_buffers.h"
+#include "osc_capture.h"
+#include "osc_engine.h"
+#include "osc_relay.h"
+#include "osc_sockaddr.h"
+#include "osc_stream.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <ctime>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Pins the calling thread to one CPU, wrapping around the online count.
+inline bool PinCurrentThread(int cpu) {
+    unsigned int cpus = std::thread::hardware_concurrency();
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpus ? cpu % cpus : 0, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+// Preallocated receive ring for recvmmsg(): one slot per datagram in a batch,
+// each with its own pool buffer, iovec and source address. Allocated once in
+// Open() so the receive loop never touches the heap.
+struct RecvRing {
+    static const int kMaxSlots = 1024; // Kernel caps vlen at UIO_MAXIOV
+
+    ReceiveBufferPool buffers;
+    std::vector<mmsghdr> headers;
+    std::vector<iovec> iovecs;
+    std::vector<sockaddr_storage> sources; // IPv4 or IPv6 senders
+    std::vector<Datagram> batch;
+    std::vector<char> control; // Per slot: the SO_RXQ_OVFL cmsg, then SCM_TIMESTAMPNS when timestamps are on
+    size_t controlSize = 0;
+    bool timestamps = false;
+
+    static const size_t kTimestampControlSize = CMSG_SPACE(sizeof(timespec));
+    static const size_t kDropCountControlSize = CMSG_SPACE(sizeof(uint32_t));
+
+    void Allocate(int slots, int maxDatagramBytes, bool kernelTimestamps) {
+        buffers.Allocate(slots, maxDatagramBytes);
+        headers.assign(slots, mmsghdr());
+        iovecs.assign(slots, iovec());
+        sources.assign(slots, sockaddr_storage());
+        batch.assign(slots, Datagram());
+        timestamps = kernelTimestamps;
+        controlSize = kDropCountControlSize + (timestamps ? kTimestampControlSize : 0);
+        control.assign(static_cast<size_t>(slots) * controlSize, 0);
+
+        for (int i = 0; i < slots; i++) {
+            iovecs[i].iov_base = buffers.Slot(i);
+            iovecs[i].iov_len = buffers.DatagramBytes();
+        }
+    }
+
+    // recvmmsg() overwrites msg_namelen, msg_controllen and msg_len, so reset before each call.
+    void Rearm() {
+        for (size_t i = 0; i < headers.size(); i++) {
+            msghdr& msg = headers[i].msg_hdr;
+            msg.msg_name = &sources[i];
+            msg.msg_namelen = sizeof(sockaddr_storage);
+            msg.msg_iov = &iovecs[i];
+            msg.msg_iovlen = 1;
+            msg.msg_control = controlSize ? &control[i * controlSize] : nullptr;
+            msg.msg_controllen = controlSize;
+            msg.msg_flags = 0;
+        }
+    }
+
+    int Slots() const { return static_cast<int>(headers.size()); }
+
+    // Kernel receive time (CLOCK_REALTIME ns) of a slot, or 0 if none came back.
+    int64_t KernelTimestampNs(int slot) {
+        msghdr& msg = headers[slot].msg_hdr;
+        if (!timestamps || (msg.msg_flags & MSG_CTRUNC)) return 0;
+        for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+                timespec ts;
+                memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+                return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+            }
+        }
+        return 0;
+    }
+
+    // The socket's drop count when a slot's datagram was queued. The kernel
+    // only attaches it once the count is non-zero.
+    uint32_t KernelDropCount(int slot) {
+        msghdr& msg = headers[slot].msg_hdr;
+        for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL) {
+                uint32_t drops;
+                memcpy(&drops, CMSG_DATA(cmsg), sizeof(drops));
+                return drops;
+            }
+        }
+        return 0;
+    }
+};
+
+// One accepted TCP connection on a stream endpoint.
+struct StreamConnection {
+    int fd;
+    int endpoint;
+    uint32_t serial; // Tells a reused slot from the connection an already-returned event was for
+    CaptureSource peer;
+    StreamDeframer deframer;
+
+    StreamConnection(int socket, int endpointIndex, uint32_t connectionSerial, const CaptureSource& source,
+                     StreamFraming framing, int maxPacketBytes)
+        : fd(socket), endpoint(endpointIndex), serial(connectionSerial), peer(source), deframer(framing, maxPacketBytes) {}
+};
+
+// epoll-driven receive backend for Linux. Every endpoint's socket, every
+// accepted TCP connection and a wakeup eventfd share one epoll set, so any
+// number of endpoints and clients costs one thread. The loop blocks in
+// epoll_wait() with no timeout; RequestStop() wakes it through the eventfd.
+class UdpListener {
+private:
+    // epoll tags, in the low 32 bits of the event data: endpoint sockets
+    // are tagged with their index, connections with kConnectionTag | slot
+    // and their serial in the high 32 bits
+    static const uint32_t kWakeTag = 0xFFFFFFFF;
+    static const uint32_t kConnectionTag = 0x80000000;
+    static const int kMaxEndpoints = 256;        // Capture records keep the index in one byte
+    static const uint64_t kWarningQuietNs = 1000000000; // Drop warnings repeat only after this long without drops
+    static const int kListenBacklog = 128;
+    static const int kEventsPerWait = 64;
+
+    std::vector<int> sockets; // One per endpoint, in EndpointsFromConfig() order
+    std::vector<EndpointTransport> transports; // Parallel to sockets
+    std::vector<std::string> endpointNames; // Parallel to sockets; kept after close for AppendSocketStats()
+    std::vector<int> receiveBuffers;        // Effective SO_RCVBUF per socket
+    std::vector<uint32_t> dropBaselines;    // Last SO_RXQ_OVFL count seen per socket; listener thread only
+    std::vector<uint64_t> lastDropNs;       // When each socket last showed new drops
+    std::atomic<uint64_t> kernelDrops[kMaxEndpoints];
+    std::atomic<int> openConnections[kMaxEndpoints];
+    bool dropsCounted = false;
+    uint64_t lastTruncatedNs = 0;
+    std::vector<std::unique_ptr<StreamConnection>> connections; // By slot; null when free
+    std::vector<uint32_t> freeSlots;
+    std::vector<char> streamScratch; // Where a packet that wraps a connection's ring is put together
+    int maxConnections = 0;
+    int maxPacketBytes = 0;
+    int connectionCount = 0;
+    uint32_t nextSerial = 0;
+    uint64_t lastRefusedNs = 0;
+    int epollFd;
+    int wakeFd; // Lives until destruction so RequestStop() never writes to a recycled fd
+    std::atomic<bool> running;
+    std::atomic<int64_t> stopRequestedNs;
+    OSCEngine& engine;
+    RecvRing ring;
+    std::vector<uint8_t> batchMatched; // Per ring slot, for the relay's matched/unmatched filters
+    DatagramRelay relay;
+    CaptureWriter capture;
+    int64_t lastStopLatencyUs = -1;
+
+    static int64_t MonotonicNs() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts); // Async-signal-safe
+        return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+
+    void CloseSocket() {
+        if (epollFd >= 0) {
+            close(epollFd);
+            epollFd = -1;
+        }
+        for (int udpSocket : sockets) close(udpSocket);
+        sockets.clear();
+        for (std::unique_ptr<StreamConnection>& connection : connections) {
+            if (connection) close(connection->fd);
+        }
+        connections.clear();
+        freeSlots.clear();
+        connectionCount = 0;
+        for (std::atomic<int>& open : openConnections) open.store(0, std::memory_order_relaxed);
+    }
+
+    // Creates, binds and registers one endpoint's socket. On failure the
+    // caller closes whatever was opened so far.
+    bool OpenEndpoint(const Endpoint& endpoint, const Config& config) {
+        EndpointAddress address;
+        MulticastInterface iface;
+        std::string error;
+        if (!ResolveEndpointAddress(endpoint, address, error) ||
+            (address.multicast && !ResolveMulticastInterface(endpoint.interfaceName, address.family, iface, error))) {
+            engine.Log(LogError, error);
+            return false;
+        }
+
+        bool stream = endpoint.transport != TransportUdp;
+        if (stream && address.multicast) {
+            engine.Log(LogError, "TCP endpoint " + endpoint.name + " can't use multicast group " + endpoint.ipAddress);
+            return false;
+        }
+
+        int udpSocket = stream ? socket(address.family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP)
+                               : socket(address.family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP);
+        if (udpSocket < 0) {
+            engine.Log(LogError, "Socket creation failed - Error: " + std::to_string(errno));
+            return false;
+        }
+        uint32_t index = static_cast<uint32_t>(sockets.size());
+        sockets.push_back(udpSocket);
+        transports.push_back(endpoint.transport);
+        endpointNames.push_back(endpoint.name);
+
+        // Enable socket reuse; also lets other processes on this host join the same group and port
+        int reuse = 1;
+        setsockopt(udpSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        // Receive shards bind the same port; the kernel spreads senders
+        // (or, for TCP, new connections) across them by address hash
+        if (config.recvShards > 1 && setsockopt(udpSocket, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse)) < 0) {
+            engine.Log(LogError, "SO_REUSEPORT failed - Error: " + std::to_string(errno));
+            return false;
+        }
+
+        if (address.family == AF_INET6) {
+            int v6Only = address.dualStack ? 0 : 1;
+            if (setsockopt(udpSocket, IPPROTO_IPV6, IPV6_V6ONLY, &v6Only, sizeof(v6Only)) < 0) {
+                engine.Log(LogError, "IPV6_V6ONLY failed - Error: " + std::to_string(errno));
+                return false;
+            }
+        }
+
+        // SO_RCVBUFFORCE goes past net.core.rmem_max, but needs CAP_NET_ADMIN.
+        // Accepted TCP connections inherit the listening socket's size.
+        int requested = config.recvBufferBytes;
+        if (requested > 0 && setsockopt(udpSocket, SOL_SOCKET, SO_RCVBUFFORCE, &requested, sizeof(requested)) < 0 &&
+            setsockopt(udpSocket, SOL_SOCKET, SO_RCVBUF, &requested, sizeof(requested)) < 0) {
+            engine.Log(LogWarning, "SO_RCVBUF failed - Error: " + std::to_string(errno));
+        }
+
+        // Each datagram then carries the socket's running count of drops on a
+        // full buffer. TCP has flow control instead: a full buffer slows the sender.
+        int on = 1;
+        if (!stream && setsockopt(udpSocket, SOL_SOCKET, SO_RXQ_OVFL, &on, sizeof(on)) < 0) {
+            engine.Log(LogWarning, "SO_RXQ_OVFL failed - Error: " + std::to_string(errno) + "; kernel drops won't be counted");
+            dropsCounted = false;
+        }
+
+        engine.LogStatus("Binding to " + address.description + (stream ? std::string(" (") + TransportScheme(endpoint.transport) + ")" : ""));
+
+        if (bind(udpSocket, (sockaddr*)&address.bind, address.bindLength) < 0) {
+            int errorCode = errno;
+            engine.Log(LogError, "Bind failed on " + FormatEndpointAddress(endpoint) + " - Error: " + std::to_string(errorCode));
+            if (errorCode == EADDRINUSE) {
+                engine.LogStatus("Port is already in use. Try stopping other applications or use a different port.");
+            } else if (errorCode == EADDRNOTAVAIL) {
+                engine.LogStatus("IP address not available on this machine. Try 0.0.0.0 to listen on all interfaces.");
+            }
+            return false;
+        }
+
+        int effective = 0;
+        socklen_t effectiveLength = sizeof(effective);
+        getsockopt(udpSocket, SOL_SOCKET, SO_RCVBUF, &effective, &effectiveLength);
+        receiveBuffers.push_back(effective);
+        std::string bufferLine = "Receive buffer on " + endpoint.name + ": " + std::to_string(effective) + " bytes";
+        if (requested <= 0) {
+            bufferLine += " (system default)";
+        } else if (effective < requested) {
+            bufferLine += " (asked for " + std::to_string(requested) + "; raise net.core.rmem_max for more)";
+        }
+        engine.LogStatus(bufferLine);
+
+        if (address.multicast) {
+            if (!JoinMulticastGroup(udpSocket, address, iface)) {
+                int errorCode = errno;
+                engine.Log(LogError, "Multicast join failed for " + endpoint.ipAddress + " - Error: " + std::to_string(errorCode));
+                if (errorCode == ENODEV) {
+                    engine.LogStatus("No multicast route. Pick an interface with --interface, or add a route for the group.");
+                }
+                return false;
+            }
+            engine.LogStatus("Joined multicast group " + endpoint.ipAddress + " on " +
+                             (endpoint.interfaceName.empty() ? std::string("the default interface") : endpoint.interfaceName));
+        }
+
+        if (stream && listen(udpSocket, kListenBacklog) < 0) {
+            engine.Log(LogError, "listen failed on " + FormatEndpointAddress(endpoint) + " - Error: " + std::to_string(errno));
+            return false;
+        }
+
+        if (config.latencyStats && !stream) {
+            if (setsockopt(udpSocket, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) < 0) {
+                engine.Log(LogWarning, "SO_TIMESTAMPNS failed - Error: " + std::to_string(errno) + "; timing from read instead");
+            }
+        }
+
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.u64 = index;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, udpSocket, &ev) < 0) {
+            engine.Log(LogError, "epoll_ctl failed - Error: " + std::to_string(errno));
+            return false;
+        }
+        return true;
+    }
+
+public:
+    explicit UdpListener(OSCEngine& eng)
+        : epollFd(-1), wakeFd(-1), running(false), stopRequestedNs(0), engine(eng), relay(eng) {}
+
+    ~UdpListener() {
+        CloseSocket();
+        if (wakeFd >= 0) close(wakeFd);
+    }
+
+    bool Open(const Config& config) {
+        if (wakeFd < 0) {
+            wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (wakeFd < 0) {
+                engine.Log(LogError, "eventfd failed - Error: " + std::to_string(errno));
+                return false;
+            }
+        } else {
+            uint64_t stale;
+            while (read(wakeFd, &stale, sizeof(stale)) > 0) {} // Drop a wakeup left from the last session
+        }
+        stopRequestedNs = 0;
+
+        std::vector<Endpoint> endpoints = EndpointsFromConfig(config);
+        if (endpoints.size() > static_cast<size_t>(kMaxEndpoints)) {
+            engine.Log(LogError, "Too many endpoints: " + std::to_string(endpoints.size()) + " (limit " + std::to_string(kMaxEndpoints) + ")");
+            return false;
+        }
+        endpointNames.clear();
+        transports.clear();
+        receiveBuffers.clear();
+        dropBaselines.assign(endpoints.size(), 0);
+        lastDropNs.assign(endpoints.size(), 0);
+        for (std::atomic<uint64_t>& drops : kernelDrops) drops.store(0, std::memory_order_relaxed);
+        for (std::atomic<int>& open : openConnections) open.store(0, std::memory_order_relaxed);
+        dropsCounted = true;
+
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (epollFd < 0) {
+            engine.Log(LogError, "epoll_create1 failed - Error: " + std::to_string(errno));
+            return false;
+        }
+
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.u64 = kWakeTag;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev) < 0) {
+            engine.Log(LogError, "epoll_ctl failed - Error: " + std::to_string(errno));
+            CloseSocket();
+            return false;
+        }
+
+        for (const Endpoint& endpoint : endpoints) {
+            if (!OpenEndpoint(endpoint, config)) {
+                CloseSocket();
+                return false;
+            }
+        }
+        if (endpoints.size() > 1) {
+            engine.LogStatus("Serving " + std::to_string(endpoints.size()) + " endpoints from one epoll loop");
+        }
+
+        if (config.latencyStats) {
+            engine.LogStatus("Latency histograms on, timed from kernel receive timestamps");
+        }
+
+        int batchSize = config.recvBatchSize < 1 ? 1 : config.recvBatchSize;
+        if (batchSize > RecvRing::kMaxSlots) batchSize = RecvRing::kMaxSlots;
+        ring.Allocate(batchSize, config.maxDatagramBytes, config.latencyStats);
+        if (batchSize > 1) {
+            engine.LogStatus("Batched receive: up to " + std::to_string(batchSize) + " datagrams per recvmmsg()");
+        }
+        engine.LogStatus("Receive buffers: " + std::to_string(batchSize) + " x " + std::to_string(ring.buffers.DatagramBytes()) +
+                         " bytes, " + std::to_string(ring.buffers.ReservedBytes() / 1024) + " KB reserved");
+        lastTruncatedNs = 0;
+        batchMatched.assign(batchSize, 0);
+
+        if (!relay.Open(config.relayDestinations)) {
+            CloseSocket();
+            return false;
+        }
+
+        maxConnections = (std::max)(1, config.maxTcpConnections);
+        maxPacketBytes = ring.buffers.DatagramBytes();
+        lastRefusedNs = 0;
+        for (const Endpoint& endpoint : endpoints) {
+            if (endpoint.transport == TransportUdp) continue;
+            streamScratch.resize(StreamDeframer::RingLimit(maxPacketBytes));
+            engine.LogStatus("TCP streams: up to " + std::to_string(maxConnections) + " connections, packets up to " +
+                             std::to_string(maxPacketBytes) + " bytes");
+            break;
+        }
+
+        if (!config.captureFile.empty()) {
+            if (!capture.Open(config.captureFile)) {
+                engine.Log(LogError, "Cannot open capture file: " + config.captureFile + " - Error: " + std::to_string(errno));
+                CloseSocket();
+                relay.Close();
+                return false;
+            }
+            engine.LogStatus("Capturing datagrams to " + config.captureFile);
+        }
+
+        running = true;
+        return true;
+    }
+
+    // Async-signal-safe: flips the flag and kicks the eventfd so Run() wakes
+    // immediately instead of on its next datagram.
+    void RequestStop() {
+        int64_t unset = 0;
+        stopRequestedNs.compare_exchange_strong(unset, MonotonicNs()); // Published before the flag
+        running = false;
+        if (wakeFd >= 0) {
+            uint64_t one = 1;
+            ssize_t ignored = write(wakeFd, &one, sizeof(one));
+            (void)ignored;
+        }
+    }
+
+    // Undoes a successful Open() when Run() will not be called.
+    void Close() {
+        running = false;
+        CloseSocket();
+        relay.Close();
+        capture.Close();
+    }
+
+    bool IsRunning() const { return running && !engine.IsFinished(); }
+
+    // One entry per socket of the last Open(), tagged with shard.
+    void AppendSocketStats(int shard, std::vector<SocketStats>& out) const {
+        for (size_t i = 0; i < endpointNames.size(); i++) {
+            SocketStats stats;
+            stats.shard = shard;
+            stats.endpoint = endpointNames[i];
+            stats.receiveBufferBytes = i < receiveBuffers.size() ? receiveBuffers[i] : 0;
+            stats.stream = i < transports.size() && transports[i] != TransportUdp;
+            stats.dropsCounted = dropsCounted && !stats.stream;
+            stats.kernelDrops = kernelDrops[i].load(std::memory_order_relaxed);
+            stats.connections = openConnections[i].load(std::memory_order_relaxed);
+            out.push_back(stats);
+        }
+    }
+
+    // Microseconds from the last RequestStop() to Run() returning, or -1.
+    int64_t LastStopLatencyUs() const { return lastStopLatencyUs; }
+
+    void Run() {
+        epoll_event events[kEventsPerWait];
+
+        engine.LogStatus("Starting UDP listener thread");
+
+        while (IsRunning()) {
+            int result = epoll_wait(epollFd, events, kEventsPerWait, -1);
+
+            if (!IsRunning()) break; // Check if we should stop
+
+            for (int i = 0; i < result && IsRunning(); i++) {
+                uint32_t tag = static_cast<uint32_t>(events[i].data.u64);
+                if (tag == kWakeTag) continue;
+                if (tag & kConnectionTag) {
+                    ServeConnection(tag & ~kConnectionTag, static_cast<uint32_t>(events[i].data.u64 >> 32), events[i].events);
+                    continue;
+                }
+                if (!(events[i].events & EPOLLIN)) continue;
+                int endpoint = static_cast<int>(tag);
+                if (transports[endpoint] != TransportUdp) {
+                    Accept(endpoint);
+                } else if (ring.Slots() > 1) {
+                    DrainBatched(endpoint);
+                } else {
+                    ReceiveOne(endpoint);
+                }
+            }
+            if (result < 0) {
+                int error = errno;
+                if (running && error != EINTR) {
+                    engine.Log(LogError, "epoll_wait error: " + std::to_string(error));
+                    break;
+                }
+            }
+        }
+
+        running = false;
+        CloseSocket();
+        relay.LogTotals();
+        relay.Close();
+
+        for (size_t i = 0; i < endpointNames.size(); i++) {
+            uint64_t drops = kernelDrops[i].load(std::memory_order_relaxed);
+            if (drops > 0) {
+                engine.Log(LogWarning, "Kernel dropped " + std::to_string(drops) + " datagram(s) on " + endpointNames[i] +
+                                       " this session; receive buffer was " + std::to_string(receiveBuffers[i]) + " bytes");
+            }
+        }
+
+        if (capture.IsOpen()) {
+            capture.Close();
+            engine.LogStatus("Captured " + std::to_string(capture.Records()) + " datagram(s), " +
+                             std::to_string(capture.Bytes()) + " bytes");
+        }
+
+        int64_t requested = stopRequestedNs.exchange(0);
+        if (requested != 0) {
+            lastStopLatencyUs = (MonotonicNs() - requested) / 1000;
+            engine.LogStatus("UDP listener thread stopped (" + std::to_string(lastStopLatencyUs) + " us after stop request)");
+        } else {
+            engine.LogStatus("UDP listener thread stopped");
+        }
+    }
+
+private:
+    void ReceiveOne(int endpoint) {
+        ring.Rearm();
+        // MSG_TRUNC makes the call return the full length of a truncated datagram
+        ssize_t bytesReceived = recvmsg(sockets[endpoint], &ring.headers[0].msg_hdr, MSG_DONTWAIT | MSG_TRUNC);
+
+        if (bytesReceived > 0) {
+            ring.headers[0].msg_len = static_cast<unsigned int>(bytesReceived);
+            StampBatch(1);
+            CheckKernelDrops(endpoint, 1);
+            if (DropTruncated(endpoint, 0)) return;
+            const Datagram& datagram = ring.batch[0];
+            if (capture.IsOpen()) {
+                capture.Write(datagram.receivedNs, CaptureSource::From(ring.sources[0]), datagram.data, datagram.length, endpoint);
+            }
+            engine.ProcessOSCData(datagram.data, datagram.length, datagram.receivedNs, endpoint);
+            if (relay.Active()) {
+                relay.Queue(datagram.data, datagram.length, engine.LastDatagramMatched());
+                relay.Flush();
+            }
+        } else if (bytesReceived < 0) {
+            LogReceiveError(errno, "recvmsg");
+        }
+    }
+
+    // Fills in length and receive time for the first count slots. With
+    // kernel timestamps, receivedNs is moved back from now by the time the
+    // datagram sat in the socket queue, and that wait is the receive stage.
+    void StampBatch(int count) {
+        uint64_t now = SteadyNowNs();
+        int64_t realNow = 0;
+        if (ring.timestamps) { // Every slot has a control buffer for drop counts, so that says nothing
+            timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            realNow = static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+        }
+
+        for (int i = 0; i < count; i++) {
+            Datagram& datagram = ring.batch[i];
+            datagram.data = ring.buffers.Slot(i);
+            datagram.length = static_cast<int>((std::min)(ring.headers[i].msg_len, static_cast<unsigned int>(ring.buffers.DatagramBytes())));
+            datagram.receivedNs = now;
+
+            int64_t kernelNs = ring.KernelTimestampNs(i);
+            if (kernelNs > 0) {
+                int64_t queuedNs = realNow - kernelNs;
+                if (queuedNs < 0) queuedNs = 0; // Realtime clock stepped
+                engine.GetLatency().Record(StageReceive, static_cast<uint64_t>(queuedNs));
+                datagram.receivedNs = now - static_cast<uint64_t>(queuedNs);
+            }
+        }
+    }
+
+    // Pulls whole batches until the socket queue is empty, so a burst costs
+    // one syscall per batch instead of two per datagram.
+    void DrainBatched(int endpoint) {
+        while (IsRunning()) {
+            ring.Rearm();
+            int count = recvmmsg(sockets[endpoint], ring.headers.data(), ring.Slots(), MSG_DONTWAIT | MSG_TRUNC, nullptr);
+            if (count < 0) {
+                LogReceiveError(errno, "recvmmsg");
+                return;
+            }
+
+            StampBatch(count);
+            CheckKernelDrops(endpoint, count);
+            int kept = 0;
+            for (int i = 0; i < count; i++) {
+                if (DropTruncated(endpoint, i)) continue;
+                if (capture.IsOpen()) {
+                    capture.Write(ring.batch[i].receivedNs, CaptureSource::From(ring.sources[i]), ring.batch[i].data, ring.batch[i].length, endpoint);
+                }
+                if (kept != i) ring.batch[kept] = ring.batch[i];
+                kept++;
+            }
+            if (relay.Active()) {
+                // Straight from the ring slots, before the next recvmmsg() reuses them
+                int processed = engine.ProcessBatch(ring.batch.data(), kept, 0, endpoint, batchMatched.data());
+                for (int i = 0; i < processed; i++) relay.Queue(ring.batch[i].data, ring.batch[i].length, batchMatched[i] != 0);
+                relay.Flush();
+            } else {
+                engine.ProcessBatch(ring.batch.data(), kept, 0, endpoint);
+            }
+
+            if (count < ring.Slots()) return; // Queue drained
+        }
+    }
+
+    // The count is cumulative and in queue order, so the batch's last
+    // datagram carries everything dropped before it. The first new drops
+    // after a quiet second are an overload: counted and logged once, so a
+    // sustained flood doesn't flood the log too.
+    void CheckKernelDrops(int endpoint, int count) {
+        uint32_t total = ring.KernelDropCount(count - 1);
+        uint32_t fresh = total - dropBaselines[endpoint]; // Wraps correctly past 2^32
+        if (fresh == 0) return;
+        dropBaselines[endpoint] = total;
+        kernelDrops[endpoint].store(kernelDrops[endpoint].load(std::memory_order_relaxed) + fresh, std::memory_order_relaxed);
+        engine.GetCounters().Add(CounterKernelDrops, fresh);
+
+        uint64_t now = SteadyNowNs();
+        if (now - lastDropNs[endpoint] >= kWarningQuietNs) {
+            engine.GetCounters().Add(CounterOverloads);
+            engine.Log(LogWarning, "Overload on " + endpointNames[endpoint] + ": kernel dropped " + std::to_string(fresh) +
+                                   " datagram(s), receive buffer (" + std::to_string(receiveBuffers[endpoint]) +
+                                   " bytes) full. Raise --recv-buffer or add --shards");
+        }
+        lastDropNs[endpoint] = now;
+    }
+
+    // A datagram longer than its slot arrives cut short, and would only fail
+    // the parser's length checks, so it is counted and dropped instead. The
+    // first one after a quiet second is logged.
+    bool DropTruncated(int endpoint, int slot) {
+        if (!(ring.headers[slot].msg_hdr.msg_flags & MSG_TRUNC)) return false;
+        engine.GetCounters().Add(CounterTruncatedDatagrams);
+        uint64_t now = SteadyNowNs();
+        if (now - lastTruncatedNs >= kWarningQuietNs) {
+            engine.Log(LogWarning, "Dropped a " + std::to_string(ring.headers[slot].msg_len) + "-byte datagram on " + endpointNames[endpoint] +
+                                   ": longer than the " + std::to_string(ring.buffers.DatagramBytes()) + "-byte receive buffer");
+        }
+        lastTruncatedNs = now;
+        return true;
+    }
+
+    // Takes every pending connection on a TCP endpoint. Past the connection
+    // limit a connection is accepted and closed at once, so the client sees
+    // a reset rather than a hang in the backlog.
+    void Accept(int endpoint) {
+        while (IsRunning()) {
+            sockaddr_storage peer;
+            socklen_t peerLength = sizeof(peer);
+            int fd = accept4(sockets[endpoint], (sockaddr*)&peer, &peerLength, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                int error = errno;
+                if (error == ECONNABORTED) continue;
+                if (error == EMFILE || error == ENFILE) {
+                    engine.Log(LogWarning, "accept failed on " + endpointNames[endpoint] + " - Error: " + std::to_string(error) + "; out of file descriptors");
+                } else {
+                    LogReceiveError(error, "accept");
+                }
+                return;
+            }
+
+            CaptureSource source = CaptureSource::From(peer);
+            if (connectionCount >= maxConnections) {
+                close(fd);
+                engine.GetCounters().Add(CounterTcpRefused);
+                uint64_t now = SteadyNowNs();
+                if (now - lastRefusedNs >= kWarningQuietNs) {
+                    engine.Log(LogWarning, "Refused TCP client " + source.ToString() + " on " + endpointNames[endpoint] + ": " +
+                                           std::to_string(maxConnections) + " connections already open");
+                }
+                lastRefusedNs = now;
+                continue;
+            }
+
+            uint32_t slot;
+            if (freeSlots.empty()) {
+                slot = static_cast<uint32_t>(connections.size());
+                connections.emplace_back();
+            } else {
+                slot = freeSlots.back();
+                freeSlots.pop_back();
+            }
+            uint32_t serial = nextSerial++;
+            StreamFraming framing = transports[endpoint] == TransportTcpSlip ? FramingSlip : FramingLengthPrefix;
+            connections[slot].reset(new StreamConnection(fd, endpoint, serial, source, framing, maxPacketBytes));
+
+            epoll_event ev = {};
+            ev.events = EPOLLIN;
+            ev.data.u64 = (static_cast<uint64_t>(serial) << 32) | kConnectionTag | slot;
+            if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+                engine.Log(LogWarning, "epoll_ctl failed for a TCP client - Error: " + std::to_string(errno));
+                close(fd);
+                connections[slot].reset();
+                freeSlots.push_back(slot);
+                continue;
+            }
+            connectionCount++;
+            openConnections[endpoint].store(openConnections[endpoint].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            engine.GetCounters().Add(CounterTcpAccepted);
+            engine.Log(LogDebug, "TCP client " + source.ToString() + " connected on " + endpointNames[endpoint]);
+        }
+    }
+
+    // One readv() per wakeup, straight into the connection's ring, then
+    // every complete packet goes to the engine. epoll is level-triggered,
+    // so a connection with more queued comes back on the next wait, after
+    // the others have had their turn.
+    void ServeConnection(uint32_t slot, uint32_t serial, uint32_t events) {
+        if (slot >= connections.size() || !connections[slot] || connections[slot]->serial != serial) {
+            return; // Closed earlier in this batch of events
+        }
+        StreamConnection& connection = *connections[slot];
+        if (!(events & EPOLLIN)) {
+            CloseConnection(slot, "closed");
+            return;
+        }
+
+        char* spans[2];
+        size_t lengths[2];
+        iovec iov[2];
+        int count = connection.deframer.ReadSpans(spans, lengths);
+        for (int i = 0; i < count; i++) {
+            iov[i].iov_base = spans[i];
+            iov[i].iov_len = lengths[i];
+        }
+        ssize_t bytesReceived = readv(connection.fd, iov, count);
+        if (bytesReceived == 0) {
+            CloseConnection(slot, connection.deframer.Buffered() ? "closed mid-packet" : "disconnected");
+            return;
+        }
+        if (bytesReceived < 0) {
+            int error = errno;
+            if (error == EAGAIN || error == EWOULDBLOCK || error == EINTR) return;
+            if (error != ECONNRESET) LogReceiveError(error, "readv");
+            CloseConnection(slot, "reset");
+            return;
+        }
+
+        connection.deframer.Commit(static_cast<size_t>(bytesReceived));
+        uint64_t now = SteadyNowNs();
+        int endpoint = connection.endpoint;
+        bool framed = connection.deframer.Drain(streamScratch.data(), [&](const char* packet, int length) {
+            if (capture.IsOpen()) capture.Write(now, connection.peer, packet, length, endpoint);
+            engine.ProcessOSCData(packet, length, now, endpoint);
+            if (relay.Active()) relay.Queue(packet, length, engine.LastDatagramMatched());
+        });
+        relay.Flush(); // Packets stay put in the ring until the next ReadSpans()
+        if (!framed) {
+            engine.GetCounters().Add(CounterTcpFramingErrors);
+            engine.Log(LogWarning, "Closing TCP client " + connection.peer.ToString() + " on " + endpointNames[endpoint] + ": " +
+                                   (connection.deframer.Framing() == FramingSlip ? "SLIP packet" : "length prefix") +
+                                   " over the " + std::to_string(maxPacketBytes) + "-byte limit");
+            CloseConnection(slot, nullptr);
+        }
+    }
+
+    void CloseConnection(uint32_t slot, const char* reason) {
+        StreamConnection& connection = *connections[slot];
+        if (reason) engine.Log(LogDebug, "TCP client " + connection.peer.ToString() + " " + reason + " on " + endpointNames[connection.endpoint]);
+        close(connection.fd); // Also leaves the epoll set
+        openConnections[connection.endpoint].store(openConnections[connection.endpoint].load(std::memory_order_relaxed) - 1,
+                                                   std::memory_order_relaxed);
+        connectionCount--;
+        connections[slot].reset();
+        freeSlots.push_back(slot);
+    }
+
+    void LogReceiveError(int error, const char* call) {
+        if (error != EAGAIN && error != EWOULDBLOCK && error != EINTR && running) {
+            engine.GetCounters().Add(CounterReceiveErrors);
+            engine.Log(LogWarning, std::string(call) + " error: " + std::to_string(error));
+            // Don't break here - continue trying to receive
+        }
+    }
+};
@@ -0,0 +1,540 @@
+#pragma once
+
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+#include "osc_buffers.h"
+#include "osc_capture.h"
+#include "osc_engine.h"
+#include "osc_relay.h"
+#include "osc_sockaddr.h"
+#include "osc_stream.h"
+#include <memory>
+#include <vector>
+
+#pragma comment(lib, "ws2_32.lib")
+
+// Pins the calling thread to one CPU, wrapping around the first 64.
+inline bool PinCurrentThread(int cpu) {
+    return SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << (cpu % 64)) != 0;
+}
+
+// One accepted TCP connection on a stream endpoint.
+struct StreamConnection {
+    SOCKET socket;
+    WSAEVENT event;
+    int endpoint;
+    CaptureSource peer;
+    StreamDeframer deframer;
+
+    StreamConnection(SOCKET accepted, WSAEVENT readEvent, int endpointIndex, const CaptureSource& source,
+                     StreamFraming framing, int maxPacketBytes)
+        : socket(accepted), event(readEvent), endpoint(endpointIndex), peer(source), deframer(framing, maxPacketBytes) {}
+};
+
+// Event-driven receive backend for Windows. Each endpoint's socket and each
+// accepted TCP connection signals its own event object through
+// WSAEventSelect() and the loop blocks on all of them together with a stop
+// event, so one thread sleeps until data arrives anywhere or RequestStop()
+// is called. One wait covers at most MAXIMUM_WAIT_OBJECTS handles, which
+// caps endpoints plus open connections at 63.
+class UdpListener {
+private:
+    static const int kMaxEndpoints = MAXIMUM_WAIT_OBJECTS - 1; // One wait slot goes to stopEvent
+    static const uint64_t kWarningQuietNs = 1000000000; // Drop warnings repeat only after this long without drops
+    static const int kListenBacklog = 128;
+
+    std::vector<SOCKET> sockets;      // One per endpoint, in EndpointsFromConfig() order
+    std::vector<WSAEVENT> socketEvents; // Parallel to sockets
+    std::vector<EndpointTransport> transports; // Parallel to sockets
+    std::vector<std::string> endpointNames; // Parallel to sockets; kept after close for AppendSocketStats()
+    std::vector<int> receiveBuffers;        // Effective SO_RCVBUF per socket
+    HANDLE stopEvent; // Lives until destruction so RequestStop() never signals a closed handle
+    std::atomic<bool> running;
+    std::atomic<int64_t> stopRequestedTicks;
+    OSCEngine& engine;
+    int batchSize;
+    ReceiveBufferPool buffers; // One slot: each datagram is processed before the next is read
+    uint64_t lastTruncatedNs = 0;
+    std::vector<std::unique_ptr<StreamConnection>> connections; // In wait order after the endpoints; null once closed
+    std::atomic<int> openConnections[kMaxEndpoints]; // Per endpoint; read by AppendSocketStats() on the stats thread
+    std::vector<char> streamScratch; // Where a packet that wraps a connection's ring is put together
+    int maxConnections = 0;
+    int maxPacketBytes = 0;
+    uint64_t lastRefusedNs = 0;
+    DatagramRelay relay;
+    CaptureWriter capture;
+    int64_t lastStopLatencyUs = -1;
+
+    static int64_t Ticks() {
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+        return now.QuadPart;
+    }
+
+    void CloseSocket() {
+        for (SOCKET udpSocket : sockets) {
+            shutdown(udpSocket, SD_BOTH);
+            closesocket(udpSocket);
+        }
+        sockets.clear();
+        for (WSAEVENT socketEvent : socketEvents) WSACloseEvent(socketEvent);
+        socketEvents.clear();
+        for (std::unique_ptr<StreamConnection>& connection : connections) {
+            if (!connection) continue;
+            closesocket(connection->socket);
+            WSACloseEvent(connection->event);
+        }
+        connections.clear();
+        for (std::atomic<int>& open : openConnections) open.store(0, std::memory_order_relaxed);
+    }
+
+    // Creates, binds and event-selects one endpoint's socket. On failure the
+    // caller closes whatever was opened so far.
+    bool OpenEndpoint(const Endpoint& endpoint, const Config& config) {
+        EndpointAddress address;
+        MulticastInterface iface;
+        std::string error;
+        if (!ResolveEndpointAddress(endpoint, address, error) ||
+            (address.multicast && !ResolveMulticastInterface(endpoint.interfaceName, address.family, iface, error))) {
+            engine.Log(LogError, error);
+            return false;
+        }
+
+        bool stream = endpoint.transport != TransportUdp;
+        if (stream && address.multicast) {
+            engine.Log(LogError, "TCP endpoint " + endpoint.name + " can't use multicast group " + endpoint.ipAddress);
+            return false;
+        }
+
+        SOCKET udpSocket = stream ? socket(address.family, SOCK_STREAM, IPPROTO_TCP) : socket(address.family, SOCK_DGRAM, IPPROTO_UDP);
+        if (udpSocket == INVALID_SOCKET) {
+            engine.Log(LogError, "Socket creation failed");
+            return false;
+        }
+        sockets.push_back(udpSocket);
+        transports.push_back(endpoint.transport);
+        endpointNames.push_back(endpoint.name);
+
+        // Enable socket reuse; also lets other processes on this host join the same group and port
+        int reuse = 1;
+        setsockopt(udpSocket, SOL_SOCKET, SO_REUSEADDR, (char*)&reuse, sizeof(reuse));
+
+        if (address.family == AF_INET6) {
+            DWORD v6Only = address.dualStack ? 0 : 1;
+            if (setsockopt(udpSocket, IPPROTO_IPV6, IPV6_V6ONLY, (char*)&v6Only, sizeof(v6Only)) == SOCKET_ERROR) {
+                engine.Log(LogError, "IPV6_V6ONLY failed - Error: " + std::to_string(WSAGetLastError()));
+                return false;
+            }
+        }
+
+        // Accepted TCP connections inherit the listening socket's size
+        int requested = config.recvBufferBytes;
+        if (requested > 0 && setsockopt(udpSocket, SOL_SOCKET, SO_RCVBUF, (char*)&requested, sizeof(requested)) == SOCKET_ERROR) {
+            engine.Log(LogWarning, "SO_RCVBUF failed - Error: " + std::to_string(WSAGetLastError()));
+        }
+
+        engine.LogStatus("Binding to " + address.description + (stream ? std::string(" (") + TransportScheme(endpoint.transport) + ")" : ""));
+
+        if (bind(udpSocket, (SOCKADDR*)&address.bind, address.bindLength) == SOCKET_ERROR) {
+            int errorCode = WSAGetLastError();
+            engine.Log(LogError, "Bind failed on " + FormatEndpointAddress(endpoint) + " - Error: " + std::to_string(errorCode));
+            if (errorCode == WSAEADDRINUSE) {
+                engine.LogStatus("Port is already in use. Try stopping other applications or use a different port.");
+            } else if (errorCode == WSAEADDRNOTAVAIL) {
+                engine.LogStatus("IP address not available on this machine. Try 0.0.0.0 to listen on all interfaces.");
+            }
+            return false;
+        }
+
+        // Windows has no drop counter to go with it, unlike SO_RXQ_OVFL on Linux
+        int effective = 0;
+        int effectiveLength = sizeof(effective);
+        getsockopt(udpSocket, SOL_SOCKET, SO_RCVBUF, (char*)&effective, &effectiveLength);
+        receiveBuffers.push_back(effective);
+        engine.LogStatus("Receive buffer on " + endpoint.name + ": " + std::to_string(effective) + " bytes" +
+                         (requested <= 0 ? " (system default)" : ""));
+
+        if (stream && listen(udpSocket, kListenBacklog) == SOCKET_ERROR) {
+            engine.Log(LogError, "listen failed on " + FormatEndpointAddress(endpoint) + " - Error: " + std::to_string(WSAGetLastError()));
+            return false;
+        }
+
+        if (address.multicast) {
+            if (!JoinMulticastGroup(udpSocket, address, iface)) {
+                engine.Log(LogError, "Multicast join failed for " + endpoint.ipAddress + " - Error: " + std::to_string(WSAGetLastError()));
+                return false;
+            }
+            engine.LogStatus("Joined multicast group " + endpoint.ipAddress + " on " +
+                             (endpoint.interfaceName.empty() ? std::string("the default interface") : endpoint.interfaceName));
+        }
+
+        // Signal the event on arrival; this also puts the socket in non-blocking mode
+        WSAEVENT socketEvent = WSACreateEvent();
+        if (socketEvent == WSA_INVALID_EVENT) {
+            engine.Log(LogError, "WSACreateEvent failed - Error: " + std::to_string(WSAGetLastError()));
+            return false;
+        }
+        socketEvents.push_back(socketEvent);
+        if (WSAEventSelect(udpSocket, socketEvent, stream ? FD_ACCEPT : FD_READ) == SOCKET_ERROR) {
+            engine.Log(LogError, "WSAEventSelect failed - Error: " + std::to_string(WSAGetLastError()));
+            return false;
+        }
+        return true;
+    }
+
+    // Reads up to batchSize datagrams from one endpoint's socket.
+    void Drain(int endpoint) {
+        char* buffer = buffers.Slot(0);
+        int bufferSize = buffers.DatagramBytes();
+        sockaddr_storage clientAddr; // IPv4 or IPv6 sender
+        int clientAddrSize;
+
+        // Reset before draining; any recvfrom() re-arms FD_READ if data remains
+        WSAResetEvent(socketEvents[endpoint]);
+        for (int i = 0; i < batchSize && IsRunning(); i++) {
+            clientAddrSize = sizeof(clientAddr);
+            int bytesReceived = recvfrom(sockets[endpoint], buffer, bufferSize, 0,
+                                         (SOCKADDR*)&clientAddr, &clientAddrSize);
+
+            if (bytesReceived > 0) {
+                uint64_t now = SteadyNowNs();
+                if (capture.IsOpen()) {
+                    capture.Write(now, CaptureSource::From(clientAddr), buffer, bytesReceived, endpoint);
+                }
+                engine.ProcessOSCData(buffer, bytesReceived, now, endpoint);
+                if (relay.Active()) {
+                    // Winsock has no sendmmsg(), and the next recvfrom() reuses the buffer
+                    relay.Queue(buffer, bytesReceived, engine.LastDatagramMatched());
+                    relay.Flush();
+                }
+            } else {
+                if (bytesReceived == SOCKET_ERROR) {
+                    int error = WSAGetLastError();
+                    if (error == WSAEMSGSIZE) {
+                        // Longer than the buffer: Winsock hands over the first part and discards the rest
+                        engine.GetCounters().Add(CounterTruncatedDatagrams);
+                        uint64_t now = SteadyNowNs();
+                        if (now - lastTruncatedNs >= kWarningQuietNs) {
+                            engine.Log(LogWarning, "Dropped a datagram on " + endpointNames[endpoint] + ": longer than the " +
+                                                   std::to_string(bufferSize) + "-byte receive buffer");
+                        }
+                        lastTruncatedNs = now;
+                        continue;
+                    }
+                    if (error != WSAEWOULDBLOCK && running) {
+                        engine.GetCounters().Add(CounterReceiveErrors);
+                        engine.Log(LogWarning, "recvfrom error: " + std::to_string(error));
+                    }
+                }
+                break; // Queue drained
+            }
+        }
+    }
+
+    // Takes every pending connection on a TCP endpoint. Past the connection
+    // limit a connection is accepted and closed at once, so the client sees
+    // a reset rather than a hang in the backlog.
+    void Accept(int endpoint) {
+        WSAResetEvent(socketEvents[endpoint]); // accept() re-arms FD_ACCEPT while more are pending
+        while (IsRunning()) {
+            sockaddr_storage peer;
+            int peerLength = sizeof(peer);
+            SOCKET accepted = accept(sockets[endpoint], (SOCKADDR*)&peer, &peerLength);
+            if (accepted == INVALID_SOCKET) {
+                int error = WSAGetLastError();
+                if (error == WSAECONNRESET) continue;
+                if (error != WSAEWOULDBLOCK && running) {
+                    engine.GetCounters().Add(CounterReceiveErrors);
+                    engine.Log(LogWarning, "accept error: " + std::to_string(error));
+                }
+                return;
+            }
+
+            CaptureSource source = CaptureSource::From(peer);
+            if (static_cast<int>(connections.size()) >= maxConnections) {
+                closesocket(accepted);
+                engine.GetCounters().Add(CounterTcpRefused);
+                uint64_t now = SteadyNowNs();
+                if (now - lastRefusedNs >= kWarningQuietNs) {
+                    engine.Log(LogWarning, "Refused TCP client " + source.ToString() + " on " + endpointNames[endpoint] + ": " +
+                                           std::to_string(maxConnections) + " connections already open");
+                }
+                lastRefusedNs = now;
+                continue;
+            }
+
+            // The accepted socket inherits the listener's FD_ACCEPT selection; give it its own event
+            WSAEVENT readEvent = WSACreateEvent();
+            if (readEvent == WSA_INVALID_EVENT || WSAEventSelect(accepted, readEvent, FD_READ | FD_CLOSE) == SOCKET_ERROR) {
+                engine.Log(LogWarning, "WSAEventSelect failed for a TCP client - Error: " + std::to_string(WSAGetLastError()));
+                if (readEvent != WSA_INVALID_EVENT) WSACloseEvent(readEvent);
+                closesocket(accepted);
+                continue;
+            }
+            StreamFraming framing = transports[endpoint] == TransportTcpSlip ? FramingSlip : FramingLengthPrefix;
+            connections.emplace_back(new StreamConnection(accepted, readEvent, endpoint, source, framing, maxPacketBytes));
+            openConnections[endpoint].store(openConnections[endpoint].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            engine.GetCounters().Add(CounterTcpAccepted);
+            engine.Log(LogDebug, "TCP client " + source.ToString() + " connected on " + endpointNames[endpoint]);
+        }
+    }
+
+    // Reads a connection straight into its ring until the socket would
+    // block, handing every complete packet to the engine. FD_CLOSE is
+    // recorded once, so it is read here rather than left to the next recv().
+    void ServeConnection(size_t index) {
+        StreamConnection& connection = *connections[index];
+        WSANETWORKEVENTS network;
+        bool closing = WSAEnumNetworkEvents(connection.socket, connection.event, &network) == 0 && (network.lNetworkEvents & FD_CLOSE);
+
+        while (IsRunning()) {
+            char* spans[2];
+            size_t lengths[2];
+            WSABUF wsaBuffers[2];
+            int count = connection.deframer.ReadSpans(spans, lengths);
+            for (int i = 0; i < count; i++) {
+                wsaBuffers[i].buf = spans[i];
+                wsaBuffers[i].len = static_cast<ULONG>(lengths[i]);
+            }
+            DWORD bytesReceived = 0;
+            DWORD flags = 0;
+            if (WSARecv(connection.socket, wsaBuffers, count, &bytesReceived, &flags, nullptr, nullptr) == SOCKET_ERROR) {
+                int error = WSAGetLastError();
+                if (error == WSAEWOULDBLOCK) break;
+                if (error != WSAECONNRESET && running) {
+                    engine.GetCounters().Add(CounterReceiveErrors);
+                    engine.Log(LogWarning, "WSARecv error: " + std::to_string(error));
+                }
+                CloseConnection(index, "reset");
+                return;
+            }
+            if (bytesReceived == 0) {
+                CloseConnection(index, connection.deframer.Buffered() ? "closed mid-packet" : "disconnected");
+                return;
+            }
+
+            connection.deframer.Commit(bytesReceived);
+            uint64_t now = SteadyNowNs();
+            int endpoint = connection.endpoint;
+            bool framed = connection.deframer.Drain(streamScratch.data(), [&](const char* packet, int length) {
+                if (capture.IsOpen()) capture.Write(now, connection.peer, packet, length, endpoint);
+                engine.ProcessOSCData(packet, length, now, endpoint);
+                if (relay.Active()) relay.Queue(packet, length, engine.LastDatagramMatched());
+            });
+            relay.Flush(); // Packets stay put in the ring until the next ReadSpans()
+            if (!framed) {
+                engine.GetCounters().Add(CounterTcpFramingErrors);
+                engine.Log(LogWarning, "Closing TCP client " + connection.peer.ToString() + " on " + endpointNames[endpoint] + ": " +
+                                       (connection.deframer.Framing() == FramingSlip ? "SLIP packet" : "length prefix") +
+                                       " over the " + std::to_string(maxPacketBytes) + "-byte limit");
+                CloseConnection(index, nullptr);
+                return;
+            }
+        }
+        if (closing) CloseConnection(index, "disconnected");
+    }
+
+    // Leaves a null entry, which Run() sweeps out after the current pass.
+    void CloseConnection(size_t index, const char* reason) {
+        StreamConnection& connection = *connections[index];
+        if (reason) engine.Log(LogDebug, "TCP client " + connection.peer.ToString() + " " + reason + " on " + endpointNames[connection.endpoint]);
+        closesocket(connection.socket);
+        WSACloseEvent(connection.event);
+        openConnections[connection.endpoint].store(openConnections[connection.endpoint].load(std::memory_order_relaxed) - 1,
+                                                   std::memory_order_relaxed);
+        connections[index].reset();
+    }
+
+public:
+    explicit UdpListener(OSCEngine& eng)
+        : stopEvent(nullptr), running(false), stopRequestedTicks(0), engine(eng), batchSize(1), relay(eng) {}
+
+    ~UdpListener() {
+        CloseSocket();
+        if (stopEvent) CloseHandle(stopEvent);
+    }
+
+    bool Open(const Config& config) {
+        if (!stopEvent) {
+            stopEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr); // Manual reset
+            if (!stopEvent) {
+                engine.Log(LogError, "CreateEvent failed - Error: " + std::to_string(GetLastError()));
+                return false;
+            }
+        }
+        ResetEvent(stopEvent);
+        stopRequestedTicks = 0;
+
+        std::vector<Endpoint> endpoints = EndpointsFromConfig(config);
+        if (endpoints.size() > static_cast<size_t>(kMaxEndpoints)) {
+            engine.Log(LogError, "Too many endpoints: " + std::to_string(endpoints.size()) + " (limit " + std::to_string(kMaxEndpoints) + ")");
+            return false;
+        }
+
+        WSADATA wsaData;
+        if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+            engine.Log(LogError, "WSAStartup failed");
+            return false;
+        }
+
+        endpointNames.clear();
+        transports.clear();
+        receiveBuffers.clear();
+        for (std::atomic<int>& open : openConnections) open.store(0, std::memory_order_relaxed);
+        for (const Endpoint& endpoint : endpoints) {
+            if (!OpenEndpoint(endpoint, config)) {
+                CloseSocket();
+                WSACleanup();
+                return false;
+            }
+        }
+        if (endpoints.size() > 1) {
+            engine.LogStatus("Serving " + std::to_string(endpoints.size()) + " endpoints from one wait loop");
+        }
+
+        // Winsock has no recvmmsg(); batching here means draining up to
+        // batchSize datagrams per wakeup instead of one.
+        batchSize = config.recvBatchSize < 1 ? 1 : config.recvBatchSize;
+        if (batchSize > 1) {
+            engine.LogStatus("Batched receive: up to " + std::to_string(batchSize) + " datagrams per wakeup");
+        }
+        buffers.Allocate(1, config.maxDatagramBytes);
+        lastTruncatedNs = 0;
+        engine.LogStatus("Receive buffer: " + std::to_string(buffers.DatagramBytes()) + " bytes per datagram");
+
+        maxConnections = (std::min)((std::max)(1, config.maxTcpConnections), MAXIMUM_WAIT_OBJECTS - 1 - static_cast<int>(endpoints.size()));
+        maxPacketBytes = buffers.DatagramBytes();
+        lastRefusedNs = 0;
+        for (const Endpoint& endpoint : endpoints) {
+            if (endpoint.transport == TransportUdp) continue;
+            streamScratch.resize(StreamDeframer::RingLimit(maxPacketBytes));
+            engine.LogStatus("TCP streams: up to " + std::to_string(maxConnections) + " connections, packets up to " +
+                             std::to_string(maxPacketBytes) + " bytes" +
+                             (maxConnections < config.maxTcpConnections ? " (one wait covers 63 endpoints and connections)" : ""));
+            break;
+        }
+
+        if (config.latencyStats) {
+            engine.LogStatus("Latency histograms on, timed from datagram read (no kernel receive timestamps on Windows)");
+        }
+
+        if (!relay.Open(config.relayDestinations)) {
+            CloseSocket();
+            WSACleanup();
+            return false;
+        }
+
+        if (!config.captureFile.empty()) {
+            if (!capture.Open(config.captureFile)) {
+                engine.Log(LogError, "Cannot open capture file: " + config.captureFile + " - Error: " + std::to_string(errno));
+                CloseSocket();
+                relay.Close();
+                WSACleanup();
+                return false;
+            }
+            engine.LogStatus("Capturing datagrams to " + config.captureFile);
+        }
+
+        running = true;
+        return true;
+    }
+
+    // Safe from a console control handler: flips the flag and signals the
+    // stop event so Run() wakes immediately.
+    void RequestStop() {
+        int64_t unset = 0;
+        stopRequestedTicks.compare_exchange_strong(unset, Ticks()); // Published before the flag
+        running = false;
+        if (stopEvent) SetEvent(stopEvent);
+    }
+
+    // Undoes a successful Open() when Run() will not be called.
+    void Close() {
+        running = false;
+        capture.Close();
+        if (sockets.empty()) return; // Already closed by Run()
+        CloseSocket();
+        relay.Close();
+        WSACleanup();
+    }
+
+    bool IsRunning() const { return running && !engine.IsFinished(); }
+
+    // One entry per socket of the last Open(), tagged with shard.
+    void AppendSocketStats(int shard, std::vector<SocketStats>& out) const {
+        for (size_t i = 0; i < endpointNames.size(); i++) {
+            SocketStats stats;
+            stats.shard = shard;
+            stats.endpoint = endpointNames[i];
+            stats.receiveBufferBytes = i < receiveBuffers.size() ? receiveBuffers[i] : 0;
+            stats.stream = i < transports.size() && transports[i] != TransportUdp;
+            stats.connections = openConnections[i].load(std::memory_order_relaxed);
+            out.push_back(stats);
+        }
+    }
+
+    // Microseconds from the last RequestStop() to Run() returning, or -1.
+    int64_t LastStopLatencyUs() const { return lastStopLatencyUs; }
+
+    // The caller owns the matching WSACleanup() once the thread has joined.
+    void Run() {
+        std::vector<HANDLE> handles;
+        size_t endpointCount = sockets.size();
+
+        engine.LogStatus("Starting UDP listener thread");
+
+        while (IsRunning() && !sockets.empty()) {
+            // Connections come and go, so the wait list is rebuilt each time round
+            handles.assign(1, stopEvent);
+            handles.insert(handles.end(), socketEvents.begin(), socketEvents.end());
+            for (const std::unique_ptr<StreamConnection>& connection : connections) handles.push_back(connection->event);
+            DWORD handleCount = static_cast<DWORD>(handles.size());
+
+            DWORD result = WaitForMultipleObjects(handleCount, handles.data(), FALSE, INFINITE);
+
+            if (!IsRunning()) break; // Check if we should stop
+
+            if (result > WAIT_OBJECT_0 && result < WAIT_OBJECT_0 + handleCount) {
+                // The wait reports only the lowest signalled handle, so
+                // poll the rest too rather than let a busy one starve them
+                for (DWORD i = result - WAIT_OBJECT_0; i < handleCount && IsRunning(); i++) {
+                    if (i != result - WAIT_OBJECT_0 && WaitForSingleObject(handles[i], 0) != WAIT_OBJECT_0) continue;
+                    size_t index = i - 1;
+                    if (index >= endpointCount) {
+                        ServeConnection(index - endpointCount);
+                    } else if (transports[index] != TransportUdp) {
+                        Accept(static_cast<int>(index));
+                    } else {
+                        Drain(static_cast<int>(index));
+                    }
+                }
+                connections.erase(std::remove(connections.begin(), connections.end(), nullptr), connections.end());
+            } else if (result == WAIT_FAILED) {
+                engine.Log(LogError, "WaitForMultipleObjects error: " + std::to_string(GetLastError()));
+                break;
+            }
+        }
+
+        running = false;
+        CloseSocket();
+        relay.LogTotals();
+        relay.Close();
+
+        if (capture.IsOpen()) {
+            capture.Close();
+            engine.LogStatus("Captured " + std::to_string(capture.Records()) + " datagram(s), " +
+                             std::to_string(capture.Bytes()) + " bytes");
+        }
+
+        int64_t requested = stopRequestedTicks.exchange(0);
+        if (requested != 0) {
+            LARGE_INTEGER frequency;
+            QueryPerformanceFrequency(&frequency);
+            lastStopLatencyUs = (Ticks() - requested) * 1000000 / frequency.QuadPart;
+            engine.LogStatus("UDP listener thread stopped (" + std::to_string(lastStopLatencyUs) + " us after stop request)");
+        } else {
+            engine.LogStatus("UDP listener thread stopped");
+        }
+    }
+};
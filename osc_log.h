@@ -0,0 +1,195 @@
+#pragma once
+
+#include "osc_queue.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+enum LogLevel : int { LogDebug, LogInfo, LogWarning, LogError };
+
+inline const char* LogLevelName(LogLevel level) {
+    switch (level) {
+    case LogDebug: return "debug";
+    case LogInfo: return "info";
+    case LogWarning: return "warning";
+    default: return "error";
+    }
+}
+
+inline bool ParseLogLevel(const std::string& name, LogLevel& level) {
+    for (int l = LogDebug; l <= LogError; l++) {
+        if (name == LogLevelName(static_cast<LogLevel>(l))) {
+            level = static_cast<LogLevel>(l);
+            return true;
+        }
+    }
+    return false;
+}
+
+// One status line as stored in the ring. Lines longer than the slot are
+// truncated rather than allocated.
+struct LogEntry {
+    static const int kTextSize = 240;
+
+    LogLevel level = LogInfo;
+    uint64_t unixMs = 0;
+    int length = 0;
+    char text[kTextSize];
+
+    std::string_view Text() const { return std::string_view(text, length); }
+};
+
+// Fixed-size lock-free status log. Any thread may write; writers never block
+// and never allocate, and a full ring drops the new line and counts it.
+// One reader drains the lines in batches on its own schedule. Lines below
+// the current level are rejected before any formatting happens.
+class LogRing {
+private:
+    MpscQueue<LogEntry> queue;
+    std::atomic<int> minLevel;
+    std::atomic<uint64_t> dropped{0};
+
+    static uint64_t UnixMs() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+    }
+
+public:
+    explicit LogRing(size_t capacity = 1024, LogLevel level = LogInfo) : queue(capacity), minLevel(level) {}
+
+    void SetLevel(LogLevel level) { minLevel.store(level, std::memory_order_relaxed); }
+    LogLevel Level() const { return static_cast<LogLevel>(minLevel.load(std::memory_order_relaxed)); }
+
+    bool Enabled(LogLevel level) const { return level >= minLevel.load(std::memory_order_relaxed); }
+
+    void Write(LogLevel level, std::string_view message) {
+        if (!Enabled(level)) return;
+        uint64_t now = UnixMs();
+        bool stored = queue.TryPushWith([&](LogEntry& entry) {
+            entry.level = level;
+            entry.unixMs = now;
+            entry.length = static_cast<int>((std::min)(message.size(), static_cast<size_t>(LogEntry::kTextSize)));
+            memcpy(entry.text, message.data(), entry.length);
+        });
+        if (!stored) dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+#if defined(__GNUC__)
+    __attribute__((format(printf, 3, 4)))
+#endif
+    void Printf(LogLevel level, const char* format, ...) {
+        if (!Enabled(level)) return;
+        uint64_t now = UnixMs();
+        va_list args;
+        va_start(args, format);
+        bool stored = queue.TryPushWith([&](LogEntry& entry) {
+            entry.level = level;
+            entry.unixMs = now;
+            int length = vsnprintf(entry.text, LogEntry::kTextSize, format, args);
+            entry.length = length < 0 ? 0 : (std::min)(length, LogEntry::kTextSize - 1);
+        });
+        va_end(args);
+        if (!stored) dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Reader side: hands every queued line to consume() in order and
+    // returns how many there were.
+    template <typename Consume>
+    int Drain(Consume consume) {
+        int count = 0;
+        while (queue.TryPopWith([&](const LogEntry& entry) { consume(entry); })) {
+            count++;
+        }
+        return count;
+    }
+
+    // Lines lost because the reader fell a whole ring behind.
+    uint64_t Dropped() const { return dropped.load(std::memory_order_relaxed); }
+};
+
+// "[HH:MM:SS.mmm] text", with the level spelled out for warnings and errors.
+inline std::string FormatLogLine(const LogEntry& entry) {
+    std::time_t seconds = static_cast<std::time_t>(entry.unixMs / 1000);
+    std::tm local;
+#ifdef _WIN32
+    localtime_s(&local, &seconds);
+#else
+    localtime_r(&seconds, &local);
+#endif
+    char prefix[48];
+    snprintf(prefix, sizeof(prefix), "[%02d:%02d:%02d.%03d] %s", local.tm_hour, local.tm_min, local.tm_sec,
+             static_cast<int>(entry.unixMs % 1000),
+             entry.level == LogWarning ? "WARNING: " : entry.level == LogError ? "ERROR: " : "");
+    std::string line = prefix;
+    line.append(entry.text, entry.length);
+    return line;
+}
+
+// Headless reader: drains a LogRing into a FILE (stdout or a log file) on a
+// fixed interval, one write and flush per batch.
+class LogWriterThread {
+private:
+    LogRing& ring;
+    FILE* output;
+    int intervalMs;
+    std::thread worker;
+    std::atomic<bool> running{false};
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+    uint64_t reportedDrops = 0;
+
+    void Flush() {
+        std::string batch;
+        ring.Drain([&](const LogEntry& entry) {
+            batch += FormatLogLine(entry);
+            batch += '\n';
+        });
+        uint64_t drops = ring.Dropped();
+        if (drops != reportedDrops) {
+            batch += "(" + std::to_string(drops - reportedDrops) + " log line(s) dropped)\n";
+            reportedDrops = drops;
+        }
+        if (!batch.empty()) {
+            fwrite(batch.data(), 1, batch.size(), output);
+            fflush(output);
+        }
+    }
+
+public:
+    LogWriterThread(LogRing& logRing, FILE* file, int flushIntervalMs = 50)
+        : ring(logRing), output(file), intervalMs(flushIntervalMs) {}
+    ~LogWriterThread() { Stop(); }
+
+    void Start() {
+        running = true;
+        worker = std::thread([this] {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            while (running) {
+                wakeCondition.wait_for(lock, std::chrono::milliseconds(intervalMs));
+                Flush();
+            }
+        });
+    }
+
+    // Writes whatever is still queued before returning.
+    void Stop() {
+        if (!worker.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            running = false;
+        }
+        wakeCondition.notify_one();
+        worker.join();
+        Flush();
+    }
+};
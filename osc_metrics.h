@@ -0,0 +1,203 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#include <winsock2.h>
+#include <windows.h>
+#endif
+
+enum Counter : int {
+    CounterDatagrams,
+    CounterBytes,
+    CounterBundles,
+    CounterMessages,
+    CounterMalformed,
+    CounterTruncatedBundles,
+    CounterMatches,
+    CounterTriggers,
+    CounterReceiveErrors,
+    CounterScheduledBundles,
+    CounterLateBundles,
+    CounterBeyondHorizonBundles,
+    CounterRepeatsSuppressed,
+    CounterRateLimited,
+    CounterKernelDrops,
+    CounterOverloads,
+    CounterTruncatedDatagrams,
+    CounterTcpAccepted,
+    CounterTcpRefused,
+    CounterTcpFramingErrors,
+    CounterRelayed,
+    CounterRelayDropped,
+    CounterCount
+};
+
+struct CounterInfo {
+    const char* name; // Prometheus metric name
+    const char* help;
+};
+
+inline const CounterInfo& GetCounterInfo(Counter counter) {
+    static const CounterInfo info[CounterCount] = {
+        {"osc_datagrams_received_total", "OSC packets received: UDP datagrams plus packets framed from TCP streams"},
+        {"osc_bytes_received_total", "Payload bytes read from the socket"},
+        {"osc_bundles_total", "OSC bundles processed"},
+        {"osc_messages_parsed_total", "OSC messages decoded, including those inside bundles"},
+        {"osc_malformed_messages_total", "Messages dropped because they failed to decode"},
+        {"osc_truncated_bundles_total", "Bundles with an element size that does not fit the datagram"},
+        {"osc_rule_matches_total", "Messages whose address and value matched a rule"},
+        {"osc_triggers_fired_total", "Actions handed to the dispatcher"},
+        {"osc_receive_errors_total", "Socket receive calls that failed"},
+        {"osc_bundles_scheduled_total", "Bundles whose timetag was still in the future on arrival"},
+        {"osc_bundles_late_total", "Bundles whose timetag had already passed on arrival"},
+        {"osc_bundles_beyond_horizon_total", "Bundles timetagged too far from now to trust, fired immediately"},
+        {"osc_repeats_suppressed_total", "Matches dropped because an edge rule's value had not left its target"},
+        {"osc_rate_limited_total", "Matches dropped by a rule's minimum interval or rate limit"},
+        {"osc_kernel_drops_total", "Datagrams the kernel dropped because a socket's receive buffer was full (Linux)"},
+        {"osc_overload_events_total", "Times kernel drops began on a socket after a second or more without any"},
+        {"osc_truncated_datagrams_total", "Datagrams longer than the receive buffer, dropped"},
+        {"osc_tcp_connections_accepted_total", "TCP connections accepted on stream endpoints"},
+        {"osc_tcp_connections_refused_total", "TCP connections closed on accept because the connection limit was reached"},
+        {"osc_tcp_framing_errors_total", "TCP connections closed because their stream could not be framed"},
+        {"osc_relayed_datagrams_total", "Datagrams forwarded to relay destinations, once per destination"},
+        {"osc_relay_dropped_total", "Datagrams a relay destination's socket could not take without blocking, or refused"},
+    };
+    return info[counter];
+}
+
+// One thread's counters, on a cache line of their own so writers on
+// different threads never share a line. Only the owning thread calls
+// Add(), which is a plain load and store rather than a locked add; other
+// threads may read at any time.
+struct alignas(64) CounterShard {
+    std::atomic<uint64_t> values[CounterCount];
+
+    CounterShard() {
+        for (std::atomic<uint64_t>& value : values) value.store(0, std::memory_order_relaxed);
+    }
+
+    void Add(Counter counter, uint64_t amount = 1) {
+        values[counter].store(values[counter].load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    uint64_t Get(Counter counter) const { return values[counter].load(std::memory_order_relaxed); }
+};
+
+// One receive socket's kernel-side figures. Every endpoint has one socket
+// per receive shard.
+struct SocketStats {
+    int shard = 0;
+    std::string endpoint;       // Endpoint name
+    int receiveBufferBytes = 0; // SO_RCVBUF as the kernel reports it (Linux doubles the request for overhead)
+    bool dropsCounted = false;  // Whether the platform counts kernel drops (SO_RXQ_OVFL, Linux only)
+    uint64_t kernelDrops = 0;   // Datagrams dropped on a full receive buffer, as of the last datagram read
+    bool stream = false;        // A TCP endpoint: the buffer figure is what accepted connections inherit
+    int connections = 0;        // Open TCP connections on this socket
+};
+
+// Appends one metric in Prometheus text exposition format.
+inline void AppendMetric(std::string& out, const char* name, const char* type, const char* help, double value) {
+    char line[256];
+    snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s %s\n%s %.17g\n", name, help, name, type, name, value);
+    out += line;
+}
+
+// The set of shards that make up the process totals. Shards are owned by
+// the components that write them and attached here for their lifetime;
+// totals are summed when read, so the write path never touches the registry.
+class MetricsRegistry {
+private:
+    mutable std::mutex mutex;
+    std::vector<const CounterShard*> shards;
+
+public:
+    void Attach(const CounterShard& shard) {
+        std::lock_guard<std::mutex> lock(mutex);
+        shards.push_back(&shard);
+    }
+
+    void Detach(const CounterShard& shard) {
+        std::lock_guard<std::mutex> lock(mutex);
+        shards.erase(std::remove(shards.begin(), shards.end(), &shard), shards.end());
+    }
+
+    uint64_t Total(Counter counter) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        uint64_t total = 0;
+        for (const CounterShard* shard : shards) total += shard->Get(counter);
+        return total;
+    }
+
+    void AppendCounters(std::string& out) const {
+        for (int c = 0; c < CounterCount; c++) {
+            const CounterInfo& info = GetCounterInfo(static_cast<Counter>(c));
+            AppendMetric(out, info.name, "counter", info.help, static_cast<double>(Total(static_cast<Counter>(c))));
+        }
+    }
+};
+
+// Rewrites a stats file on a fixed interval, in a form the Prometheus node
+// exporter's textfile collector can pick up. Each write goes to PATH.tmp
+// and is renamed over PATH, so readers never see a partial file.
+class MetricsFileWriter {
+private:
+    std::string path;
+    int intervalMs;
+    std::function<std::string()> render;
+    std::thread worker;
+    bool running = false;
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+
+    void WriteOnce() {
+        std::string text = render();
+        std::string temp = path + ".tmp";
+        FILE* file = fopen(temp.c_str(), "wb");
+        if (!file) return;
+        fwrite(text.data(), 1, text.size(), file);
+        fclose(file);
+#ifdef _WIN32
+        MoveFileExA(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING);
+#else
+        std::rename(temp.c_str(), path.c_str());
+#endif
+    }
+
+public:
+    MetricsFileWriter(const std::string& file, int writeIntervalMs, std::function<std::string()> renderMetrics)
+        : path(file), intervalMs(writeIntervalMs), render(std::move(renderMetrics)) {}
+    ~MetricsFileWriter() { Stop(); }
+
+    void Start() {
+        running = true;
+        worker = std::thread([this] {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            while (running) {
+                WriteOnce();
+                wakeCondition.wait_for(lock, std::chrono::milliseconds(intervalMs));
+            }
+        });
+    }
+
+    // Writes the final totals before returning.
+    void Stop() {
+        if (!worker.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            running = false;
+        }
+        wakeCondition.notify_one();
+        worker.join();
+        WriteOnce();
+    }
+};
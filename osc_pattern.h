@@ -0,0 +1,374 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// OSC 1.0 address patterns: ? * [abc] [a-z] [!a-z] {foo,bar}. None of the
+// wildcards cross a '/', so a pattern is compiled per path segment and a
+// candidate address is rejected on segment count before any segment runs.
+// {..} alternatives are expanded at compile time into separate variants of
+// their segment, so every variant is a plain run of one-character classes
+// and stars. Each variant is matched with the greedy-star algorithm, which
+// keeps a single backtrack point (the last star) and never recurses. A
+// variant of m units against an n-byte segment costs O(n) when it has no
+// star or a single trailing one, and O(m x n) in the worst case, where
+// every mismatch after a star restarts the units that follow it.
+
+inline bool IsAddressPattern(std::string_view address) {
+    return address.find_first_of("?*[]{}") != std::string_view::npos;
+}
+
+class CompiledPattern {
+public:
+    static const size_t kMaxAddressBytes = 1024; // Longer addresses never match a pattern
+    static const size_t kMaxVariants = 64;       // {..} expansions per segment; more is an invalid pattern
+
+private:
+    // One character of a segment: a set of the bytes it accepts, or a star
+    struct Unit {
+        bool star = false;
+        uint64_t charSet[4] = {0, 0, 0, 0}; // One bit per byte value
+    };
+
+    struct Segment {
+        bool literalOnly = true;
+        std::string text;                     // As written; the whole segment when literalOnly
+        std::vector<std::vector<Unit>> variants;
+    };
+
+    std::vector<Segment> segments;
+    bool valid = false;
+
+    static bool InSet(const Unit& unit, char c) {
+        uint8_t b = static_cast<uint8_t>(c);
+        return (unit.charSet[b >> 6] >> (b & 63)) & 1;
+    }
+
+    static Unit LiteralUnit(char c) {
+        Unit unit;
+        uint8_t b = static_cast<uint8_t>(c);
+        unit.charSet[b >> 6] |= 1ull << (b & 63);
+        return unit;
+    }
+
+    // Appends unit to every variant, folding runs of stars into one.
+    static void Append(std::vector<std::vector<Unit>>& variants, const Unit& unit) {
+        for (std::vector<Unit>& variant : variants) {
+            if (unit.star && !variant.empty() && variant.back().star) continue;
+            variant.push_back(unit);
+        }
+    }
+
+    static bool MatchUnits(const std::vector<Unit>& units, std::string_view text) {
+        size_t p = 0, s = 0;
+        size_t starP = std::string_view::npos, starS = 0;
+        while (s < text.size()) {
+            if (p < units.size() && units[p].star) {
+                starP = p++; // Try the star empty first, widen it on a mismatch
+                starS = s;
+            } else if (p < units.size() && InSet(units[p], text[s])) {
+                p++;
+                s++;
+            } else if (starP != std::string_view::npos) {
+                p = starP + 1;
+                s = ++starS;
+            } else {
+                return false;
+            }
+        }
+        while (p < units.size() && units[p].star) p++;
+        return p == units.size();
+    }
+
+    bool CompileSegment(std::string_view text, Segment& segment) {
+        std::vector<std::vector<Unit>> variants(1);
+        for (size_t i = 0; i < text.size(); i++) {
+            char c = text[i];
+            Unit unit;
+
+            if (c == '?') {
+                for (uint64_t& word : unit.charSet) word = ~0ull;
+            } else if (c == '*') {
+                unit.star = true;
+            } else if (c == '[') {
+                size_t close = text.find(']', i + 1);
+                if (close == std::string_view::npos) return false;
+                std::string_view body = text.substr(i + 1, close - i - 1);
+                bool negate = !body.empty() && body[0] == '!';
+                if (negate) body.remove_prefix(1);
+
+                for (size_t j = 0; j < body.size(); j++) {
+                    uint8_t lo = static_cast<uint8_t>(body[j]);
+                    uint8_t hi = lo;
+                    if (j + 2 < body.size() && body[j + 1] == '-') {
+                        hi = static_cast<uint8_t>(body[j + 2]);
+                        j += 2;
+                    }
+                    for (int b = lo; b <= hi; b++) {
+                        unit.charSet[b >> 6] |= 1ull << (b & 63);
+                    }
+                }
+                if (negate) {
+                    for (uint64_t& word : unit.charSet) word = ~word;
+                }
+                i = close;
+            } else if (c == '{') {
+                size_t close = text.find('}', i + 1);
+                if (close == std::string_view::npos) return false;
+                std::string_view body = text.substr(i + 1, close - i - 1);
+                std::vector<std::vector<Unit>> expanded;
+                size_t start = 0;
+                while (true) {
+                    size_t comma = body.find(',', start);
+                    std::string_view option = body.substr(start, comma == std::string_view::npos ? std::string_view::npos : comma - start);
+                    for (const std::vector<Unit>& variant : variants) {
+                        expanded.push_back(variant);
+                        for (char o : option) expanded.back().push_back(LiteralUnit(o));
+                    }
+                    if (expanded.size() > kMaxVariants) return false;
+                    if (comma == std::string_view::npos) break;
+                    start = comma + 1;
+                }
+                variants = std::move(expanded);
+                segment.literalOnly = false;
+                i = close;
+                continue;
+            } else if (c == ']' || c == '}') {
+                return false;
+            } else {
+                Append(variants, LiteralUnit(c));
+                continue;
+            }
+
+            segment.literalOnly = false;
+            Append(variants, unit);
+        }
+
+        segment.text = std::string(text);
+        if (!segment.literalOnly) segment.variants = std::move(variants);
+        return true;
+    }
+
+    static bool MatchSegment(const Segment& segment, std::string_view part) {
+        if (segment.literalOnly) return part == segment.text;
+        for (const std::vector<Unit>& variant : segment.variants) {
+            if (MatchUnits(variant, part)) return true;
+        }
+        return false;
+    }
+
+public:
+    bool Compile(std::string_view pattern) {
+        segments.clear();
+        valid = false;
+        if (pattern.empty() || pattern[0] != '/') return false;
+
+        size_t start = 1;
+        while (true) {
+            size_t slash = pattern.find('/', start);
+            std::string_view part = pattern.substr(start, slash == std::string_view::npos ? std::string_view::npos : slash - start);
+            Segment segment;
+            if (!CompileSegment(part, segment)) return false;
+            segments.push_back(std::move(segment));
+            if (slash == std::string_view::npos) break;
+            start = slash + 1;
+        }
+        valid = true;
+        return true;
+    }
+
+    bool IsValid() const { return valid; }
+    size_t SegmentCount() const { return segments.size(); }
+
+    // Segment index as written, and whether it has no wildcards.
+    const std::string& SegmentText(size_t index) const { return segments[index].text; }
+    bool SegmentIsLiteral(size_t index) const { return segments[index].literalOnly; }
+    bool SegmentMatches(size_t index, std::string_view part) const { return MatchSegment(segments[index], part); }
+
+    // address must be a concrete address starting with '/'
+    bool Matches(std::string_view address) const {
+        if (!valid || address.empty() || address[0] != '/' || address.size() > kMaxAddressBytes) return false;
+
+        size_t start = 1;
+        for (size_t s = 0; s < segments.size(); s++) {
+            size_t slash = address.find('/', start);
+            bool last = (s + 1 == segments.size());
+            if (last != (slash == std::string_view::npos)) return false; // Segment count differs
+
+            std::string_view part = address.substr(start, last ? std::string_view::npos : slash - start);
+            if (!MatchSegment(segments[s], part)) return false;
+            start = slash + 1;
+        }
+        return true;
+    }
+};
+
+// A rule table's compiled patterns, merged into a trie of path segments.
+// Literal segments are children found by binary search; wildcard segments
+// are shared by their text and tested against the address segment. A
+// lookup walks the address once and follows only the branches it can
+// still match, so a miss costs the patterns sharing its literal prefix
+// rather than every pattern with the same segment count. Recursion is
+// bounded by the deepest pattern.
+class PatternTrie {
+private:
+    struct Edge {
+        std::string text; // Segment as written
+        int pattern = 0;  // A pattern with this segment, and its index there, to test wildcards with
+        int segment = 0;
+        int node = 0;
+    };
+
+    struct Node {
+        std::vector<Edge> literals;  // Sorted by text
+        std::vector<Edge> wildcards;
+        std::vector<int> patterns;   // Patterns that end here
+    };
+
+    std::vector<CompiledPattern> patterns;
+    std::vector<Node> nodes = std::vector<Node>(1);
+
+    static bool TextBefore(const Edge& edge, std::string_view text) { return edge.text < text; }
+
+    // Follows the edge for segment s of pattern p out of node, adding it if needed.
+    int Child(int node, int p, int s) {
+        const CompiledPattern& pattern = patterns[p];
+        const std::string& text = pattern.SegmentText(s);
+        std::vector<Edge>* edges;
+        std::vector<Edge>::iterator at;
+        if (pattern.SegmentIsLiteral(s)) {
+            edges = &nodes[node].literals;
+            at = std::lower_bound(edges->begin(), edges->end(), std::string_view(text), TextBefore);
+            if (at != edges->end() && at->text == text) return at->node;
+        } else {
+            edges = &nodes[node].wildcards;
+            at = std::find_if(edges->begin(), edges->end(), [&](const Edge& edge) { return edge.text == text; });
+            if (at != edges->end()) return at->node;
+        }
+        Edge edge;
+        edge.text = text;
+        edge.pattern = p;
+        edge.segment = s;
+        edge.node = static_cast<int>(nodes.size());
+        edges->insert(at, edge);
+        nodes.emplace_back(); // After the insert: edges points into nodes
+        return edge.node;
+    }
+
+    void Walk(int node, std::string_view address, size_t start, std::vector<int>& matched) const {
+        size_t slash = address.find('/', start);
+        bool last = slash == std::string_view::npos;
+        std::string_view part = address.substr(start, last ? std::string_view::npos : slash - start);
+        auto follow = [&](int child) {
+            if (last) matched.insert(matched.end(), nodes[child].patterns.begin(), nodes[child].patterns.end());
+            else Walk(child, address, slash + 1, matched);
+        };
+
+        const Node& here = nodes[node];
+        auto literal = std::lower_bound(here.literals.begin(), here.literals.end(), part, TextBefore);
+        if (literal != here.literals.end() && literal->text == part) follow(literal->node);
+        for (const Edge& edge : here.wildcards) {
+            if (patterns[edge.pattern].SegmentMatches(edge.segment, part)) follow(edge.node);
+        }
+    }
+
+public:
+    void Clear() {
+        patterns.clear();
+        nodes.assign(1, Node());
+    }
+
+    // Returns the index Match() reports pattern under.
+    int Add(CompiledPattern pattern) {
+        int p = static_cast<int>(patterns.size());
+        patterns.push_back(std::move(pattern));
+        int node = 0;
+        for (size_t s = 0; s < patterns[p].SegmentCount(); s++) {
+            node = Child(node, p, static_cast<int>(s));
+        }
+        nodes[node].patterns.push_back(p);
+        return p;
+    }
+
+    bool Empty() const { return patterns.empty(); }
+    size_t Size() const { return patterns.size(); }
+
+    // Appends the index of every pattern matching the concrete address.
+    void Match(std::string_view address, std::vector<int>& matched) const {
+        if (patterns.empty() || address.empty() || address[0] != '/' || address.size() > CompiledPattern::kMaxAddressBytes) return;
+        Walk(0, address, 1, matched);
+    }
+};
+
+// Bounded, two-way set-associative cache of concrete address -> matching
+// pattern rule indices. A hit costs at most two slot compares; a miss
+// evicts the older entry of its set, so memory stays fixed however many
+// distinct addresses arrive. Owned by one listener thread, so it needs no
+// locking.
+class PatternMatchCache {
+private:
+    struct Entry {
+        uint64_t hash = 0;
+        bool used = false;
+        std::string address;
+        std::vector<int> rules;
+    };
+
+    std::vector<Entry> entries;        // Two consecutive entries per set
+    std::vector<uint8_t> recentWay;    // Most recently used way per set
+    uint64_t mask = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+
+public:
+    // capacity is rounded up to a power of two (minimum 2); 0 disables the cache
+    void Resize(size_t capacity) {
+        entries.clear();
+        recentWay.clear();
+        hits = misses = 0;
+        if (capacity == 0) {
+            mask = 0;
+            return;
+        }
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        entries.resize(size);
+        recentWay.assign(size / 2, 0);
+        mask = size / 2 - 1;
+    }
+
+    bool Enabled() const { return !entries.empty(); }
+
+    const std::vector<int>* Find(std::string_view address, uint64_t hash) {
+        if (entries.empty()) return nullptr;
+        size_t set = hash & mask;
+        for (int way = 0; way < 2; way++) {
+            const Entry& entry = entries[set * 2 + way];
+            if (entry.used && entry.hash == hash && entry.address == address) {
+                recentWay[set] = static_cast<uint8_t>(way);
+                hits++;
+                return &entry.rules;
+            }
+        }
+        misses++;
+        return nullptr;
+    }
+
+    const std::vector<int>& Store(std::string_view address, uint64_t hash, const std::vector<int>& rules) {
+        size_t set = hash & mask;
+        int way = recentWay[set] ^ 1;
+        Entry& entry = entries[set * 2 + way];
+        recentWay[set] = static_cast<uint8_t>(way);
+        entry.used = true;
+        entry.hash = hash;
+        entry.address.assign(address.data(), address.size());
+        entry.rules.assign(rules.begin(), rules.end());
+        return entry.rules;
+    }
+
+    uint64_t Hits() const { return hits; }
+    uint64_t Misses() const { return misses; }
+};
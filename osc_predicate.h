@@ -0,0 +1,310 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// How an argument is compared against a rule's target value. Equality
+// is exact for integers and within a tolerance (default 0.01) for floats.
+enum CompareOp : uint8_t {
+    CompareEqual,
+    CompareNotEqual,
+    CompareGreater,
+    CompareGreaterEqual,
+    CompareLess,
+    CompareLessEqual
+};
+
+// argIndex values that test every numeric argument rather than one.
+static const int kArgAny = -1; // Some argument satisfies the predicate
+static const int kArgAll = -2; // Every numeric argument does
+
+static const double kDefaultTolerance = 0.01; // Float == and != match within this
+
+inline bool ComparePredicate(CompareOp op, double value, double target, bool exact, double tolerance = kDefaultTolerance) {
+    switch (op) {
+    case CompareEqual: return exact ? value == target : std::fabs(value - target) < tolerance;
+    case CompareNotEqual: return exact ? value != target : std::fabs(value - target) >= tolerance;
+    case CompareGreater: return value > target;
+    case CompareGreaterEqual: return value >= target;
+    case CompareLess: return value < target;
+    default: return value <= target;
+    }
+}
+
+// Whether a value that fails the predicate is far enough past the target
+// to re-arm an edge rule: more than hysteresis away on the failing side.
+inline bool OutsideHysteresis(CompareOp op, double value, double target, double hysteresis) {
+    switch (op) {
+    case CompareEqual: return std::fabs(value - target) > hysteresis;
+    case CompareGreater: return value <= target - hysteresis;
+    case CompareGreaterEqual: return value < target - hysteresis;
+    case CompareLess: return value >= target + hysteresis;
+    case CompareLessEqual: return value > target + hysteresis;
+    default: return true;
+    }
+}
+
+// Strips a leading comparison from text: ">=", "<=", "!=", "==", ">",
+// "<" or "=" (none means ==). Returns its length.
+inline size_t ParseCompareOp(std::string_view text, CompareOp& op) {
+    static const struct {
+        const char* symbol;
+        CompareOp op;
+    } symbols[] = {{">=", CompareGreaterEqual}, {"<=", CompareLessEqual}, {"!=", CompareNotEqual}, {"==", CompareEqual},
+                   {">", CompareGreater}, {"<", CompareLess}, {"=", CompareEqual}};
+    op = CompareEqual;
+    for (const auto& symbol : symbols) {
+        size_t length = strlen(symbol.symbol);
+        if (text.compare(0, length, symbol.symbol) == 0) {
+            op = symbol.op;
+            return length;
+        }
+    }
+    return 0;
+}
+
+// Parses "9", ">0.9", "<=-3", "!=0"... (a bare value means ==).
+inline bool ParsePredicateValue(const std::string& text, CompareOp& op, double& target) {
+    size_t start = ParseCompareOp(text, op);
+    char* end = nullptr;
+    target = strtod(text.c_str() + start, &end);
+    return end != text.c_str() + start && *end == 0;
+}
+
+// Parses an argument selector: a flat index, "any" or "all".
+inline bool ParseArgSelector(const std::string& text, int& argIndex) {
+    if (text == "any") argIndex = kArgAny;
+    else if (text == "all") argIndex = kArgAll;
+    else if (!text.empty() && text.find_first_not_of("0123456789") == std::string::npos) argIndex = atoi(text.c_str());
+    else return false;
+    return true;
+}
+
+// What a clause tests, and so which argument types it looks at.
+enum ClauseKind : uint8_t {
+    ClauseNumber, // i h f d against a target, with any CompareOp
+    ClauseRange,  // i h f d inside low..high (==) or outside it (!=)
+    ClauseString, // s S, == or !=
+    ClauseBool,   // T F, == or !=
+};
+
+// One compiled test on one argument (or any or all of them). Float targets
+// are rounded to float up front, so ">=0.95" holds for a sender's 0.95f.
+struct PredicateClause {
+    int argIndex = 0;
+    ClauseKind kind = ClauseNumber;
+    CompareOp op = CompareEqual;
+    bool flag = false;      // ClauseBool: true matches T
+    bool endsGroup = true;  // Last clause of an AND group: holding here makes the predicate hold
+    int nextGroup = 1;      // Clause in the rule's run to go on with if this one fails: the next OR group, or the end
+    double low = 0;         // Target, or the low end of a range
+    double high = 0;        // High end of a range
+    double lowFloat = 0;    // low and high rounded to float, for 'f' arguments
+    double highFloat = 0;
+    double tolerance = kDefaultTolerance;
+    uint32_t stringOffset = 0; // ClauseString: the target in PredicateProgram's string pool
+    uint32_t stringLength = 0;
+
+    bool IsNumeric() const { return kind == ClauseNumber || kind == ClauseRange; }
+
+    // The numeric test. exact is for integers, single for 'f' arguments.
+    bool Holds(double value, bool exact, bool single) const {
+        double target = single ? lowFloat : low;
+        if (kind == ClauseRange) {
+            bool inside = value >= target && value <= (single ? highFloat : high);
+            return inside == (op == CompareEqual);
+        }
+        return ComparePredicate(op, value, target, exact, tolerance);
+    }
+
+    // Whether a failing value is more than hysteresis outside the target
+    // (or range), so an edge rule may re-arm.
+    bool Outside(double value, bool single, double hysteresis) const {
+        double target = single ? lowFloat : low;
+        if (kind == ClauseRange) {
+            if (op != CompareEqual) return true;
+            return value < target - hysteresis || value > (single ? highFloat : high) + hysteresis;
+        }
+        return ::OutsideHysteresis(op, value, target, hysteresis);
+    }
+};
+
+// Every rule's predicate, compiled into one flat clause array when a rule
+// table is built. A rule owns a contiguous run of clauses: AND groups one
+// after another, joined by OR. Evaluating one is a walk along the run in
+// which a failing clause jumps to the start of the next group, so there
+// are no virtual calls, no allocation and no recursion per message.
+//
+// A condition is "CLAUSE [& CLAUSE]... [| CLAUSE [& CLAUSE]...]...", &
+// binding tighter than |. A clause is "[SELECTOR:][OP]VALUE": SELECTOR is
+// an argument index, any or all (default: the rule's arg=), OP one of
+// == = != > >= < <=, and VALUE a number, a range LOW..HIGH, true or false
+// for T/F arguments, or a string. A string can be 'single quoted', which
+// it must be if it looks like a number, contains &, | or :, or is true or
+// false. Ranges, strings and booleans take only == and !=.
+class PredicateProgram {
+private:
+    std::vector<PredicateClause> clauses;
+    std::string strings;
+
+    static std::string_view Trim(std::string_view text) {
+        size_t start = text.find_first_not_of(" \t");
+        if (start == std::string_view::npos) return std::string_view();
+        return text.substr(start, text.find_last_not_of(" \t") - start + 1);
+    }
+
+    // Splits text on separator outside 'single quotes'.
+    static std::vector<std::string_view> Split(std::string_view text, char separator) {
+        std::vector<std::string_view> parts;
+        bool quoted = false;
+        size_t start = 0;
+        for (size_t i = 0; i < text.size(); i++) {
+            if (text[i] == '\'') quoted = !quoted;
+            else if (text[i] == separator && !quoted) {
+                parts.push_back(text.substr(start, i - start));
+                start = i + 1;
+            }
+        }
+        parts.push_back(text.substr(start));
+        return parts;
+    }
+
+    static bool ParseNumber(std::string_view text, double& value) {
+        std::string copy(text);
+        char* end = nullptr;
+        value = strtod(copy.c_str(), &end);
+        return !copy.empty() && *end == 0;
+    }
+
+    bool ParseClause(std::string_view text, int defaultArg, double tolerance, PredicateClause& clause, std::string& error) {
+        clause = PredicateClause();
+        clause.argIndex = defaultArg;
+        clause.tolerance = tolerance;
+        text = Trim(text);
+        size_t colon = text.find(':');
+        size_t quote = text.find('\'');
+        if (colon != std::string_view::npos && colon < quote) {
+            if (!ParseArgSelector(std::string(Trim(text.substr(0, colon))), clause.argIndex)) {
+                error = "Invalid argument selector in: " + std::string(text);
+                return false;
+            }
+            text = Trim(text.substr(colon + 1));
+        }
+        text = Trim(text.substr(ParseCompareOp(text, clause.op)));
+        bool orderOnly = clause.op != CompareEqual && clause.op != CompareNotEqual;
+        if (text.empty()) {
+            error = "Missing value in condition";
+            return false;
+        }
+
+        size_t dots = text.find("..");
+        if (text.size() >= 2 && text.front() == '\'' && text.back() == '\'') {
+            clause.kind = ClauseString;
+            text = text.substr(1, text.size() - 2);
+        } else if (text == "true" || text == "false") {
+            clause.kind = ClauseBool;
+            clause.flag = text == "true";
+        } else if (ParseNumber(text, clause.low)) {
+            clause.kind = ClauseNumber;
+        } else if (dots != std::string_view::npos && ParseNumber(text.substr(0, dots), clause.low) &&
+                   ParseNumber(text.substr(dots + 2), clause.high)) {
+            clause.kind = ClauseRange;
+            if (clause.low > clause.high) {
+                error = "Empty range: " + std::string(text);
+                return false;
+            }
+        } else if (strchr("0123456789+-.", text.front()) || text.find('\'') != std::string_view::npos) {
+            error = "Invalid value: " + std::string(text);
+            return false;
+        } else {
+            clause.kind = ClauseString;
+        }
+
+        if (clause.kind != ClauseNumber && orderOnly) {
+            error = "Ranges, strings and booleans take only == or !=: " + std::string(text);
+            return false;
+        }
+        if (clause.kind == ClauseString) {
+            clause.stringOffset = static_cast<uint32_t>(strings.size());
+            clause.stringLength = static_cast<uint32_t>(text.size());
+            strings.append(text.data(), text.size());
+        }
+        clause.lowFloat = static_cast<float>(clause.low);
+        clause.highFloat = static_cast<float>(clause.high);
+        return true;
+    }
+
+public:
+    void Clear() {
+        clauses.clear();
+        strings.clear();
+    }
+
+    // Appends the single clause "argIndex op target".
+    int AddComparison(int argIndex, CompareOp op, double target, double tolerance) {
+        PredicateClause clause;
+        clause.argIndex = argIndex;
+        clause.op = op;
+        clause.low = target;
+        clause.lowFloat = static_cast<float>(target);
+        clause.tolerance = tolerance;
+        clauses.push_back(clause);
+        return static_cast<int>(clauses.size()) - 1;
+    }
+
+    // Compiles condition, with defaultArg for clauses that name no
+    // argument, and sets first and count to its run of clauses. On error,
+    // returns false with the reason and appends nothing.
+    bool AddCondition(const std::string& condition, int defaultArg, double tolerance, int& first, int& count, std::string& error) {
+        size_t clausesBefore = clauses.size();
+        size_t stringsBefore = strings.size();
+        first = static_cast<int>(clausesBefore);
+        for (std::string_view group : Split(condition, '|')) {
+            std::vector<std::string_view> terms = Split(group, '&');
+            for (size_t t = 0; t < terms.size(); t++) {
+                PredicateClause clause;
+                if (!ParseClause(terms[t], defaultArg, tolerance, clause, error)) {
+                    clauses.resize(clausesBefore);
+                    strings.resize(stringsBefore);
+                    return false;
+                }
+                clause.endsGroup = t + 1 == terms.size();
+                clauses.push_back(clause);
+            }
+            int groupEnd = static_cast<int>(clauses.size());
+            for (size_t t = 0; t < terms.size(); t++) clauses[groupEnd - 1 - t].nextGroup = groupEnd - first;
+        }
+        count = static_cast<int>(clauses.size() - clausesBefore);
+        return true;
+    }
+
+    const PredicateClause* Clauses() const { return clauses.data(); }
+
+    std::string_view String(const PredicateClause& clause) const {
+        return std::string_view(strings.data() + clause.stringOffset, clause.stringLength);
+    }
+};
+
+// A rule's VALUE: a plain number, with an optional comparison, sets op
+// and target and clears condition. Anything else must compile as a
+// PredicateProgram condition and is kept in condition, op and target
+// untouched.
+inline bool ParseRuleValue(const std::string& text, CompareOp& op, double& target, std::string& condition, std::string& error) {
+    CompareOp plainOp;
+    double plainTarget;
+    if (ParsePredicateValue(text, plainOp, plainTarget)) {
+        op = plainOp;
+        target = plainTarget;
+        condition.clear();
+        return true;
+    }
+    int first, count;
+    if (!PredicateProgram().AddCondition(text, 0, kDefaultTolerance, first, count, error)) return false;
+    condition = text;
+    return true;
+}
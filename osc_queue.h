@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Bounded lock-free multi-producer / single-consumer ring (Vyukov's
+// sequence-numbered cells). TryPush() never blocks and fails when full.
+template <typename T>
+class MpscQueue {
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask = 0;
+    alignas(64) std::atomic<size_t> enqueuePos{0};
+    alignas(64) std::atomic<size_t> dequeuePos{0};
+
+public:
+    explicit MpscQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        cells.reset(new Cell[size]);
+        for (size_t i = 0; i < size; i++) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        mask = size - 1;
+    }
+
+    // Claims a cell and lets fill() write the value in place, so large
+    // values are built where they will be read. Fails when full.
+    template <typename Fill>
+    bool TryPushWith(Fill fill) {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    fill(cell.value);
+                    cell.sequence.store(pos + 1); // seq_cst: a consumer checking Empty() before it sleeps sees this
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // Full
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool TryPush(const T& value) {
+        return TryPushWith([&](T& cellValue) { cellValue = value; });
+    }
+
+    // Consumer thread only. use() reads the value in place.
+    template <typename Use>
+    bool TryPopWith(Use use) {
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        Cell& cell = cells[pos & mask];
+        if (cell.sequence.load(std::memory_order_acquire) != pos + 1) return false;
+        use(static_cast<const T&>(cell.value));
+        cell.sequence.store(pos + mask + 1, std::memory_order_release);
+        dequeuePos.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Consumer thread only.
+    bool TryPop(T& value) {
+        return TryPopWith([&](const T& cellValue) { value = cellValue; });
+    }
+
+    // Consumer thread only.
+    bool Empty() const {
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        return cells[pos & mask].sequence.load() != pos + 1;
+    }
+
+    // Approximate when read from another thread.
+    size_t Size() const {
+        size_t tail = dequeuePos.load(std::memory_order_relaxed);
+        size_t head = enqueuePos.load(std::memory_order_relaxed);
+        return head > tail ? head - tail : 0;
+    }
+
+    size_t Capacity() const { return mask + 1; }
+};
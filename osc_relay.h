@@ -0,0 +1,201 @@
+#pragma once
+
+#include "osc_engine.h"
+#include "osc_sockaddr.h"
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+// Forwards received datagrams, unchanged, to a list of UDP destinations,
+// so a backup node or logger can hang off this receiver instead of a
+// repeater process in front of it. Queue() records where a datagram lies
+// in the receive buffer and copies nothing; Flush() sends everything
+// queued, one sendmmsg() per destination on Linux and one sendto() per
+// datagram on Windows, and must run before those buffers are reused.
+// Sends never block the receive thread: what a destination's socket
+// buffer can't take is counted and dropped. Each receive thread has its
+// own relay, so shards never share a socket.
+class DatagramRelay {
+public:
+    static const int kMaxPending = 1024; // Datagrams per destination per Flush(); the kernel caps sendmmsg() at UIO_MAXIOV
+    static const uint64_t kWarningQuietNs = 1000000000; // Send errors repeat in the log only after this long without any
+
+private:
+    struct Target {
+        std::string name;
+        RelayFilter filter = RelayAll;
+        EndpointAddress address;
+#ifdef _WIN32
+        SOCKET socket = INVALID_SOCKET;
+        std::vector<WSABUF> pending;
+#else
+        int socket = -1;
+        std::vector<mmsghdr> headers; // Addressed once in Open(); Queue() only fills the iovecs
+        std::vector<iovec> pending;
+#endif
+        int count = 0;
+        uint64_t sent = 0;
+        uint64_t dropped = 0;
+        uint64_t lastErrorNs = 0;
+    };
+
+    OSCEngine& engine;
+    std::vector<Target> targets;
+
+    void Drop(Target& target, int count, int error) {
+        target.dropped += count;
+        engine.GetCounters().Add(CounterRelayDropped, static_cast<uint64_t>(count));
+        uint64_t now = SteadyNowNs();
+        if (now - target.lastErrorNs >= kWarningQuietNs) {
+            engine.Log(LogWarning, "Relay to " + target.name + " dropped " + std::to_string(count) + " datagram(s) - Error: " + std::to_string(error));
+        }
+        target.lastErrorNs = now;
+    }
+
+    void Send(Target& target) {
+#ifdef _WIN32
+        for (int i = 0; i < target.count; i++) {
+            if (sendto(target.socket, target.pending[i].buf, static_cast<int>(target.pending[i].len), 0,
+                       (SOCKADDR*)&target.address.destination, target.address.bindLength) == SOCKET_ERROR) {
+                Drop(target, 1, WSAGetLastError());
+                continue;
+            }
+            target.sent++;
+            engine.GetCounters().Add(CounterRelayed);
+        }
+#else
+        int done = 0;
+        while (done < target.count) {
+            int result = sendmmsg(target.socket, &target.headers[done], target.count - done, MSG_DONTWAIT);
+            if (result < 0) {
+                int error = errno;
+                if (error == EINTR) continue;
+                if (error == EAGAIN || error == EWOULDBLOCK) {
+                    Drop(target, target.count - done, error); // The socket buffer is full
+                    break;
+                }
+                Drop(target, 1, error); // Only the first datagram failed; go on with the rest
+                done++;
+                continue;
+            }
+            done += result;
+            target.sent += result;
+            engine.GetCounters().Add(CounterRelayed, static_cast<uint64_t>(result));
+        }
+#endif
+        target.count = 0;
+    }
+
+    void CloseSockets() {
+        for (Target& target : targets) {
+#ifdef _WIN32
+            if (target.socket != INVALID_SOCKET) closesocket(target.socket);
+#else
+            if (target.socket >= 0) close(target.socket);
+#endif
+        }
+        targets.clear();
+    }
+
+public:
+    explicit DatagramRelay(OSCEngine& eng) : engine(eng) {}
+    ~DatagramRelay() { CloseSockets(); }
+
+    // Opens one non-blocking, unconnected socket per destination, so ICMP
+    // port-unreachable replies from an absent destination don't turn into
+    // send errors. On Windows the caller has already called WSAStartup().
+    bool Open(const std::vector<RelayDestination>& destinations) {
+        CloseSockets();
+        targets.resize(destinations.size());
+        for (size_t i = 0; i < destinations.size(); i++) {
+            const Endpoint& endpoint = destinations[i].endpoint;
+            Target& target = targets[i];
+            target.name = FormatEndpointAddress(endpoint);
+            target.filter = destinations[i].filter;
+
+            MulticastInterface iface;
+            std::string error;
+            if (!ResolveEndpointAddress(endpoint, target.address, error) ||
+                (target.address.multicast && !ResolveMulticastInterface(endpoint.interfaceName, target.address.family, iface, error))) {
+                engine.Log(LogError, "Relay destination " + target.name + ": " + error);
+                CloseSockets();
+                return false;
+            }
+
+#ifdef _WIN32
+            target.socket = socket(target.address.family, SOCK_DGRAM, IPPROTO_UDP);
+            u_long nonBlocking = 1;
+            if (target.socket == INVALID_SOCKET || ioctlsocket(target.socket, FIONBIO, &nonBlocking) == SOCKET_ERROR) {
+                engine.Log(LogError, "Relay socket creation failed - Error: " + std::to_string(WSAGetLastError()));
+#else
+            target.socket = socket(target.address.family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP);
+            if (target.socket < 0) {
+                engine.Log(LogError, "Relay socket creation failed - Error: " + std::to_string(errno));
+#endif
+                CloseSockets();
+                return false;
+            }
+            if (target.address.multicast && !endpoint.interfaceName.empty() && !SetMulticastSendInterface(target.socket, target.address.family, iface)) {
+                engine.Log(LogError, "Relay to " + target.name + ": cannot send multicast on " + endpoint.interfaceName);
+                CloseSockets();
+                return false;
+            }
+
+            target.pending.resize(kMaxPending);
+#ifndef _WIN32
+            target.headers.assign(kMaxPending, mmsghdr());
+            for (int slot = 0; slot < kMaxPending; slot++) {
+                msghdr& msg = target.headers[slot].msg_hdr;
+                msg.msg_name = &target.address.destination;
+                msg.msg_namelen = target.address.bindLength;
+                msg.msg_iov = &target.pending[slot];
+                msg.msg_iovlen = 1;
+            }
+#endif
+            engine.LogStatus("Relaying " + std::string(RelayFilterName(target.filter)) + " datagrams to " + target.name);
+        }
+        return true;
+    }
+
+    bool Active() const { return !targets.empty(); }
+
+    // matched: whether any rule matched the datagram. data must stay valid
+    // until the next Flush(), which happens here if a destination is full.
+    void Queue(const char* data, int length, bool matched) {
+        for (Target& target : targets) {
+            if ((target.filter == RelayMatched && !matched) || (target.filter == RelayUnmatched && matched)) continue;
+            if (target.count == kMaxPending) Send(target);
+#ifdef _WIN32
+            target.pending[target.count].buf = const_cast<char*>(data);
+            target.pending[target.count].len = static_cast<ULONG>(length);
+#else
+            target.pending[target.count].iov_base = const_cast<char*>(data);
+            target.pending[target.count].iov_len = static_cast<size_t>(length);
+#endif
+            target.count++;
+        }
+    }
+
+    void Flush() {
+        for (Target& target : targets) {
+            if (target.count) Send(target);
+        }
+    }
+
+    void LogTotals() const {
+        for (const Target& target : targets) {
+            engine.LogStatus("Relayed " + std::to_string(target.sent) + " datagram(s) to " + target.name +
+                             (target.dropped ? ", dropped " + std::to_string(target.dropped) : std::string()));
+        }
+    }
+
+    void Close() { CloseSockets(); }
+};
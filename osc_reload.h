@@ -0,0 +1,174 @@
+#pragma once
+
+#include "osc_rules.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Hands immutable rule tables to the receive threads, RCU style. A reader
+// brackets each batch with Enter()/Exit(): two atomic stores and a load,
+// no lock. Publish() swaps the table pointer and then waits until no
+// reader can still be in a batch that saw the old table, which takes one
+// batch at most and nothing at all for idle readers. The old table is then
+// retired rather than freed, because queued actions may still point into
+// it; Reclaim() frees retired tables once the caller knows they don't.
+class RuleTablePublisher {
+public:
+    // One receive thread's slot: the epoch its current batch started in,
+    // or 0 between batches.
+    struct Reader {
+        std::atomic<uint64_t> epoch{0};
+    };
+
+private:
+    std::atomic<const RuleTable*> current{nullptr};
+    std::atomic<uint64_t> epoch{1};
+    std::mutex mutex; // Publishers and reader registration; never taken by Enter()/Exit()
+    std::vector<Reader*> readers;
+    std::unique_ptr<const RuleTable> live;
+    std::vector<std::unique_ptr<const RuleTable>> retired;
+    uint64_t nextVersion = 1;
+
+public:
+    void AddReader(Reader& reader) {
+        std::lock_guard<std::mutex> lock(mutex);
+        readers.push_back(&reader);
+    }
+
+    void RemoveReader(Reader& reader) {
+        std::lock_guard<std::mutex> lock(mutex);
+        readers.erase(std::remove(readers.begin(), readers.end(), &reader), readers.end());
+    }
+
+    // The store must be ordered before the pointer load, hence seq_cst.
+    const RuleTable* Enter(Reader& reader) const {
+        reader.epoch.store(epoch.load(std::memory_order_relaxed), std::memory_order_seq_cst);
+        return current.load(std::memory_order_seq_cst);
+    }
+
+    void Exit(Reader& reader) const { reader.epoch.store(0, std::memory_order_release); }
+
+    // For callers outside a batch, e.g. start-up logging. Only valid until
+    // the next Publish() on another thread.
+    const RuleTable& Current() const { return *current.load(std::memory_order_acquire); }
+
+    void Publish(std::unique_ptr<RuleTable> table) {
+        std::lock_guard<std::mutex> lock(mutex);
+        table->SetVersion(nextVersion++);
+        current.store(table.get(), std::memory_order_seq_cst);
+        uint64_t next = epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+        for (Reader* reader : readers) {
+            for (;;) {
+                uint64_t seen = reader->epoch.load(std::memory_order_seq_cst);
+                if (seen == 0 || seen >= next) break;
+                std::this_thread::yield();
+            }
+        }
+        if (live) retired.push_back(std::move(live));
+        live = std::move(table);
+    }
+
+    // Frees the retired tables older than beforeVersion, by default all of
+    // them. Returns how many it freed.
+    size_t Reclaim(uint64_t beforeVersion = UINT64_MAX) {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t count = retired.size();
+        retired.erase(std::remove_if(retired.begin(), retired.end(),
+                                     [&](const std::unique_ptr<const RuleTable>& table) { return table->Version() < beforeVersion; }),
+                      retired.end());
+        return count - retired.size();
+    }
+
+    size_t RetiredCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return retired.size();
+    }
+};
+
+// Calls reload when a rules file changes on disk (size or modification
+// time) or when asked to with Request(), which is safe from a signal
+// handler. Checks four times a second on a thread of its own.
+class RulesFileWatcher {
+private:
+    static constexpr int kPollMs = 250;
+
+    std::string path;
+    bool watchFile;
+    std::function<void()> reload;
+    std::thread worker;
+    bool running = false;
+    std::atomic<bool> requested{false};
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+
+    struct Stamp {
+        std::filesystem::file_time_type time;
+        uintmax_t size = 0;
+        bool exists = false;
+
+        bool operator!=(const Stamp& other) const {
+            return exists != other.exists || size != other.size || time != other.time;
+        }
+    };
+
+    Stamp Read() const {
+        Stamp stamp;
+        std::error_code error;
+        stamp.time = std::filesystem::last_write_time(path, error);
+        if (error) return stamp;
+        stamp.size = std::filesystem::file_size(path, error);
+        stamp.exists = !error;
+        return stamp;
+    }
+
+public:
+    // With watchChanges false only Request() triggers a reload.
+    RulesFileWatcher(const std::string& file, bool watchChanges, std::function<void()> onReload)
+        : path(file), watchFile(watchChanges), reload(std::move(onReload)) {}
+    ~RulesFileWatcher() { Stop(); }
+
+    void Start() {
+        running = true;
+        worker = std::thread([this] {
+            Stamp last = Read();
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            while (running) {
+                wakeCondition.wait_for(lock, std::chrono::milliseconds(kPollMs));
+                if (!running) break;
+                bool changed = false;
+                if (watchFile) {
+                    Stamp stamp = Read();
+                    // A missing file is usually an editor mid-save; wait for it to come back
+                    changed = stamp.exists && stamp != last;
+                    if (stamp.exists) last = stamp;
+                }
+                if (requested.exchange(false) || changed) {
+                    lock.unlock();
+                    reload();
+                    lock.lock();
+                }
+            }
+        });
+    }
+
+    void Request() { requested = true; }
+
+    void Stop() {
+        if (!worker.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            running = false;
+        }
+        wakeCondition.notify_one();
+        worker.join();
+    }
+};
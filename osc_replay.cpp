@@ -0,0 +1,282 @@
+// Replays a capture recorded with "osc_trigger_cli --capture FILE", either
+// straight into the engine or onto a UDP socket, at the recorded pace, N
+// times faster, or as fast as possible. Build with
+//   g++ -O2 -std=c++17 -pthread osc_replay.cpp -o osc_replay
+// or cl /O2 /EHsc /std:c++17 osc_replay.cpp /link ws2_32.lib user32.lib
+#include "osc_capture.h"
+#include "osc_engine.h"
+#include "osc_sockaddr.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#ifdef _WIN32
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+
+struct ReplayOptions {
+    std::string captureFile;
+    double rate = 1.0;       // 0 = as fast as possible
+    std::string udpTarget;   // IP:PORT[@IF], empty = feed the engine directly
+    int loops = 1;
+    LogLevel logLevel = LogWarning;
+};
+
+void PrintUsage(const char* program) {
+    printf("Usage: %s CAPTURE [options]\n"
+           "  --rate R           1 = recorded pace, N = N times faster, max = no pacing (default 1)\n"
+           "  --udp IP:PORT[@IF] Send the datagrams to a socket instead of the local engine; IPv6 in\n"
+           "                     [brackets], a multicast group is sent out of interface IF\n"
+           "  --loops N          Replay the capture N times (default 1)\n"
+           "  --address PATH     OSC address to match (default /flair/runstate)\n"
+           "  --value [OP]N      Target value, optionally after ==, !=, >, >=, < or <= (default 9),\n"
+           "                     or a condition as in osc_trigger_cli --value\n"
+           "  --key KEY          Trigger key (default SPACE)\n"
+           "  --rule SPEC        Add a rule, as for osc_trigger_cli (repeatable)\n"
+           "  --rules FILE       Add the rules in FILE, as for osc_trigger_cli\n"
+           "  --listen NAME=IP:PORT  Declare an endpoint, as for osc_trigger_cli, so endpoint= rules\n"
+           "                     match the datagrams it captured (repeatable, same order)\n"
+           "  --no-default-rule  Use only --rule rules\n"
+           "  --log-level LEVEL  debug, info, warning or error (default warning)\n"
+           "  --help             Show this message\n"
+           "Engine replay always runs in continuous mode and counts every trigger.\n", program);
+}
+
+bool ParseArguments(int argc, char** argv, Config& config, ReplayOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--no-default-rule") {
+            config.oscAddress.clear();
+        } else if (arg == "--help" || arg == "-h") {
+            return false;
+        } else if (arg.compare(0, 2, "--") != 0) {
+            options.captureFile = arg;
+        } else if (!hasValue) {
+            fprintf(stderr, "Missing value for %s\n", arg.c_str());
+            return false;
+        } else if (arg == "--rate") {
+            std::string rate = argv[++i];
+            options.rate = rate == "max" ? 0.0 : atof(rate.c_str());
+            if (rate != "max" && options.rate <= 0) {
+                fprintf(stderr, "Invalid rate: %s\n", rate.c_str());
+                return false;
+            }
+        } else if (arg == "--udp") {
+            options.udpTarget = argv[++i];
+        } else if (arg == "--loops") {
+            options.loops = (std::max)(1, atoi(argv[++i]));
+        } else if (arg == "--address") {
+            config.oscAddress = argv[++i];
+        } else if (arg == "--value") {
+            std::string error;
+            if (!ParseRuleValue(argv[++i], config.compareOp, config.targetValue, config.condition, error)) {
+                fprintf(stderr, "Invalid value %s: %s\n", argv[i], error.c_str());
+                return false;
+            }
+        } else if (arg == "--key") {
+            config.keyString = argv[++i];
+        } else if (arg == "--rule") {
+            TriggerRule rule;
+            std::string error;
+            if (!ParseRule(argv[++i], rule, error)) {
+                fprintf(stderr, "Invalid rule \"%s\": %s\n", argv[i], error.c_str());
+                return false;
+            }
+            config.rules.push_back(rule);
+        } else if (arg == "--rules") {
+            std::string error;
+            if (!LoadRulesFile(argv[++i], config.rules, error)) {
+                fprintf(stderr, "%s\n", error.c_str());
+                return false;
+            }
+        } else if (arg == "--listen") {
+            Endpoint endpoint;
+            std::string error;
+            if (!ParseEndpoint(argv[++i], endpoint, error)) {
+                fprintf(stderr, "Invalid endpoint: %s\n", error.c_str());
+                return false;
+            }
+            config.extraEndpoints.push_back(endpoint);
+        } else if (arg == "--log-level") {
+            if (!ParseLogLevel(argv[++i], options.logLevel)) {
+                fprintf(stderr, "Unknown log level: %s\n", argv[i]);
+                return false;
+            }
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", arg.c_str());
+            return false;
+        }
+    }
+
+    if (options.captureFile.empty()) {
+        fprintf(stderr, "No capture file given\n");
+        return false;
+    }
+    if (!IsValidKeyString(config.keyString)) {
+        fprintf(stderr, "Invalid key combination: %s\n", config.keyString.c_str());
+        return false;
+    }
+    ParseKeyString(config.keyString, config);
+    config.continuousMode = true;
+    return true;
+}
+
+// Unconnected UDP sender for --udp mode, so ICMP port-unreachable replies
+// from an absent receiver don't surface as send errors.
+class UdpSender {
+private:
+#ifdef _WIN32
+    SOCKET udpSocket = INVALID_SOCKET;
+#else
+    int udpSocket = -1;
+#endif
+    EndpointAddress address;
+
+public:
+    ~UdpSender() {
+#ifdef _WIN32
+        if (udpSocket != INVALID_SOCKET) closesocket(udpSocket);
+        WSACleanup();
+#else
+        if (udpSocket >= 0) close(udpSocket);
+#endif
+    }
+
+    bool Open(const std::string& target, std::string& error) {
+        Endpoint endpoint;
+        MulticastInterface iface;
+        if (!ParseEndpoint(target, endpoint, error) || !ResolveEndpointAddress(endpoint, address, error) ||
+            (address.multicast && !ResolveMulticastInterface(endpoint.interfaceName, address.family, iface, error))) {
+            return false;
+        }
+
+#ifdef _WIN32
+        WSADATA wsaData;
+        WSAStartup(MAKEWORD(2, 2), &wsaData);
+        udpSocket = socket(address.family, SOCK_DGRAM, IPPROTO_UDP);
+        if (udpSocket == INVALID_SOCKET) {
+            error = "Socket creation failed - Error: " + std::to_string(WSAGetLastError());
+            return false;
+        }
+#else
+        udpSocket = socket(address.family, SOCK_DGRAM, IPPROTO_UDP);
+        if (udpSocket < 0) {
+            error = "Socket creation failed - Error: " + std::to_string(errno);
+            return false;
+        }
+#endif
+        if (address.multicast && !endpoint.interfaceName.empty() && !SetMulticastSendInterface(udpSocket, address.family, iface)) {
+            error = "Cannot send multicast on " + endpoint.interfaceName;
+            return false;
+        }
+        return true;
+    }
+
+    bool Send(const char* data, int length) {
+        return sendto(udpSocket, data, length, 0, (sockaddr*)&address.destination, address.bindLength) == length;
+    }
+};
+
+int main(int argc, char** argv) {
+    Config config;
+    ReplayOptions options;
+    if (!ParseArguments(argc, argv, config, options)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    CaptureReader reader;
+    std::string error;
+    if (!reader.Open(options.captureFile, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    LogRing log(4096, options.logLevel);
+    LogWriterThread logWriter(log, stdout);
+    logWriter.Start();
+
+    uint64_t triggers = 0;
+    OSCEngine engine(log, [&triggers](const TriggerRule&, uint64_t, uint64_t) { triggers++; });
+    UdpSender sender;
+    bool toSocket = !options.udpTarget.empty();
+    if (toSocket) {
+        if (!sender.Open(options.udpTarget, error)) {
+            fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+    } else {
+        engine.Reset(config);
+    }
+
+    uint64_t datagrams = 0;
+    uint64_t bytes = 0;
+    uint64_t sendErrors = 0;
+    uint64_t maxLateNs = 0;
+    uint64_t busyNs = 0; // Time spent inside the engine or send()
+    uint64_t startNs = SteadyNowNs();
+
+    for (int loop = 0; loop < options.loops; loop++) {
+        reader.Rewind();
+        CaptureRecord record;
+        uint64_t firstNs = 0;
+        uint64_t loopStartNs = SteadyNowNs();
+        bool first = true;
+
+        while (reader.Next(record)) {
+            if (first) {
+                firstNs = record.receivedNs;
+                first = false;
+            }
+
+            if (options.rate > 0) {
+                uint64_t offsetNs = static_cast<uint64_t>((record.receivedNs - firstNs) / options.rate);
+                uint64_t dueNs = loopStartNs + offsetNs;
+                uint64_t now = SteadyNowNs();
+                if (now < dueNs) {
+                    std::this_thread::sleep_for(std::chrono::nanoseconds(dueNs - now));
+                }
+                now = SteadyNowNs();
+                if (now > dueNs) maxLateNs = (std::max)(maxLateNs, now - dueNs);
+            }
+
+            uint64_t before = SteadyNowNs();
+            if (toSocket) {
+                if (!sender.Send(record.data, record.length)) sendErrors++;
+            } else {
+                engine.ProcessOSCData(record.data, record.length, before, record.endpoint);
+            }
+            busyNs += SteadyNowNs() - before;
+
+            datagrams++;
+            bytes += record.length;
+        }
+    }
+
+    double elapsedSec = (SteadyNowNs() - startNs) / 1e9;
+    logWriter.Stop();
+
+    printf("Replayed %llu datagram(s), %llu bytes in %.3f s (%.0f datagrams/sec)\n",
+           (unsigned long long)datagrams, (unsigned long long)bytes, elapsedSec,
+           elapsedSec > 0 ? datagrams / elapsedSec : 0.0);
+    if (datagrams > 0) {
+        printf("%s cost: %.0f ns/datagram\n", toSocket ? "send()" : "Engine", (double)busyNs / datagrams);
+    }
+    if (options.rate > 0) {
+        printf("Pacing: %gx, max %.0f us behind schedule\n", options.rate, maxLateNs / 1e3);
+    }
+    if (toSocket) {
+        printf("Sent to %s, %llu send error(s)\n", options.udpTarget.c_str(), (unsigned long long)sendErrors);
+    } else {
+        printf("Triggers: %llu from %zu rule(s)\n", (unsigned long long)triggers, engine.GetRules().Size());
+    }
+    return 0;
+}
@@ -0,0 +1,450 @@
+#pragma once
+
+#include "osc_keys.h"
+#include "osc_pattern.h"
+#include "osc_predicate.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// One trigger: an OSC address, a predicate on one argument (or any or all
+// of them), and the key combination to send when it matches.
+struct TriggerRule {
+    std::string address;
+    int argIndex = 0; // Flat argument index, kArgAny or kArgAll
+    CompareOp op = CompareEqual;
+    double targetValue = 9;
+    std::string condition;               // Replaces op/targetValue when set; see PredicateProgram
+    double tolerance = kDefaultTolerance; // Float == and != match within this
+    std::string keyString = "SPACE";
+    int triggerKey = VK_SPACE;
+    bool useCtrl = false;
+    bool useShift = false;
+    bool useAlt = false;
+    std::string windowTitle;
+    std::string endpoint;   // Only datagrams from the listen endpoint with this name (empty = any)
+    int endpointIndex = -1; // endpoint resolved by RulesFromConfig(); -1 = any
+    bool edge = false;      // Fire on entering the target value only, not while the value stays there
+    double hysteresis = 0;  // Edge rules re-arm once the value is more than this from the target
+    int minIntervalMs = 0;  // Minimum time between fires (0 = none)
+    double ratePerSec = 0;  // Token bucket refill rate (0 = no rate limit)
+    int rateBurst = 1;      // Token bucket size: fires allowed back to back
+
+    bool HasFireLimits() const { return edge || minIntervalMs > 0 || ratePerSec > 0; }
+};
+
+// "= 9", "> 0.9", "any > 0.9", "arg 17 = 1" for log lines. Conditions
+// are shown as written.
+inline void FormatPredicate(const TriggerRule& rule, char* out, size_t size) {
+    static const char* symbols[] = {"=", "!=", ">", ">=", "<", "<="};
+    if (!rule.condition.empty()) {
+        const char* selector = rule.argIndex == kArgAny ? "any " : rule.argIndex == kArgAll ? "all " : "";
+        if (rule.argIndex > 0) snprintf(out, size, "arg %d %s", rule.argIndex, rule.condition.c_str());
+        else snprintf(out, size, "%s%s", selector, rule.condition.c_str());
+    } else if (rule.argIndex == kArgAny || rule.argIndex == kArgAll) {
+        snprintf(out, size, "%s %s %g", rule.argIndex == kArgAny ? "any" : "all", symbols[rule.op], rule.targetValue);
+    } else if (rule.argIndex != 0) {
+        snprintf(out, size, "arg %d %s %g", rule.argIndex, symbols[rule.op], rule.targetValue);
+    } else {
+        snprintf(out, size, "%s %g", symbols[rule.op], rule.targetValue);
+    }
+}
+
+// Everything that decides when and how a rule fires, as one string. A
+// reloaded table carries firing history over to a rule whose identity is
+// unchanged, so re-reading the same rules doesn't re-arm edges or refill
+// rate limits.
+inline std::string RuleIdentity(const TriggerRule& rule) {
+    char fields[256];
+    snprintf(fields, sizeof(fields), "%d %d %.17g %.17g %d %d%d%d %d %d %.17g %d %.17g %d", rule.argIndex, rule.op,
+             rule.targetValue, rule.tolerance, rule.triggerKey, rule.useCtrl, rule.useShift, rule.useAlt,
+             rule.endpointIndex, rule.edge, rule.hysteresis, rule.minIntervalMs, rule.ratePerSec, rule.rateBurst);
+    std::string identity = rule.address;
+    for (const std::string* text : {&rule.condition, &rule.keyString, &rule.windowTitle, &rule.endpoint}) {
+        identity += '\0';
+        identity += *text;
+    }
+    identity += '\0';
+    identity += fields;
+    return identity;
+}
+
+// Firing history for one rule, kept by each engine beside its shared rule
+// table. Zero-initialised means "outside the target, never fired".
+struct RuleFireState {
+    bool inTarget = false;
+    uint64_t lastFireNs = 0;
+    double tokens = 0;
+    uint64_t refillNs = 0;
+};
+
+// Applies a rule's minimum interval and token bucket at time nowNs and, if
+// both allow a fire, records it. Edge state is the engine's to update.
+inline bool TakeFireSlot(const TriggerRule& rule, RuleFireState& state, uint64_t nowNs) {
+    if (rule.minIntervalMs > 0 && state.lastFireNs != 0 &&
+        nowNs < state.lastFireNs + static_cast<uint64_t>(rule.minIntervalMs) * 1000000) {
+        return false;
+    }
+    if (rule.ratePerSec > 0) {
+        if (state.refillNs == 0) {
+            state.tokens = rule.rateBurst;
+        } else if (nowNs > state.refillNs) {
+            state.tokens = (std::min)(static_cast<double>(rule.rateBurst),
+                                      state.tokens + (nowNs - state.refillNs) * rule.ratePerSec / 1e9);
+        }
+        if (nowNs > state.refillNs) state.refillNs = nowNs;
+        if (state.tokens < 1) return false;
+        state.tokens -= 1;
+    }
+    state.lastFireNs = nowNs;
+    return true;
+}
+
+template <typename Target>
+void ParseKeyString(const std::string& keyString, Target& target) {
+    std::string upper = keyString;
+    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+
+    target.useCtrl = false;
+    target.useShift = false;
+    target.useAlt = false;
+
+    // Check for modifier keys
+    if (upper.find("CTRL+") != std::string::npos) {
+        target.useCtrl = true;
+        upper = upper.substr(upper.find("CTRL+") + 5);
+    }
+    if (upper.find("SHIFT+") != std::string::npos) {
+        target.useShift = true;
+        upper = upper.substr(upper.find("SHIFT+") + 6);
+    }
+    if (upper.find("ALT+") != std::string::npos) {
+        target.useAlt = true;
+        upper = upper.substr(upper.find("ALT+") + 4);
+    }
+
+    target.triggerKey = StringToVK(upper);
+}
+
+// Splits a rule line on whitespace, keeping "double quoted" runs together.
+inline std::vector<std::string> TokenizeRuleLine(const std::string& line) {
+    std::vector<std::string> tokens;
+    std::string current;
+    bool inQuotes = false;
+    bool hasToken = false;
+
+    for (char c : line) {
+        if (c == '"') {
+            inQuotes = !inQuotes;
+            hasToken = true;
+        } else if (!inQuotes && (c == ' ' || c == '\t' || c == '\r' || c == '\n')) {
+            if (hasToken) tokens.push_back(current);
+            current.clear();
+            hasToken = false;
+        } else {
+            current += c;
+            hasToken = true;
+        }
+    }
+    if (hasToken) tokens.push_back(current);
+    return tokens;
+}
+
+// Parses "ADDRESS VALUE KEY [arg=N|any|all] [tolerance=X] [window=TITLE]
+// [endpoint=NAME] [edge] [hysteresis=X] [interval=MS] [rate=N[/BURST]]
+// [burst=N]". VALUE may carry a comparison, e.g. ">0.9", or be a range,
+// string, boolean or clause list (see PredicateProgram), quoted if it has
+// spaces. Any field may also be given as name=value (address=, value=,
+// key=). Returns false and fills error if the line is malformed.
+inline bool ParseRule(const std::string& line, TriggerRule& rule, std::string& error) {
+    std::vector<std::string> tokens = TokenizeRuleLine(line);
+    int positional = 0;
+
+    for (const std::string& token : tokens) {
+        size_t eq = token.find('=');
+        if (token.empty() || !isalpha(static_cast<unsigned char>(token[0])) ||
+            token.find_first_not_of("abcdefghijklmnopqrstuvwxyz") < eq) {
+            eq = std::string::npos; // ">=0.5" and "any:>=0.5" are values
+        }
+        std::string name = eq == std::string::npos ? "" : token.substr(0, eq);
+        std::string value = eq == std::string::npos ? token : token.substr(eq + 1);
+
+        if (name.empty() && value == "edge") {
+            rule.edge = true;
+            continue;
+        }
+        if (name.empty()) {
+            if (positional == 0) name = "address";
+            else if (positional == 1) name = "value";
+            else if (positional == 2) name = "key";
+            else {
+                error = "Unexpected token: " + token;
+                return false;
+            }
+            positional++;
+        }
+
+        if (name == "address") {
+            rule.address = value;
+        } else if (name == "value") {
+            std::string reason;
+            if (!ParseRuleValue(value, rule.op, rule.targetValue, rule.condition, reason)) {
+                error = "Invalid value: " + value + " (" + reason + ")";
+                return false;
+            }
+        } else if (name == "key") {
+            rule.keyString = value;
+        } else if (name == "arg") {
+            if (!ParseArgSelector(value, rule.argIndex)) {
+                error = "Invalid arg (expected an index, any or all): " + value;
+                return false;
+            }
+        } else if (name == "tolerance") {
+            rule.tolerance = atof(value.c_str());
+        } else if (name == "window") {
+            rule.windowTitle = value;
+        } else if (name == "endpoint") {
+            rule.endpoint = value;
+        } else if (name == "edge") {
+            rule.edge = value != "0" && value != "off";
+        } else if (name == "hysteresis") {
+            rule.hysteresis = atof(value.c_str());
+        } else if (name == "interval") {
+            rule.minIntervalMs = atoi(value.c_str());
+        } else if (name == "rate") {
+            rule.ratePerSec = atof(value.c_str());
+            size_t slash = value.find('/');
+            if (slash != std::string::npos) rule.rateBurst = atoi(value.c_str() + slash + 1);
+        } else if (name == "burst") {
+            rule.rateBurst = atoi(value.c_str());
+        } else {
+            error = "Unknown field: " + name;
+            return false;
+        }
+    }
+
+    if (rule.address.empty() || rule.address[0] != '/') {
+        error = "Rule address must start with '/'";
+        return false;
+    }
+    if (IsAddressPattern(rule.address) && !CompiledPattern().Compile(rule.address)) {
+        error = "Invalid address pattern: " + rule.address;
+        return false;
+    }
+    if (rule.hysteresis < 0 || rule.tolerance < 0 || rule.minIntervalMs < 0 || rule.ratePerSec < 0 || rule.rateBurst < 1) {
+        error = "Negative tolerance or limit, or burst below 1, in rule " + rule.address;
+        return false;
+    }
+    if (!IsValidKeyString(rule.keyString)) {
+        error = "Invalid key combination: " + rule.keyString;
+        return false;
+    }
+    ParseKeyString(rule.keyString, rule);
+    return true;
+}
+
+inline uint64_t HashAddress(std::string_view address) {
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : address) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Reads a rules file: one rule per line in ParseRule() syntax, with blank
+// lines and lines starting with # ignored. All or nothing: on the first bad
+// line, returns false with "PATH:LINE: reason" in error and leaves rules
+// as it was.
+inline bool LoadRulesFile(const std::string& path, std::vector<TriggerRule>& rules, std::string& error) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        error = "Cannot open rules file " + path;
+        return false;
+    }
+    std::vector<TriggerRule> loaded;
+    std::string line;
+    int lineNumber = 0;
+    bool ok = true;
+    for (int c = fgetc(file);; c = fgetc(file)) {
+        if (c != '\n' && c != EOF) {
+            line += static_cast<char>(c);
+            continue;
+        }
+        lineNumber++;
+        size_t start = line.find_first_not_of(" \t\r");
+        if (start != std::string::npos && line[start] != '#') {
+            TriggerRule rule;
+            std::string reason;
+            if (!ParseRule(line, rule, reason)) {
+                error = path + ":" + std::to_string(lineNumber) + ": " + reason;
+                ok = false;
+                break;
+            }
+            loaded.push_back(rule);
+        }
+        line.clear();
+        if (c == EOF) break;
+    }
+    fclose(file);
+    if (ok) rules.insert(rules.end(), loaded.begin(), loaded.end());
+    return ok;
+}
+
+// Immutable address -> rules index, built once per Start() and again for
+// every rules reload (see RuleTablePublisher). Open addressing
+// with linear probing at <= 50% load, so a lookup is one hash of the
+// incoming address plus (almost always) a single slot compare, however
+// many rules are loaded. Rules whose address is a pattern are compiled
+// here too and merged into a PatternTrie for MatchPatterns(), and every
+// rule's predicate is compiled into one PredicateProgram.
+class RuleTable {
+private:
+    struct Slot {
+        uint64_t hash = 0;
+        std::string_view address; // Points into rules[]
+        int first = 0;            // Range in ruleOrder
+        int count = 0;
+    };
+
+    std::vector<TriggerRule> rules;
+    std::vector<int> ruleOrder; // Rule indices grouped by address
+    std::vector<Slot> slots;
+    uint64_t mask = 0;
+
+    PatternTrie patterns;
+    std::vector<int> patternRules; // Rule index per pattern in the trie
+    PredicateProgram predicates;
+    std::vector<std::pair<int, int>> predicateRuns; // Per rule: first clause and clause count
+    std::vector<std::string> identities;            // Per rule: RuleIdentity()
+    uint64_t version = 0; // Set when published; lets readers notice a new table
+
+public:
+    // Rules with an invalid pattern are left out, and rules with an invalid
+    // condition never match; the reasons are appended to rejected.
+    void Build(const std::vector<TriggerRule>& newRules, std::vector<std::string>* rejected = nullptr) {
+        rules = newRules;
+        ruleOrder.clear();
+        slots.clear();
+        patterns.Clear();
+        patternRules.clear();
+        predicates.Clear();
+        predicateRuns.assign(rules.size(), std::make_pair(0, 0));
+        identities.clear();
+        for (const TriggerRule& rule : rules) identities.push_back(RuleIdentity(rule));
+
+        for (size_t i = 0; i < rules.size(); i++) {
+            const TriggerRule& rule = rules[i];
+            std::pair<int, int>& run = predicateRuns[i];
+            std::string error;
+            if (rule.condition.empty()) {
+                run = std::make_pair(predicates.AddComparison(rule.argIndex, rule.op, rule.targetValue, rule.tolerance), 1);
+            } else if (!predicates.AddCondition(rule.condition, rule.argIndex, rule.tolerance, run.first, run.second, error)) {
+                if (rejected) rejected->push_back("Ignoring rule " + rule.address + " with invalid condition: " + error);
+            }
+        }
+
+        size_t capacity = 8;
+        while (capacity < rules.size() * 2) capacity <<= 1;
+        slots.assign(capacity, Slot());
+        mask = capacity - 1;
+
+        // Group rules that share an address so each slot owns one contiguous
+        // range: count each address's rules in its slot, hand out ranges in
+        // order of first appearance, then fill them in rule order
+        std::vector<int> ruleSlots(rules.size(), -1);
+        std::vector<int> slotOrder;
+        for (size_t i = 0; i < rules.size(); i++) {
+            if (IsAddressPattern(rules[i].address)) {
+                CompiledPattern pattern;
+                if (!pattern.Compile(rules[i].address)) {
+                    if (rejected) rejected->push_back("Ignoring invalid address pattern: " + rules[i].address);
+                    continue;
+                }
+                patterns.Add(std::move(pattern));
+                patternRules.push_back(static_cast<int>(i));
+                continue;
+            }
+
+            std::string_view address = rules[i].address;
+            uint64_t hash = HashAddress(address);
+            size_t s = hash & mask;
+            while (slots[s].count != 0 && !(slots[s].hash == hash && slots[s].address == address)) {
+                s = (s + 1) & mask;
+            }
+            if (slots[s].count == 0) {
+                slots[s].hash = hash;
+                slots[s].address = address;
+                slotOrder.push_back(static_cast<int>(s));
+            }
+            slots[s].count++;
+            ruleSlots[i] = static_cast<int>(s);
+        }
+
+        int placed = 0;
+        for (int s : slotOrder) {
+            slots[s].first = placed;
+            placed += slots[s].count;
+        }
+        ruleOrder.resize(placed);
+        std::vector<int> filled(slots.size(), 0);
+        for (size_t i = 0; i < rules.size(); i++) {
+            int s = ruleSlots[i];
+            if (s >= 0) ruleOrder[slots[s].first + filled[s]++] = static_cast<int>(i);
+        }
+    }
+
+    // Returns the number of exact-address rules for address and points
+    // first at their indices. hash must be HashAddress(address).
+    int Lookup(std::string_view address, uint64_t hash, const int*& first) const {
+        for (uint64_t i = hash & mask;; i = (i + 1) & mask) {
+            const Slot& slot = slots[i];
+            if (slot.count == 0) return 0;
+            if (slot.hash == hash && slot.address == address) {
+                first = ruleOrder.data() + slot.first;
+                return slot.count;
+            }
+        }
+    }
+
+    int Lookup(std::string_view address, const int*& first) const {
+        return Lookup(address, HashAddress(address), first);
+    }
+
+    bool HasPatterns() const { return !patterns.Empty(); }
+    size_t PatternCount() const { return patterns.Size(); }
+
+    // Walks the pattern trie for a concrete address and collects the
+    // indices of the rules that match, in rule order.
+    void MatchPatterns(std::string_view address, std::vector<int>& matched) const {
+        matched.clear();
+        patterns.Match(address, matched);
+        for (int& match : matched) match = patternRules[match];
+        std::sort(matched.begin(), matched.end());
+    }
+
+    const TriggerRule& Rule(int index) const { return rules[index]; }
+
+    // A rule's compiled predicate: count clauses from the returned one.
+    // A rule whose condition didn't compile has none.
+    const PredicateClause* Predicate(int index, int& count) const {
+        count = predicateRuns[index].second;
+        return predicates.Clauses() + predicateRuns[index].first;
+    }
+
+    const PredicateProgram& Predicates() const { return predicates; }
+    const std::string& Identity(int index) const { return identities[index]; }
+    size_t Size() const { return rules.size(); }
+
+    void SetVersion(uint64_t publishedVersion) { version = publishedVersion; }
+    uint64_t Version() const { return version; }
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define OSC_BSWAP_AVX2
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#define OSC_BSWAP_SSSE3
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define OSC_BSWAP_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define OSC_BSWAP_NEON
+#endif
+
+// Byte-swaps runs of big-endian 32-bit words, the encoding of OSC 'i' and
+// 'f' arguments. The kernel is picked at compile time: AVX2 or SSSE3 when
+// the compiler targets them (-mavx2, /arch:AVX2), else SSE2, which every
+// x86-64 compiler assumes, or NEON on ARM, else plain C++.
+
+// One word at a time; also finishes the vector kernels' tails.
+inline void ByteSwap32RunScalar(const char* src, uint32_t* dst, int count) {
+    for (int i = 0; i < count; i++) {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(src) + i * 4;
+        dst[i] = (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+                 (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+    }
+}
+
+// dst[i] = the big-endian word at src + 4 * i. src need not be aligned.
+inline void ByteSwap32Run(const char* src, uint32_t* dst, int count) {
+    int i = 0;
+#if defined(OSC_BSWAP_AVX2)
+    const __m256i order = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                           3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    for (; i + 8 <= count; i += 8) {
+        __m256i words = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_shuffle_epi8(words, order));
+    }
+#elif defined(OSC_BSWAP_SSSE3)
+    const __m128i order = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    for (; i + 4 <= count; i += 4) {
+        __m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_shuffle_epi8(words, order));
+    }
+#elif defined(OSC_BSWAP_SSE2)
+    // No byte shuffle: swap the bytes of each 16-bit half, then the halves
+    for (; i + 4 <= count; i += 4) {
+        __m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+        words = _mm_or_si128(_mm_slli_epi16(words, 8), _mm_srli_epi16(words, 8));
+        words = _mm_shufflelo_epi16(words, _MM_SHUFFLE(2, 3, 0, 1));
+        words = _mm_shufflehi_epi16(words, _MM_SHUFFLE(2, 3, 0, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), words);
+    }
+#elif defined(OSC_BSWAP_NEON)
+    for (; i + 4 <= count; i += 4) {
+        uint8x16_t words = vld1q_u8(reinterpret_cast<const uint8_t*>(src) + i * 4);
+        vst1q_u8(reinterpret_cast<uint8_t*>(dst + i), vrev32q_u8(words));
+    }
+#endif
+    ByteSwap32RunScalar(src + i * 4, dst + i, count - i);
+}
+
+inline const char* ByteSwapKernelName() {
+#if defined(OSC_BSWAP_AVX2)
+    return "AVX2";
+#elif defined(OSC_BSWAP_SSSE3)
+    return "SSSE3";
+#elif defined(OSC_BSWAP_SSE2)
+    return "SSE2";
+#elif defined(OSC_BSWAP_NEON)
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,199 @@
+#pragma once
+
+#include "osc_dispatch.h"
+#include "osc_window.h"
+#include <mutex>
+#include <string>
+#include <vector>
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/uinput.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+// Drops every action; the engine's TRIGGER log line is the only output.
+class NullSink : public ActionSink {
+public:
+    void Fire(const TriggerRule&) override {}
+};
+
+// Keeps every fired action in memory, for benchmarks and dry runs.
+class RecordingSink : public ActionSink {
+public:
+    struct Record {
+        std::string address;
+        int triggerKey = 0;
+        bool useCtrl = false;
+        bool useShift = false;
+        bool useAlt = false;
+        uint64_t firedNs = 0;
+    };
+
+private:
+    mutable std::mutex mutex;
+    std::vector<Record> records;
+
+public:
+    void Fire(const TriggerRule& rule) override {
+        Record record;
+        record.address = rule.address;
+        record.triggerKey = rule.triggerKey;
+        record.useCtrl = rule.useCtrl;
+        record.useShift = rule.useShift;
+        record.useAlt = rule.useAlt;
+        record.firedNs = SteadyNowNs();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        records.push_back(std::move(record));
+    }
+
+    size_t Count() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return records.size();
+    }
+
+    std::vector<Record> Records() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return records;
+    }
+
+    void Clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        records.clear();
+    }
+};
+
+#ifdef _WIN32
+// Focuses the rule's target window and injects its key combination. The
+// window is found once per title and revalidated on later triggers.
+class Win32KeySink : public ActionSink {
+private:
+    Win32WindowRegistry windows;
+    CachedWindowResolver resolver{windows};
+
+public:
+    void Fire(const TriggerRule& rule) override {
+        HWND window = reinterpret_cast<HWND>(resolver.Resolve(rule.windowTitle));
+        if (window) {
+            SetForegroundWindow(window);
+        }
+        SendKeyCombo(rule.triggerKey, rule.useCtrl, rule.useShift, rule.useAlt);
+    }
+};
+#endif
+
+#ifdef __linux__
+// Virtual keyboard through /dev/uinput. Keys go to whatever has focus; the
+// rule's window title is ignored. Needs write access to /dev/uinput.
+class UinputKeySink : public ActionSink {
+private:
+    int fd = -1;
+
+    static int ToEvdev(int vk) {
+        static const int letters[26] = {
+            KEY_A, KEY_B, KEY_C, KEY_D, KEY_E, KEY_F, KEY_G, KEY_H, KEY_I, KEY_J, KEY_K, KEY_L, KEY_M,
+            KEY_N, KEY_O, KEY_P, KEY_Q, KEY_R, KEY_S, KEY_T, KEY_U, KEY_V, KEY_W, KEY_X, KEY_Y, KEY_Z};
+        static const int digits[10] = {KEY_0, KEY_1, KEY_2, KEY_3, KEY_4, KEY_5, KEY_6, KEY_7, KEY_8, KEY_9};
+        static const int numpad[10] = {KEY_KP0, KEY_KP1, KEY_KP2, KEY_KP3, KEY_KP4, KEY_KP5, KEY_KP6, KEY_KP7, KEY_KP8, KEY_KP9};
+        static const int functions[12] = {KEY_F1, KEY_F2, KEY_F3, KEY_F4, KEY_F5, KEY_F6, KEY_F7, KEY_F8, KEY_F9, KEY_F10, KEY_F11, KEY_F12};
+
+        if (vk >= 'A' && vk <= 'Z') return letters[vk - 'A'];
+        if (vk >= '0' && vk <= '9') return digits[vk - '0'];
+        if (vk >= VK_NUMPAD0 && vk <= VK_NUMPAD9) return numpad[vk - VK_NUMPAD0];
+        if (vk >= VK_F1 && vk <= VK_F12) return functions[vk - VK_F1];
+
+        switch (vk) {
+        case VK_BACK: return KEY_BACKSPACE;
+        case VK_TAB: return KEY_TAB;
+        case VK_RETURN: return KEY_ENTER;
+        case VK_SHIFT: return KEY_LEFTSHIFT;
+        case VK_CONTROL: return KEY_LEFTCTRL;
+        case VK_MENU: return KEY_LEFTALT;
+        case VK_ESCAPE: return KEY_ESC;
+        case VK_SPACE: return KEY_SPACE;
+        case VK_PRIOR: return KEY_PAGEUP;
+        case VK_NEXT: return KEY_PAGEDOWN;
+        case VK_END: return KEY_END;
+        case VK_HOME: return KEY_HOME;
+        case VK_LEFT: return KEY_LEFT;
+        case VK_UP: return KEY_UP;
+        case VK_RIGHT: return KEY_RIGHT;
+        case VK_DOWN: return KEY_DOWN;
+        case VK_INSERT: return KEY_INSERT;
+        case VK_DELETE: return KEY_DELETE;
+        default: return -1;
+        }
+    }
+
+    void Emit(int type, int code, int value) {
+        input_event event;
+        memset(&event, 0, sizeof(event));
+        event.type = static_cast<unsigned short>(type);
+        event.code = static_cast<unsigned short>(code);
+        event.value = value;
+        ssize_t ignored = write(fd, &event, sizeof(event));
+        (void)ignored;
+    }
+
+    void Key(int code, int value) {
+        Emit(EV_KEY, code, value);
+        Emit(EV_SYN, SYN_REPORT, 0);
+    }
+
+public:
+    ~UinputKeySink() {
+        if (fd >= 0) {
+            ioctl(fd, UI_DEV_DESTROY);
+            close(fd);
+        }
+    }
+
+    bool Open(std::string& error) {
+        fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) {
+            error = "Cannot open /dev/uinput - Error: " + std::to_string(errno);
+            return false;
+        }
+
+        ioctl(fd, UI_SET_EVBIT, EV_KEY);
+        for (int vk = 0; vk < 256; vk++) {
+            int code = ToEvdev(vk);
+            if (code >= 0) ioctl(fd, UI_SET_KEYBIT, code);
+        }
+
+        uinput_setup setup;
+        memset(&setup, 0, sizeof(setup));
+        setup.id.bustype = BUS_VIRTUAL;
+        strncpy(setup.name, "OSC Trigger virtual keyboard", UINPUT_MAX_NAME_SIZE - 1);
+        if (ioctl(fd, UI_DEV_SETUP, &setup) < 0 || ioctl(fd, UI_DEV_CREATE) < 0) {
+            error = "Cannot create uinput device - Error: " + std::to_string(errno);
+            close(fd);
+            fd = -1;
+            return false;
+        }
+        return true;
+    }
+
+    void Fire(const TriggerRule& rule) override {
+        int code = ToEvdev(rule.triggerKey);
+        if (fd < 0 || code < 0) return;
+
+        // Press modifier keys
+        if (rule.useCtrl) Key(KEY_LEFTCTRL, 1);
+        if (rule.useShift) Key(KEY_LEFTSHIFT, 1);
+        if (rule.useAlt) Key(KEY_LEFTALT, 1);
+
+        // Press main key
+        Key(code, 1);
+        Key(code, 0);
+
+        // Release modifier keys
+        if (rule.useAlt) Key(KEY_LEFTALT, 0);
+        if (rule.useShift) Key(KEY_LEFTSHIFT, 0);
+        if (rule.useCtrl) Key(KEY_LEFTCTRL, 0);
+    }
+};
+#endif
@@ -0,0 +1,184 @@
+#pragma once
+
+#include "osc_engine.h"
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
+// An endpoint's address in socket form: what to bind and, when the endpoint
+// address is a multicast group, which group to join on which interface.
+struct EndpointAddress {
+    sockaddr_storage bind;
+    sockaddr_storage destination; // The address as written, for senders
+    socklen_t bindLength = 0;
+    int family = AF_INET;
+    bool multicast = false;
+    bool dualStack = false; // "::" - an IPv6 socket that also takes IPv4 (as ::ffff:a.b.c.d)
+    in_addr group4;
+    in6_addr group6;
+    std::string description; // "Binding to " + description in the log
+
+    EndpointAddress() {
+        memset(&bind, 0, sizeof(bind));
+        memset(&destination, 0, sizeof(destination));
+        memset(&group4, 0, sizeof(group4));
+        memset(&group6, 0, sizeof(group6));
+    }
+};
+
+// Resolves an endpoint's ipAddress, which may be IPv4, IPv6 (optionally in
+// [brackets]), empty or 0.0.0.0 for all IPv4 interfaces, :: for all
+// interfaces dual-stack, or a multicast group of either family. Linux binds
+// a group socket to the group address so sockets for other groups on the
+// same port don't see its traffic; Windows only allows binding the wildcard.
+inline bool ResolveEndpointAddress(const Endpoint& endpoint, EndpointAddress& out, std::string& error) {
+    std::string ip = endpoint.ipAddress;
+    if (ip.size() >= 2 && ip.front() == '[' && ip.back() == ']') ip = ip.substr(1, ip.size() - 2);
+    out = EndpointAddress();
+    uint16_t port = htons(static_cast<uint16_t>(endpoint.port));
+
+    in_addr v4;
+    in6_addr v6;
+    if (ip.empty() || ip == "0.0.0.0" || inet_pton(AF_INET, ip.c_str(), &v4) == 1) {
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = port;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        if (ip.empty() || ip == "0.0.0.0") {
+            out.description = "all interfaces (0.0.0.0)";
+        } else {
+            addr.sin_addr = v4;
+            out.description = "specific IP: " + ip;
+        }
+        memcpy(&out.destination, &addr, sizeof(addr));
+        if (!ip.empty() && ip != "0.0.0.0" && IN_MULTICAST(ntohl(v4.s_addr))) {
+            out.multicast = true;
+            out.group4 = v4;
+            out.description = "multicast group " + ip;
+#ifdef _WIN32
+            addr.sin_addr.s_addr = htonl(INADDR_ANY);
+#endif
+        }
+        out.family = AF_INET;
+        memcpy(&out.bind, &addr, sizeof(addr));
+        out.bindLength = sizeof(addr);
+        return true;
+    }
+
+    if (inet_pton(AF_INET6, ip.c_str(), &v6) == 1) {
+        sockaddr_in6 addr = {};
+        addr.sin6_family = AF_INET6;
+        addr.sin6_port = port;
+        addr.sin6_addr = v6;
+        memcpy(&out.destination, &addr, sizeof(addr));
+        if (IN6_IS_ADDR_UNSPECIFIED(&v6)) {
+            out.dualStack = true;
+            out.description = "all interfaces (::), dual-stack IPv4/IPv6";
+        } else if (IN6_IS_ADDR_MULTICAST(&v6)) {
+            out.multicast = true;
+            out.group6 = v6;
+            out.description = "multicast group " + ip;
+#ifdef _WIN32
+            addr.sin6_addr = in6addr_any;
+#endif
+        } else {
+            out.description = "specific IP: " + ip;
+        }
+        out.family = AF_INET6;
+        memcpy(&out.bind, &addr, sizeof(addr));
+        out.bindLength = sizeof(addr);
+        return true;
+    }
+
+    error = "Invalid IP address: " + endpoint.ipAddress;
+    return false;
+}
+
+// Interface for a group join: empty for the system default, an interface
+// index, an IPv4 address (IPv4 groups only) or, on Linux, a name like eth0.
+struct MulticastInterface {
+    unsigned int index = 0;
+    in_addr address;
+
+    MulticastInterface() { address.s_addr = htonl(INADDR_ANY); }
+};
+
+inline bool ResolveMulticastInterface(const std::string& name, int family, MulticastInterface& out, std::string& error) {
+    out = MulticastInterface();
+    if (name.empty()) return true;
+    if (name.find_first_not_of("0123456789") == std::string::npos) {
+        out.index = static_cast<unsigned int>(atoi(name.c_str()));
+        return true;
+    }
+    if (inet_pton(AF_INET, name.c_str(), &out.address) == 1) {
+        if (family == AF_INET6) {
+            error = "IPv6 groups need an interface name or index, not " + name;
+            return false;
+        }
+        return true;
+    }
+#ifdef _WIN32
+    error = "Unknown interface " + name + "; use its index or IPv4 address";
+    return false;
+#else
+    out.index = if_nametoindex(name.c_str());
+    if (out.index == 0) {
+        error = "Unknown interface: " + name;
+        return false;
+    }
+    return true;
+#endif
+}
+
+// Joins the endpoint's group on a bound socket. On failure errno (or
+// WSAGetLastError()) says why.
+template <typename Socket>
+bool JoinMulticastGroup(Socket udpSocket, const EndpointAddress& address, const MulticastInterface& iface) {
+    if (address.family == AF_INET6) {
+        ipv6_mreq request = {};
+        request.ipv6mr_multiaddr = address.group6;
+        request.ipv6mr_interface = iface.index;
+        return setsockopt(udpSocket, IPPROTO_IPV6, IPV6_JOIN_GROUP, (const char*)&request, sizeof(request)) == 0;
+    }
+#ifdef _WIN32
+    ip_mreq request = {};
+    request.imr_multiaddr = address.group4;
+    // Winsock reads 0.0.0.N as interface index N
+    request.imr_interface.s_addr = iface.index ? htonl(iface.index) : iface.address.s_addr;
+#else
+    ip_mreqn request = {};
+    request.imr_multiaddr = address.group4;
+    request.imr_address = iface.address;
+    request.imr_ifindex = static_cast<int>(iface.index);
+#endif
+    return setsockopt(udpSocket, IPPROTO_IP, IP_ADD_MEMBERSHIP, (const char*)&request, sizeof(request)) == 0;
+}
+
+// Sends a socket's multicast datagrams out of the given interface, as
+// senders to a group on a multi-homed host need to.
+template <typename Socket>
+bool SetMulticastSendInterface(Socket udpSocket, int family, const MulticastInterface& iface) {
+    if (family == AF_INET6) {
+        unsigned int index = iface.index;
+        return setsockopt(udpSocket, IPPROTO_IPV6, IPV6_MULTICAST_IF, (const char*)&index, sizeof(index)) == 0;
+    }
+#ifdef _WIN32
+    in_addr address;
+    address.s_addr = iface.index ? htonl(iface.index) : iface.address.s_addr;
+    return setsockopt(udpSocket, IPPROTO_IP, IP_MULTICAST_IF, (const char*)&address, sizeof(address)) == 0;
+#else
+    ip_mreqn request = {};
+    request.imr_address = iface.address;
+    request.imr_ifindex = static_cast<int>(iface.index);
+    return setsockopt(udpSocket, IPPROTO_IP, IP_MULTICAST_IF, &request, sizeof(request)) == 0;
+#endif
+}
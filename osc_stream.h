@@ -0,0 +1,211 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+// How a TCP stream delimits OSC packets. OSC 1.0 puts each packet's length
+// in front of it as a big-endian int32. OSC 1.1 frames packets with SLIP
+// (RFC 1055): END closes a packet, and usually opens one too, and END or
+// ESC bytes inside a packet are sent as ESC ESC_END or ESC ESC_ESC.
+enum StreamFraming : uint8_t {
+    FramingLengthPrefix,
+    FramingSlip,
+};
+
+// Incremental de-framer for one TCP connection. Reads go straight into a
+// ring buffer (ReadSpans(), then Commit()), and Drain() hands each complete
+// packet to a callback from where it lies. A packet that doesn't wrap the
+// end of the ring is passed as a pointer into it, with any SLIP escapes
+// decoded in place. Only a packet that wraps is copied, into the caller's
+// scratch buffer. The ring starts at one page and doubles only when a
+// packet won't fit, up to the largest packet plus its framing, so idle
+// connections stay cheap.
+class StreamDeframer {
+public:
+    static const uint8_t kSlipEnd = 0xC0;
+    static const uint8_t kSlipEsc = 0xDB;
+    static const uint8_t kSlipEscEnd = 0xDC;
+    static const uint8_t kSlipEscEsc = 0xDD;
+    static const size_t kInitialBytes = 4096;
+
+private:
+    StreamFraming framing;
+    size_t maxPacketBytes;
+    size_t maxCapacity;
+    std::unique_ptr<char[]> ring;
+    size_t capacity = kInitialBytes; // Always a power of two
+    uint64_t head = 0;    // Stream offset of the first byte not yet consumed
+    uint64_t tail = 0;    // Stream offset just past the last byte read
+    uint64_t scanned = 0; // SLIP: no END between head and here
+    size_t needed = 0;    // Ring size the packet being read needs; the next ReadSpans() grows to it
+
+    // Copies length bytes from offset out of the ring, across its end if need be.
+    void CopyOut(uint64_t offset, size_t length, char* out) const {
+        size_t start = offset & (capacity - 1);
+        size_t first = (std::min)(length, capacity - start);
+        memcpy(out, ring.get() + start, first);
+        memcpy(out + first, ring.get(), length - first);
+    }
+
+    // Moves the unconsumed bytes to the front of a ring of at least need bytes.
+    void Grow(size_t need) {
+        size_t grown = capacity;
+        while (grown < need) grown *= 2;
+        std::unique_ptr<char[]> larger(new char[grown]);
+        size_t used = Buffered();
+        CopyOut(head, used, larger.get());
+        ring = std::move(larger);
+        capacity = grown;
+        scanned -= head;
+        head = 0;
+        tail = used;
+    }
+
+    // Stream offset of the first END at or after from, or tail if none.
+    uint64_t FindEnd(uint64_t from) const {
+        while (from < tail) {
+            size_t start = from & (capacity - 1);
+            size_t run = static_cast<size_t>((std::min)(tail - from, static_cast<uint64_t>(capacity - start)));
+            const void* end = memchr(ring.get() + start, kSlipEnd, run);
+            if (end) return from + (static_cast<const char*>(end) - (ring.get() + start));
+            from += run;
+        }
+        return tail;
+    }
+
+    // Decodes SLIP escapes from src to dst, which may be src itself. An ESC
+    // that ends src is carried to the next call in escaped. An ESC before
+    // anything other than ESC_END or ESC_ESC is dropped and the byte kept,
+    // as RFC 1055 suggests. Returns the bytes written.
+    static size_t SlipDecode(const char* src, size_t length, char* dst, bool& escaped) {
+        size_t in = 0, out = 0;
+        while (in < length) {
+            if (escaped) {
+                uint8_t byte = static_cast<uint8_t>(src[in++]);
+                dst[out++] = static_cast<char>(byte == kSlipEscEnd ? kSlipEnd : byte == kSlipEscEsc ? kSlipEsc : byte);
+                escaped = false;
+                continue;
+            }
+            const void* esc = memchr(src + in, kSlipEsc, length - in);
+            size_t run = esc ? static_cast<const char*>(esc) - (src + in) : length - in;
+            if (dst + out != src + in) memmove(dst + out, src + in, run);
+            out += run;
+            in += run;
+            if (esc) {
+                escaped = true;
+                in++;
+            }
+        }
+        return out;
+    }
+
+    template <typename OnPacket>
+    bool DrainLengthPrefixed(char* scratch, OnPacket& onPacket) {
+        while (Buffered() >= 4) {
+            uint8_t prefix[4];
+            CopyOut(head, 4, reinterpret_cast<char*>(prefix));
+            uint32_t length = (static_cast<uint32_t>(prefix[0]) << 24) | (static_cast<uint32_t>(prefix[1]) << 16) |
+                              (static_cast<uint32_t>(prefix[2]) << 8) | prefix[3];
+            if (length > maxPacketBytes) return false; // Can't resynchronize past a bad length
+            size_t frame = 4 + static_cast<size_t>(length);
+            if (Buffered() < frame) {
+                if (frame > capacity) needed = frame;
+                break;
+            }
+            uint64_t offset = head + 4;
+            head += frame;
+            if (length == 0) continue;
+            size_t start = offset & (capacity - 1);
+            if (start + length <= capacity) {
+                onPacket(ring.get() + start, static_cast<int>(length));
+            } else {
+                CopyOut(offset, length, scratch);
+                onPacket(scratch, static_cast<int>(length));
+            }
+        }
+        return true;
+    }
+
+    template <typename OnPacket>
+    bool DrainSlip(char* scratch, OnPacket& onPacket) {
+        for (;;) {
+            uint64_t end = FindEnd(scanned);
+            if (end == tail) {
+                scanned = tail;
+                if (Buffered() < capacity) return true;
+                if (capacity >= maxCapacity) return false; // A packet longer than any we accept
+                needed = capacity * 2;
+                return true;
+            }
+            uint64_t offset = head;
+            size_t length = static_cast<size_t>(end - head);
+            head = scanned = end + 1;
+            if (length == 0) continue; // The END that opens a packet
+            size_t start = offset & (capacity - 1);
+            bool escaped = false;
+            if (start + length <= capacity) {
+                char* packet = ring.get() + start;
+                onPacket(packet, static_cast<int>(SlipDecode(packet, length, packet, escaped)));
+            } else {
+                size_t first = capacity - start;
+                size_t decoded = SlipDecode(ring.get() + start, first, scratch, escaped);
+                decoded += SlipDecode(ring.get(), length - first, scratch + decoded, escaped);
+                onPacket(scratch, static_cast<int>(decoded));
+            }
+        }
+    }
+
+public:
+    // Length prefixes above maxPacket, and SLIP packets that don't fit a
+    // ring of RingLimit(maxPacket) bytes, end the stream.
+    StreamDeframer(StreamFraming streamFraming, int maxPacket)
+        : framing(streamFraming), maxPacketBytes(static_cast<size_t>((std::max)(1, maxPacket))),
+          maxCapacity(RingLimit(maxPacket)), ring(new char[kInitialBytes]) {}
+
+    // The size the ring may grow to, and so the scratch buffer Drain() needs.
+    static size_t RingLimit(int maxPacket) {
+        size_t limit = kInitialBytes;
+        while (limit < static_cast<size_t>((std::max)(1, maxPacket)) + 4) limit *= 2;
+        return limit;
+    }
+
+    StreamFraming Framing() const { return framing; }
+
+    size_t Buffered() const { return static_cast<size_t>(tail - head); }
+
+    size_t Capacity() const { return capacity; }
+
+    // The free part of the ring as one or two spans, in stream order, for a
+    // single readv() or WSARecv(). Returns the span count, 0 if the ring
+    // is full, which Drain() returning true rules out. Growing the ring
+    // waits until here, so packets from the last Drain() stay where they are.
+    int ReadSpans(char* spans[2], size_t lengths[2]) {
+        if (needed > capacity) Grow(needed);
+        needed = 0;
+        if (Buffered() == 0) head = tail = scanned = 0; // Start reads at the front so packets rarely wrap
+        size_t free = capacity - Buffered();
+        if (free == 0) return 0;
+        size_t start = tail & (capacity - 1);
+        spans[0] = ring.get() + start;
+        lengths[0] = (std::min)(free, capacity - start);
+        spans[1] = ring.get();
+        lengths[1] = free - lengths[0];
+        return lengths[1] ? 2 : 1;
+    }
+
+    // Marks bytes written to the spans as read.
+    void Commit(size_t bytes) { tail += bytes; }
+
+    // Calls onPacket(const char* data, int length) for each complete packet
+    // read so far. data stays valid until the next ReadSpans(), at most one
+    // packet per call lands in scratch, which must hold RingLimit() bytes.
+    // Returns false if the stream can't be framed any further, and the
+    // connection should be closed.
+    template <typename OnPacket>
+    bool Drain(char* scratch, OnPacket onPacket) {
+        return framing == FramingSlip ? DrainSlip(scratch, onPacket) : DrainLengthPrefixed(scratch, onPacket);
+    }
+};
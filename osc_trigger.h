@@ -0,0 +1,382 @@
+#pragma once
+
+#include "osc_engine.h"
+#include "osc_sinks.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#include "osc_listener_win32.h"
+#else
+#include "osc_listener_linux.h"
+#endif
+
+// An extra socket on the same port (SO_REUSEPORT) with its own receive
+// thread and engine. Shards share the primary engine's rule table and the
+// dispatcher; parse state, pattern cache and counters stay per thread.
+struct ReceiveShard {
+    OSCEngine engine;
+    UdpListener listener;
+    std::thread thread;
+
+    ReceiveShard(LogRing& log, OSCEngine::TriggerCallback callback)
+        : engine(log, std::move(callback)), listener(engine) {}
+};
+
+// Front-end facing facade: the primary engine and socket backend, any extra
+// receive shards, and the action dispatcher feeding a sink. The GUI and the
+// headless daemon both drive the trigger through this class.
+class OSCTrigger {
+private:
+    std::unique_ptr<ActionSink> sink;
+    ActionDispatcher dispatcher;
+    OSCEngine engine;
+    UdpListener listener;
+    std::vector<std::unique_ptr<ReceiveShard>> shards; // Shard 0 is engine/listener above
+    std::atomic<bool> oneShotFired{false};
+    bool oneShot = true;
+    bool pinShards = false;
+    MetricsRegistry metrics;
+    Config startConfig;   // As passed to Start(); ReloadRules() re-reads its rules file
+    std::mutex reloadMutex; // Serializes rule publishes against Start() and the end of Listen()
+    bool rulesLive = false; // Between Start() and the end of Listen(), when publishes reach the engines
+    std::unique_ptr<RulesFileWatcher> watcher;
+
+    // cfg with the rules from cfg.rulesFile appended.
+    static bool WithRulesFile(const Config& cfg, Config& effective, std::string& error) {
+        effective = cfg;
+        return cfg.rulesFile.empty() || LoadRulesFile(cfg.rulesFile, effective.rules, error);
+    }
+
+    void StopWatcher() {
+        if (watcher) watcher->Stop();
+        watcher.reset();
+    }
+
+    // Every engine's trigger callback. In one-shot mode the first shard to
+    // match wins and the rest are told to stop.
+    void OnTrigger(const TriggerRule& rule, uint64_t receivedNs, uint64_t dueNs) {
+        if (oneShot && oneShotFired.exchange(true)) return;
+        dispatcher.Submit(rule, receivedNs, dueNs);
+        if (oneShot && !shards.empty()) RequestStop();
+    }
+
+    void ClearShards() {
+        for (std::unique_ptr<ReceiveShard>& shard : shards) {
+            shard->listener.Close();
+            metrics.Detach(shard->engine.GetCounters());
+        }
+        shards.clear();
+    }
+
+public:
+    OSCTrigger(LogRing& log, std::unique_ptr<ActionSink> actionSink)
+        : sink(std::move(actionSink)),
+          engine(log, [this](const TriggerRule& rule, uint64_t receivedNs, uint64_t dueNs) { OnTrigger(rule, receivedNs, dueNs); }),
+          listener(engine) {
+        metrics.Attach(engine.GetCounters());
+    }
+
+    ~OSCTrigger() {
+        StopWatcher();
+        dispatcher.Stop(); // Its idle task reaches into engine
+        ClearShards();
+    }
+
+    bool Start(const Config& cfg) {
+        StopWatcher();
+        std::lock_guard<std::mutex> lock(reloadMutex);
+        Config effective;
+        std::string error;
+        if (!WithRulesFile(cfg, effective, error)) {
+            engine.Log(LogError, error);
+            return false;
+        }
+        startConfig = cfg;
+        dispatcher.Stop(); // A worker left from an earlier Start() may still reclaim rules from engine
+        engine.Reset(effective);
+        ClearShards();
+        oneShot = !cfg.continuousMode;
+        oneShotFired = false;
+
+        int shardCount = cfg.recvShards < 1 ? 1 : cfg.recvShards;
+#ifdef _WIN32
+        if (shardCount > 1) {
+            engine.Log(LogWarning, "Receive shards need SO_REUSEPORT, which Windows lacks; using one socket");
+            shardCount = 1;
+        }
+#endif
+        pinShards = cfg.pinShards && shardCount > 1;
+
+        if (!listener.Open(effective)) {
+            return false;
+        }
+        for (int i = 1; i < shardCount; i++) {
+            Config shardConfig = effective;
+            if (!shardConfig.captureFile.empty()) shardConfig.captureFile += "." + std::to_string(i);
+
+            auto shard = std::make_unique<ReceiveShard>(engine.GetLog(), [this](const TriggerRule& rule, uint64_t receivedNs, uint64_t dueNs) {
+                OnTrigger(rule, receivedNs, dueNs);
+            });
+            shard->engine.Reset(shardConfig, &engine);
+            if (!shard->listener.Open(shardConfig)) {
+                listener.Close();
+                ClearShards();
+                return false;
+            }
+            metrics.Attach(shard->engine.GetCounters());
+            shards.push_back(std::move(shard));
+        }
+        dispatcher.Start(*sink, cfg.latencyStats ? &engine.GetLatency() : nullptr);
+
+        std::vector<Endpoint> endpoints = EndpointsFromConfig(cfg);
+        for (const Endpoint& endpoint : endpoints) {
+            LogStatus("Successfully bound to " + FormatEndpointAddress(endpoint) +
+                      (endpoints.size() > 1 ? " (" + endpoint.name + ")" : ""));
+        }
+        LogStatus("Socket ready for receiving UDP packets");
+        LogStatus("Loaded " + std::to_string(engine.GetRules().Size()) + " trigger rule(s)");
+        size_t limited = 0;
+        for (size_t i = 0; i < engine.GetRules().Size(); i++) limited += engine.GetRules().Rule(static_cast<int>(i)).HasFireLimits();
+        if (limited > 0) {
+            LogStatus(std::to_string(limited) + " rule(s) with edge, interval or rate limits");
+        }
+        if (engine.GetRules().HasPatterns()) {
+            LogStatus("Compiled " + std::to_string(engine.GetRules().PatternCount()) + " address pattern(s)");
+        }
+        rulesLive = true;
+        if (!cfg.rulesFile.empty()) {
+            watcher = std::make_unique<RulesFileWatcher>(cfg.rulesFile, cfg.watchRulesFile, [this] { ReloadRules(); });
+            watcher->Start();
+            LogStatus(cfg.watchRulesFile ? "Reloading rules when " + cfg.rulesFile + " changes"
+                                         : "Reloading rules from " + cfg.rulesFile + " on request");
+        }
+        if (shardCount > 1) {
+            LogStatus("Receiving on " + std::to_string(shardCount) + " SO_REUSEPORT sockets, one thread each" +
+                      (pinShards ? ", pinned to CPUs 0-" + std::to_string(shardCount - 1) : ""));
+        }
+        if (cfg.continuousMode) {
+            LogStatus("Continuous mode: Will trigger repeatedly on each match");
+        } else {
+            LogStatus("One-shot mode: Will trigger once then stop listening");
+        }
+        return true;
+    }
+
+    // Asks the listener to exit; the socket is closed by Listen() on its way out.
+    void Stop() {
+        LogStatus("Stopping listener...");
+        RequestStop();
+        LogStatus("Stopped");
+    }
+
+    // Safe to call from a signal handler.
+    void RequestStop() {
+        listener.RequestStop();
+        for (std::unique_ptr<ReceiveShard>& shard : shards) shard->listener.RequestStop();
+    }
+
+    // Runs the receive loops (shard 0 on the calling thread), then flushes
+    // queued actions before returning. A one-shot trigger waiting for its
+    // bundle timetag still fires on time; after a stop request, scheduled
+    // actions are cancelled.
+    void Listen() {
+        for (size_t i = 0; i < shards.size(); i++) {
+            ReceiveShard* shard = shards[i].get();
+            int cpu = static_cast<int>(i) + 1;
+            shard->thread = std::thread([this, shard, cpu] {
+                if (pinShards) PinCurrentThread(cpu);
+                shard->listener.Run();
+            });
+        }
+        if (pinShards) PinCurrentThread(0);
+
+        listener.Run();
+        for (std::unique_ptr<ReceiveShard>& shard : shards) {
+            shard->listener.RequestStop();
+            shard->thread.join();
+        }
+        StopWatcher();
+        {
+            std::lock_guard<std::mutex> lock(reloadMutex);
+            rulesLive = false;
+            dispatcher.Stop(/*cancel=*/!(oneShot && oneShotFired));
+            engine.ReclaimRules();
+        }
+
+        DispatchStats stats = dispatcher.GetStats();
+        if (stats.submitted > 0) {
+            char line[160];
+            snprintf(line, sizeof(line), "Dispatched %llu action(s), %llu dropped, max queue depth %zu, receive-to-dispatch avg %.0f us, max %.0f us",
+                     (unsigned long long)stats.dispatched, (unsigned long long)stats.dropped, stats.maxDepth,
+                     stats.avgLatencyUs, stats.maxLatencyUs);
+            LogStatus(line);
+        }
+        if (stats.scheduled > 0 || stats.cancelled > 0) {
+            char line[200];
+            snprintf(line, sizeof(line), "Fired %llu action(s) at their bundle timetag, jitter p50 %.1f us, p99 %.1f us, max %.1f us; %llu cancelled at stop",
+                     (unsigned long long)stats.scheduled, stats.jitterP50Us, stats.jitterP99Us, stats.jitterMaxUs,
+                     (unsigned long long)stats.cancelled);
+            LogStatus(line);
+        }
+
+        if (engine.GetConfig().latencyStats) {
+            LogStatus("Latency by stage:");
+            for (int stage = 0; stage < StageCount; stage++) {
+                LogStatus("  " + engine.GetLatency().FormatStage(static_cast<LatencyStage>(stage)));
+            }
+        }
+    }
+
+    // Swaps in the rules cfg describes (its single-rule fields, rules and
+    // rulesFile) without touching the sockets: receive threads pick the new
+    // table up at their next batch and no datagram is dropped. Endpoints,
+    // shards and everything else keep their Start() settings. A rules file
+    // that fails to parse leaves the running rules in place. Safe from any
+    // thread while listening.
+    bool ApplyRules(const Config& cfg) {
+        std::lock_guard<std::mutex> lock(reloadMutex);
+        if (!rulesLive) return false;
+        Config effective;
+        std::string error;
+        if (!WithRulesFile(cfg, effective, error)) {
+            engine.Log(LogWarning, error + "; keeping the current rules");
+            return false;
+        }
+        uint64_t startNs = SteadyNowNs();
+        engine.PublishRules(effective);
+        uint64_t publishNs = SteadyNowNs() - startNs;
+        // Old tables go once no queued action can point into them, which the
+        // worker sees when it next runs dry; actions held for a bundle
+        // timetag keep them until they fire. Tables a later reload retires
+        // wait for that reload's turn.
+        uint64_t liveVersion = engine.GetRules().Version();
+        dispatcher.WhenIdle([this, liveVersion] { engine.ReclaimRules(liveVersion); });
+
+        char line[128];
+        snprintf(line, sizeof(line), "Reloaded %zu trigger rule(s) in %.0f us", engine.GetRules().Size(), publishNs / 1e3);
+        LogStatus(line);
+        return true;
+    }
+
+    // Re-reads the Start() configuration's rules file.
+    bool ReloadRules() {
+        Config cfg;
+        {
+            std::lock_guard<std::mutex> lock(reloadMutex);
+            cfg = startConfig;
+        }
+        return ApplyRules(cfg);
+    }
+
+    // Safe to call from a signal handler: the rules watcher does the reload.
+    void RequestRulesReload() {
+        if (watcher) watcher->Request();
+    }
+
+    void LogStatus(const std::string& message) { engine.LogStatus(message); }
+
+    bool IsRunning() const { return listener.IsRunning(); }
+
+    uint64_t GetDatagramCount() const {
+        uint64_t count = engine.GetDatagramCount();
+        for (const std::unique_ptr<ReceiveShard>& shard : shards) count += shard->engine.GetDatagramCount();
+        return count;
+    }
+
+    // Datagrams read by each receive thread, shard 0 first.
+    std::vector<uint64_t> GetShardDatagramCounts() const {
+        std::vector<uint64_t> counts(1, engine.GetDatagramCount());
+        for (const std::unique_ptr<ReceiveShard>& shard : shards) counts.push_back(shard->engine.GetDatagramCount());
+        return counts;
+    }
+
+    // Receive buffer size and kernel drops for every socket, shard 0 first.
+    std::vector<SocketStats> GetSocketStats() const {
+        std::vector<SocketStats> stats;
+        listener.AppendSocketStats(0, stats);
+        for (size_t i = 0; i < shards.size(); i++) shards[i]->listener.AppendSocketStats(static_cast<int>(i) + 1, stats);
+        return stats;
+    }
+
+    DispatchStats GetDispatchStats() const { return dispatcher.GetStats(); }
+
+    const LatencyStats& GetLatencyStats() const { return engine.GetLatency(); }
+
+    const MetricsRegistry& GetMetrics() const { return metrics; }
+
+    // Every counter plus dispatcher and log health, in Prometheus text format.
+    std::string FormatMetrics() {
+        std::string out;
+        metrics.AppendCounters(out);
+
+        DispatchStats stats = dispatcher.GetStats();
+        AppendMetric(out, "osc_actions_dispatched_total", "counter", "Actions delivered to the sink", static_cast<double>(stats.dispatched));
+        AppendMetric(out, "osc_actions_dropped_total", "counter", "Actions lost to a full dispatch queue", static_cast<double>(stats.dropped));
+        AppendMetric(out, "osc_dispatch_queue_depth", "gauge", "Actions waiting for the sink", static_cast<double>(stats.depth));
+        AppendMetric(out, "osc_actions_scheduled_total", "counter", "Actions fired at their bundle timetag", static_cast<double>(stats.scheduled));
+        AppendMetric(out, "osc_actions_pending", "gauge", "Actions waiting for their bundle timetag", static_cast<double>(stats.pending));
+        AppendMetric(out, "osc_log_lines_dropped_total", "counter", "Status lines lost to a full log ring", static_cast<double>(engine.GetLog().Dropped()));
+        AppendMetric(out, "osc_listening", "gauge", "1 while the listener is running", IsRunning() ? 1.0 : 0.0);
+
+        char jitter[320];
+        snprintf(jitter, sizeof(jitter),
+                 "# HELP osc_schedule_jitter_seconds Fire time minus bundle timetag for scheduled actions\n"
+                 "# TYPE osc_schedule_jitter_seconds summary\n"
+                 "osc_schedule_jitter_seconds{quantile=\"0.5\"} %.9f\n"
+                 "osc_schedule_jitter_seconds{quantile=\"0.99\"} %.9f\n"
+                 "osc_schedule_jitter_seconds_count %llu\n",
+                 stats.jitterP50Us / 1e6, stats.jitterP99Us / 1e6, (unsigned long long)stats.scheduled);
+        out += jitter;
+
+        std::vector<SocketStats> sockets = GetSocketStats();
+        std::string drops, buffers, connections;
+        for (const SocketStats& entry : sockets) {
+            std::string labels = "{shard=\"" + std::to_string(entry.shard) + "\",endpoint=\"";
+            for (char c : entry.endpoint) {
+                if (c == '"' || c == '\\') labels += '\\';
+                labels += c;
+            }
+            labels += "\"}";
+            buffers += "osc_socket_receive_buffer_bytes" + labels + " " + std::to_string(entry.receiveBufferBytes) + "\n";
+            if (entry.dropsCounted) drops += "osc_socket_kernel_drops_total" + labels + " " + std::to_string(entry.kernelDrops) + "\n";
+            if (entry.stream) connections += "osc_tcp_connections_open" + labels + " " + std::to_string(entry.connections) + "\n";
+        }
+        if (!buffers.empty()) {
+            out += "# HELP osc_socket_receive_buffer_bytes SO_RCVBUF of each receive socket, as the kernel reports it\n"
+                   "# TYPE osc_socket_receive_buffer_bytes gauge\n" + buffers;
+        }
+        if (!drops.empty()) {
+            out += "# HELP osc_socket_kernel_drops_total Datagrams the kernel dropped on each socket's full receive buffer\n"
+                   "# TYPE osc_socket_kernel_drops_total counter\n" + drops;
+        }
+        if (!connections.empty()) {
+            out += "# HELP osc_tcp_connections_open TCP connections open on each stream endpoint's listening socket\n"
+                   "# TYPE osc_tcp_connections_open gauge\n" + connections;
+        }
+
+        if (engine.GetConfig().latencyStats) {
+            out += "# HELP osc_stage_latency_seconds Time spent in each stage from kernel receive to key injection\n"
+                   "# TYPE osc_stage_latency_seconds summary\n";
+            const double quantiles[] = {0.5, 0.99, 0.999};
+            for (int s = 0; s < StageCount; s++) {
+                const LatencyHistogram& h = engine.GetLatency().stages[s];
+                const char* stage = LatencyStageName(static_cast<LatencyStage>(s));
+                char line[160];
+                for (double q : quantiles) {
+                    snprintf(line, sizeof(line), "osc_stage_latency_seconds{stage=\"%s\",quantile=\"%g\"} %.9f\n",
+                             stage, q, h.PercentileNs(q) / 1e9);
+                    out += line;
+                }
+                snprintf(line, sizeof(line), "osc_stage_latency_seconds_count{stage=\"%s\"} %llu\n",
+                         stage, (unsigned long long)h.Count());
+                out += line;
+            }
+        }
+        return out;
+    }
+
+    int64_t GetLastStopLatencyUs() const { return listener.LastStopLatencyUs(); }
+};
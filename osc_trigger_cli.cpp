@@ -0,0 +1,308 @@
+// Headless OSC trigger daemon. Same engine as the GUI, configured from the
+// command line, logging to stdout or a file. No window enumeration or GUI setup runs
+// before the socket is bound, so it is receiving within milliseconds.
+#include "osc_trigger.h"
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+std::unique_ptr<OSCTrigger> g_trigger = nullptr;
+
+// Front-end settings that aren't part of the engine Config
+struct DaemonOptions {
+    bool useUinput = false;
+    LogLevel logLevel = LogInfo;
+    std::string logFile;
+    std::string statsFile;
+    int statsIntervalMs = 1000;
+};
+
+LogRing g_log(4096);
+
+void HandleSignal(int) {
+    if (g_trigger) {
+        g_trigger->RequestStop();
+    }
+}
+
+#ifdef SIGHUP
+void HandleReloadSignal(int) {
+    if (g_trigger) {
+        g_trigger->RequestRulesReload();
+    }
+}
+#endif
+
+void PrintUsage(const char* program) {
+    printf("Usage: %s [options]\n"
+           "  --ip ADDRESS       Address to bind: IPv4 or IPv6, 0.0.0.0 for all IPv4, :: for all\n"
+           "                     dual-stack, or a multicast group to join (default 127.0.0.1)\n"
+           "  --interface IF     Interface --ip's multicast group is joined on (name, index or IPv4 address)\n"
+           "  --port PORT        UDP port (default 55525)\n"
+           "  --listen [NAME=][SCHEME]IP:PORT[@IF]  Also listen on this endpoint, in the same receive loop;\n"
+           "                     IPv6 in [brackets], @IF picks a multicast interface (repeatable).\n"
+           "                     SCHEME: udp:// (default), tcp:// for OSC 1.0 length-prefixed streams,\n"
+           "                     slip:// for OSC 1.1 SLIP-framed streams\n"
+           "  --address PATH     OSC address to match (default /flair/runstate)\n"
+           "  --value [OP]N      Target value, optionally after ==, !=, >, >=, < or <= (default 9);\n"
+           "                     or a range LO..HI, true/false, a string, or clauses joined by & and |\n"
+           "                     such as \"0:go & 1:>0.5\" (see README)\n"
+           "  --arg N|any|all    Argument compared against the value: an index, or any/all of them (default 0)\n"
+           "  --tolerance X      Float == and != match within X (default 0.01)\n"
+           "  --key KEY          Trigger key, e.g. SPACE, F1, CTRL+A (default SPACE)\n"
+           "  --window TITLE     Target window title (Windows only)\n"
+           "  --rule SPEC        Add a rule: \"ADDRESS VALUE KEY [arg=N|any|all] [window=TITLE] [endpoint=NAME]\n"
+           "                     [tolerance=X] [edge] [hysteresis=X] [interval=MS] [rate=N] [burst=N]\" (repeatable)\n"
+           "  --rules FILE       Add the rules in FILE, one --rule SPEC per line (# comments);\n"
+           "                     reloaded without a restart when FILE changes"
+#ifdef SIGHUP
+           " or on SIGHUP"
+#endif
+           "\n"
+           "  --no-watch         Reload --rules FILE only on request, not when it changes\n"
+           "  --no-default-rule  Use only --rule rules, ignoring --address/--value/--key\n"
+           "  --continuous       Trigger on every match instead of once\n"
+           "  --edge             Trigger only when the value changes to the target, not on repeats\n"
+           "  --hysteresis X     With --edge, re-arm once the value is more than X from the target\n"
+           "  --min-interval MS  Minimum time between triggers of the default rule\n"
+           "  --rate N[/BURST]   Token-bucket limit for the default rule: N per second, BURST back to back\n"
+           "  --log-level LEVEL  debug, info, warning or error (default info)\n"
+           "  --log-file PATH    Append the log to PATH instead of stdout\n"
+           "  --batch N          Datagrams drained per receive call (default 32, 1 = unbatched)\n"
+           "  --recv-buffer N[K|M]  Socket receive buffer (SO_RCVBUF) to ask for (default: system)\n"
+           "  --max-datagram N   Largest datagram or TCP packet received whole, in bytes (default and maximum 65535)\n"
+           "  --max-connections N  Open TCP connections per receive thread; more are refused (default 256)\n"
+           "  --pattern-cache N  Addresses remembered for pattern rules (default 1024, 0 = off)\n"
+           "  --shards N         Receive sockets on the port, one thread each (SO_REUSEPORT, Linux)\n"
+           "  --no-pin           Don't pin receive shard threads to CPUs\n"
+           "  --ignore-timetags  Fire bundle contents on arrival instead of at their timetag\n"
+           "  --schedule-horizon MS  Timetags further than this from now fire immediately (default 10000)\n"
+           "  --capture FILE     Record every received datagram to FILE (see osc_replay)\n"
+           "  --relay [all:|matched:|unmatched:]IP:PORT[@IF]  Forward received datagrams unchanged to this\n"
+           "                     UDP destination: all of them (default), or only those a rule matched\n"
+           "                     or didn't match (repeatable)\n"
+           "  --latency          Keep per-stage latency histograms and log them on exit\n"
+           "  --stats-file PATH  Rewrite PATH with Prometheus-format counters every interval\n"
+           "  --stats-interval MS  How often the stats file is rewritten (default 1000)\n"
+#ifdef __linux__
+           "  --uinput           Inject keys through a /dev/uinput virtual keyboard\n"
+#endif
+           "  --help             Show this message\n", program);
+}
+
+bool ParseArguments(int argc, char** argv, Config& config, DaemonOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--continuous") {
+            config.continuousMode = true;
+        } else if (arg == "--edge") {
+            config.edgeTrigger = true;
+        } else if (arg == "--no-watch") {
+            config.watchRulesFile = false;
+        } else if (arg == "--no-pin") {
+            config.pinShards = false;
+        } else if (arg == "--ignore-timetags") {
+            config.honorTimetags = false;
+        } else if (arg == "--latency") {
+            config.latencyStats = true;
+        } else if (arg == "--no-default-rule") {
+            config.oscAddress.clear();
+#ifdef __linux__
+        } else if (arg == "--uinput") {
+            options.useUinput = true;
+#endif
+        } else if (arg == "--help" || arg == "-h") {
+            return false;
+        } else if (!hasValue) {
+            fprintf(stderr, "Missing value for %s\n", arg.c_str());
+            return false;
+        } else if (arg == "--ip") {
+            config.ipAddress = argv[++i];
+        } else if (arg == "--port") {
+            config.port = atoi(argv[++i]);
+        } else if (arg == "--interface") {
+            config.multicastInterface = argv[++i];
+        } else if (arg == "--listen") {
+            Endpoint endpoint;
+            std::string error;
+            if (!ParseEndpoint(argv[++i], endpoint, error)) {
+                fprintf(stderr, "Invalid endpoint: %s\n", error.c_str());
+                return false;
+            }
+            config.extraEndpoints.push_back(endpoint);
+        } else if (arg == "--address") {
+            config.oscAddress = argv[++i];
+        } else if (arg == "--value") {
+            std::string error;
+            if (!ParseRuleValue(argv[++i], config.compareOp, config.targetValue, config.condition, error)) {
+                fprintf(stderr, "Invalid value %s: %s\n", argv[i], error.c_str());
+                return false;
+            }
+        } else if (arg == "--arg") {
+            if (!ParseArgSelector(argv[++i], config.argIndex)) {
+                fprintf(stderr, "Invalid --arg (expected an index, any or all): %s\n", argv[i]);
+                return false;
+            }
+        } else if (arg == "--tolerance") {
+            config.tolerance = (std::max)(0.0, atof(argv[++i]));
+        } else if (arg == "--hysteresis") {
+            config.hysteresis = (std::max)(0.0, atof(argv[++i]));
+        } else if (arg == "--min-interval") {
+            config.minIntervalMs = (std::max)(0, atoi(argv[++i]));
+        } else if (arg == "--rate") {
+            std::string spec = argv[++i];
+            size_t slash = spec.find('/');
+            config.ratePerSec = (std::max)(0.0, atof(spec.c_str()));
+            config.rateBurst = slash == std::string::npos ? 1 : (std::max)(1, atoi(spec.c_str() + slash + 1));
+        } else if (arg == "--key") {
+            config.keyString = argv[++i];
+        } else if (arg == "--window") {
+            config.windowTitle = argv[++i];
+        } else if (arg == "--rule") {
+            TriggerRule rule;
+            std::string error;
+            if (!ParseRule(argv[++i], rule, error)) {
+                fprintf(stderr, "Invalid rule \"%s\": %s\n", argv[i], error.c_str());
+                return false;
+            }
+            config.rules.push_back(rule);
+        } else if (arg == "--rules") {
+            config.rulesFile = argv[++i];
+        } else if (arg == "--batch") {
+            config.recvBatchSize = atoi(argv[++i]);
+        } else if (arg == "--recv-buffer") {
+            char* unit = nullptr;
+            long long bytes = strtoll(argv[++i], &unit, 10);
+            if (*unit == 'K' || *unit == 'k') bytes *= 1024;
+            if (*unit == 'M' || *unit == 'm') bytes *= 1024 * 1024;
+            if (bytes <= 0 || bytes > 1024 * 1024 * 1024) {
+                fprintf(stderr, "Invalid --recv-buffer: %s\n", argv[i]);
+                return false;
+            }
+            config.recvBufferBytes = static_cast<int>(bytes);
+        } else if (arg == "--max-datagram") {
+            config.maxDatagramBytes = atoi(argv[++i]);
+            if (config.maxDatagramBytes < 16 || config.maxDatagramBytes > ReceiveBufferPool::kMaxDatagramBytes) {
+                fprintf(stderr, "Invalid --max-datagram (16 to 65535): %s\n", argv[i]);
+                return false;
+            }
+        } else if (arg == "--max-connections") {
+            config.maxTcpConnections = atoi(argv[++i]);
+            if (config.maxTcpConnections < 1) {
+                fprintf(stderr, "Invalid --max-connections: %s\n", argv[i]);
+                return false;
+            }
+        } else if (arg == "--pattern-cache") {
+            config.patternCacheSize = atoi(argv[++i]);
+        } else if (arg == "--shards") {
+            config.recvShards = atoi(argv[++i]);
+        } else if (arg == "--schedule-horizon") {
+            config.scheduleHorizonMs = (std::max)(0, atoi(argv[++i]));
+        } else if (arg == "--relay") {
+            RelayDestination destination;
+            std::string error;
+            if (!ParseRelayDestination(argv[++i], destination, error)) {
+                fprintf(stderr, "Invalid relay destination: %s\n", error.c_str());
+                return false;
+            }
+            config.relayDestinations.push_back(destination);
+        } else if (arg == "--capture") {
+            config.captureFile = argv[++i];
+        } else if (arg == "--log-level") {
+            if (!ParseLogLevel(argv[++i], options.logLevel)) {
+                fprintf(stderr, "Unknown log level: %s\n", argv[i]);
+                return false;
+            }
+        } else if (arg == "--log-file") {
+            options.logFile = argv[++i];
+        } else if (arg == "--stats-file") {
+            options.statsFile = argv[++i];
+        } else if (arg == "--stats-interval") {
+            options.statsIntervalMs = (std::max)(10, atoi(argv[++i]));
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", arg.c_str());
+            return false;
+        }
+    }
+
+    if (!IsValidKeyString(config.keyString)) {
+        fprintf(stderr, "Invalid key combination: %s\n", config.keyString.c_str());
+        return false;
+    }
+    ParseKeyString(config.keyString, config);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    Config config;
+    DaemonOptions options;
+    if (!ParseArguments(argc, argv, config, options)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    FILE* logOutput = stdout;
+    if (!options.logFile.empty()) {
+        logOutput = fopen(options.logFile.c_str(), "a");
+        if (!logOutput) {
+            fprintf(stderr, "Cannot open log file: %s\n", options.logFile.c_str());
+            return 1;
+        }
+    }
+    g_log.SetLevel(options.logLevel);
+    LogWriterThread logWriter(g_log, logOutput);
+    logWriter.Start();
+
+    std::unique_ptr<ActionSink> sink;
+#ifdef _WIN32
+    sink = std::make_unique<Win32KeySink>();
+#else
+    if (options.useUinput) {
+#ifdef __linux__
+        auto uinput = std::make_unique<UinputKeySink>();
+        std::string error;
+        if (!uinput->Open(error)) {
+            fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        sink = std::move(uinput);
+#endif
+    } else {
+        sink = std::make_unique<NullSink>(); // The TRIGGER log line is the output
+    }
+#endif
+
+    g_trigger = std::make_unique<OSCTrigger>(g_log, std::move(sink));
+    if (!g_trigger->Start(config)) {
+        logWriter.Stop();
+        return 1;
+    }
+
+    std::unique_ptr<MetricsFileWriter> statsWriter;
+    if (!options.statsFile.empty()) {
+        statsWriter = std::make_unique<MetricsFileWriter>(options.statsFile, options.statsIntervalMs,
+                                                          [] { return g_trigger->FormatMetrics(); });
+        statsWriter->Start();
+    }
+
+    std::signal(SIGINT, HandleSignal);
+    std::signal(SIGTERM, HandleSignal);
+#ifdef SIGHUP
+    std::signal(SIGHUP, HandleReloadSignal);
+#endif
+
+    g_trigger->Listen();
+    if (statsWriter) statsWriter->Stop();
+
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    logWriter.Stop();
+    if (logOutput != stdout) fclose(logOutput);
+    return 0;
+}
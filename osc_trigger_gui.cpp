@@ -13,6 +13,7 @@
 #include <memory>
 #include <future>
 #include <chrono>
+#include "osc_trigger.h"
 
 #pragma comment(lib, "ws2_32.lib")
 #pragma comment(lib, "user32.lib")
@@ -32,365 +33,48 @@
 #define ID_KEY_CAPTURE      1011
 #define ID_KEY_DISPLAY      1012
 #define ID_CONTINUOUS_CHECK 1013
+#define ID_APPLY_BUTTON     1014
 
-struct Config {
-    std::string windowTitle = "YourTargetWindow";
-    std::string ipAddress = "127.0.0.1";
-    int port = 55525;
-    int triggerKey = VK_SPACE;
-    bool useCtrl = false;
-    bool useShift = false;
-    bool useAlt = false;
-    int targetValue = 9;
-    std::string oscAddress = "/flair/runstate";
-    std::string keyString = "SPACE";
-    bool continuousMode = false;
-};
+#define ID_LOG_TIMER        2001
+#define LOG_DRAIN_MS        50     // Status log refresh interval
+#define STATUS_HISTORY_CHARS 24000 // Oldest lines are trimmed beyond this (edit controls hold ~32K)
 
-class OSCTrigger {
-private:
-    SOCKET udpSocket;
-    sockaddr_in serverAddr;
-    Config config;
-    std::atomic<bool> running;
-    std::atomic<bool> hasTriggered;
-    HWND statusEdit;
-    
-public:
-    OSCTrigger(HWND status) : udpSocket(INVALID_SOCKET), running(false), hasTriggered(false), statusEdit(status) {}
-    
-    bool Start(const Config& cfg) {
-        config = cfg;
-        
-        WSADATA wsaData;
-        if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
-            LogStatus("WSAStartup failed");
-            return false;
-        }
-        
-        udpSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-        if (udpSocket == INVALID_SOCKET) {
-            LogStatus("Socket creation failed");
-            WSACleanup();
-            return false;
-        }
-        
-        // Enable socket reuse
-        int reuse = 1;
-        setsockopt(udpSocket, SOL_SOCKET, SO_REUSEADDR, (char*)&reuse, sizeof(reuse));
-        
-        serverAddr.sin_family = AF_INET;
-        serverAddr.sin_port = htons(config.port);
-        
-        // Fix: Use the configured IP address
-        if (config.ipAddress == "0.0.0.0" || config.ipAddress.empty()) {
-            serverAddr.sin_addr.s_addr = INADDR_ANY;
-            LogStatus("Binding to all interfaces (0.0.0.0)");
-        } else {
-            if (inet_pton(AF_INET, config.ipAddress.c_str(), &serverAddr.sin_addr) != 1) {
-                LogStatus("Invalid IP address: " + config.ipAddress);
-                closesocket(udpSocket);
-                WSACleanup();
-                return false;
-            }
-            LogStatus("Binding to specific IP: " + config.ipAddress);
-        }
-        
-        if (bind(udpSocket, (SOCKADDR*)&serverAddr, sizeof(serverAddr)) == SOCKET_ERROR) {
-            int errorCode = WSAGetLastError();
-            LogStatus("Bind failed on " + config.ipAddress + ":" + std::to_string(config.port) + " - Error: " + std::to_string(errorCode));
-            if (errorCode == WSAEADDRINUSE) {
-                LogStatus("Port is already in use. Try stopping other applications or use a different port.");
-            } else if (errorCode == WSAEADDRNOTAVAIL) {
-                LogStatus("IP address not available on this machine. Try 0.0.0.0 to listen on all interfaces.");
-            }
-            closesocket(udpSocket);
-            WSACleanup();
-            return false;
-        }
-        
-        // Set socket to non-blocking mode
-        u_long nonBlocking = 1;
-        ioctlsocket(udpSocket, FIONBIO, &nonBlocking);
-        
-        running = true;
-        hasTriggered = false;
-        LogStatus("Successfully bound to " + config.ipAddress + ":" + std::to_string(config.port));
-        LogStatus("Socket ready for receiving UDP packets");
-        if (config.continuousMode) {
-            LogStatus("Continuous mode: Will trigger repeatedly on each match");
-        } else {
-            LogStatus("One-shot mode: Will trigger once then stop listening");
-        }
-        return true;
-    }
-    
-    void Stop() {
-        LogStatus("Stopping listener...");
-        running = false;
-        
-        // Close socket first to break out of any blocking operations
-        if (udpSocket != INVALID_SOCKET) {
-            shutdown(udpSocket, SD_BOTH);
-            closesocket(udpSocket);
-            udpSocket = INVALID_SOCKET;
-        }
-        
-        LogStatus("Stopped");
-    }
-    
-    void Listen() {
-        char buffer[4096];
-        sockaddr_in clientAddr;
-        int clientAddrSize = sizeof(clientAddr);
-        
-        LogStatus("Starting UDP listener thread");
-        
-        while (running && udpSocket != INVALID_SOCKET) {
-            fd_set readSet;
-            FD_ZERO(&readSet);
-            FD_SET(udpSocket, &readSet);
-            
-            timeval timeout = {0, 50000}; // 50ms timeout for more responsive shutdown
-            int result = select(0, &readSet, nullptr, nullptr, &timeout);
-            
-            if (!running || udpSocket == INVALID_SOCKET) break; // Check if we should stop
-            
-            if (result > 0 && FD_ISSET(udpSocket, &readSet)) {
-                int bytesReceived = recvfrom(udpSocket, buffer, sizeof(buffer), 0, 
-                                           (SOCKADDR*)&clientAddr, &clientAddrSize);
-                
-                if (bytesReceived > 0) {
-                    ProcessOSCData(buffer, bytesReceived);
-                } else if (bytesReceived == SOCKET_ERROR) {
-                    int error = WSAGetLastError();
-                    if (error != WSAEWOULDBLOCK && running) {
-                        LogStatus("recvfrom error: " + std::to_string(error));
-                        // Don't break here - continue trying to receive
-                    }
-                }
-            } else if (result == SOCKET_ERROR) {
-                int error = WSAGetLastError();
-                if (running && error != WSAEINTR) {
-                    LogStatus("select error: " + std::to_string(error));
-                    // Only break on critical errors, not interruption
-                    if (error != WSAENOTSOCK) {
-                        break;
-                    }
-                }
-            }
-        }
-        
-        LogStatus("UDP listener thread stopped");
-    }
-    
-    void ProcessOSCData(const char* data, int length) {
-        if (length >= 8 && memcmp(data, "#bundle", 7) == 0 && data[7] == 0) {
-            ProcessBundle(data, length);
-        } else {
-            ProcessMessage(data, length);
-        }
-    }
-    
-    void ProcessBundle(const char* data, int length) {
-        int pos = 16; // Skip bundle header and timetag
-        int messageCount = 0;
-        
-        while (pos + 4 <= length) {
-            // Read element size (big-endian)
-            uint32_t elementSize = 
-                (static_cast<uint8_t>(data[pos]) << 24) |
-                (static_cast<uint8_t>(data[pos + 1]) << 16) |
-                (static_cast<uint8_t>(data[pos + 2]) << 8) |
-                static_cast<uint8_t>(data[pos + 3]);
-            
-            pos += 4;
-            
-            if (elementSize == 0 || pos + elementSize > length) {
-                break;
-            }
-            
-            messageCount++;
-            ProcessMessage(data + pos, elementSize);
-            pos += elementSize;
-        }
-    }
-    
-    void ProcessMessage(const char* data, int length) {
-        if (length < 4) return;
-        
-        // Find the OSC address
-        const char* addressEnd = (const char*)memchr(data, 0, length);
-        if (!addressEnd) return;
-        
-        std::string address(data);
-        
-        if (address != config.oscAddress) {
-            return;
-        }
-        
-        // Calculate padding for address
-        int addressLen = addressEnd - data + 1;
-        int addressPadding = ((addressLen + 3) & ~3) - addressLen;
-        int typeTagPos = addressLen + addressPadding;
-        
-        if (typeTagPos + 2 > length) return;
-        
-        // Check type tag
-        if (data[typeTagPos] != ',') {
-            return;
-        }
-        
-        char typeTag = data[typeTagPos + 1];
-        
-        // Calculate type tag padding
-        int typeTagLen = 2; // ",i" or ",f"
-        while (typeTagPos + typeTagLen < length && data[typeTagPos + typeTagLen] != 0) {
-            typeTagLen++;
-        }
-        if (data[typeTagPos + typeTagLen] == 0) typeTagLen++; // Include null terminator
-        
-        int typeTagPadding = ((typeTagLen + 3) & ~3) - typeTagLen;
-        int valuePos = typeTagPos + typeTagLen + typeTagPadding;
-        
-        if (valuePos + 4 > length) {
-            return;
-        }
-        
-        // Read value (big-endian)
-        uint32_t rawValue = 
-            (static_cast<uint8_t>(data[valuePos]) << 24) |
-            (static_cast<uint8_t>(data[valuePos + 1]) << 16) |
-            (static_cast<uint8_t>(data[valuePos + 2]) << 8) |
-            static_cast<uint8_t>(data[valuePos + 3]);
-        
-        if (typeTag == 'i') {
-            int32_t value = static_cast<int32_t>(rawValue);
-            if (value == config.targetValue) {
-                if (config.continuousMode) {
-                    TriggerButton();
-                    LogStatus("Triggered: " + config.oscAddress + " = " + std::to_string(value));
-                } else if (!hasTriggered) {
-                    TriggerButton();
-                    hasTriggered = true;
-                    LogStatus("One-shot trigger activated - stopping listener");
-                    running = false;
-                }
-            }
-        } else if (typeTag == 'f') {
-            float value = *reinterpret_cast<float*>(&rawValue);
-            if (fabs(value - config.targetValue) < 0.01f) {
-                if (config.continuousMode) {
-                    TriggerButton();
-                    LogStatus("Triggered: " + config.oscAddress + " = " + std::to_string(value));
-                } else if (!hasTriggered) {
-                    TriggerButton();
-                    hasTriggered = true;
-                    LogStatus("One-shot trigger activated - stopping listener");
-                    running = false;
-                }
-            }
-        }
-    }
-    
-    void TriggerButton() {
-        LogStatus("TRIGGER: " + config.oscAddress + " = " + std::to_string(config.targetValue) + " (Key: " + config.keyString + ")");
-        
-        HWND window = FindWindowA(nullptr, config.windowTitle.c_str());
-        if (window) {
-            SetForegroundWindow(window);
-        }
-        
-        // Press modifier keys
-        if (config.useCtrl) keybd_event(VK_CONTROL, 0, 0, 0);
-        if (config.useShift) keybd_event(VK_SHIFT, 0, 0, 0);
-        if (config.useAlt) keybd_event(VK_MENU, 0, 0, 0);
-        
-        // Press main key
-        keybd_event(config.triggerKey, 0, 0, 0);
-        keybd_event(config.triggerKey, 0, KEYEVENTF_KEYUP, 0);
-        
-        // Release modifier keys
-        if (config.useAlt) keybd_event(VK_MENU, 0, KEYEVENTF_KEYUP, 0);
-        if (config.useShift) keybd_event(VK_SHIFT, 0, KEYEVENTF_KEYUP, 0);
-        if (config.useCtrl) keybd_event(VK_CONTROL, 0, KEYEVENTF_KEYUP, 0);
-    }
-    
-    void LogStatus(const std::string& message) {
-        if (statusEdit) {
-            SYSTEMTIME st;
-            GetLocalTime(&st);
-            char timeStr[32];
-            sprintf(timeStr, "[%02d:%02d:%02d.%03d] ", st.wHour, st.wMinute, st.wSecond, st.wMilliseconds);
-            
-            std::string fullMessage = timeStr + message + "\r\n";
-            
-            int len = GetWindowTextLength(statusEdit);
-            SendMessage(statusEdit, EM_SETSEL, len, len);
-            SendMessage(statusEdit, EM_REPLACESEL, FALSE, (LPARAM)fullMessage.c_str());
-            
-            // Auto-scroll to bottom
-            SendMessage(statusEdit, EM_SCROLL, SB_BOTTOM, 0);
-        }
+// Status lines from every thread go into this ring; only the UI thread
+// touches the edit control, on the ID_LOG_TIMER tick.
+LogRing g_log(1024);
+
+// Appends every queued status line to the edit control in one batch and
+// trims the oldest lines so the control stays under STATUS_HISTORY_CHARS.
+void DrainStatusLog(HWND statusEdit) {
+    std::string batch;
+    g_log.Drain([&](const LogEntry& entry) {
+        batch += FormatLogLine(entry);
+        batch += "\r\n";
+    });
+    if (batch.empty() || !statusEdit) return;
+
+    if (batch.size() > STATUS_HISTORY_CHARS) {
+        size_t cut = batch.find('\n', batch.size() - STATUS_HISTORY_CHARS);
+        batch.erase(0, cut == std::string::npos ? batch.size() : cut + 1);
     }
-    
-    bool IsRunning() const { return running; }
-};
 
-int StringToVK(const std::string& key) {
-    // Basic keys
-    if (key == "SPACE") return VK_SPACE;
-    if (key == "ENTER") return VK_RETURN;
-    if (key == "TAB") return VK_TAB;
-    if (key == "ESC" || key == "ESCAPE") return VK_ESCAPE;
-    if (key == "BACKSPACE") return VK_BACK;
-    if (key == "DELETE") return VK_DELETE;
-    if (key == "INSERT") return VK_INSERT;
-    if (key == "HOME") return VK_HOME;
-    if (key == "END") return VK_END;
-    if (key == "PAGEUP") return VK_PRIOR;
-    if (key == "PAGEDOWN") return VK_NEXT;
-    
-    // Function keys
-    if (key == "F1") return VK_F1;
-    if (key == "F2") return VK_F2;
-    if (key == "F3") return VK_F3;
-    if (key == "F4") return VK_F4;
-    if (key == "F5") return VK_F5;
-    if (key == "F6") return VK_F6;
-    if (key == "F7") return VK_F7;
-    if (key == "F8") return VK_F8;
-    if (key == "F9") return VK_F9;
-    if (key == "F10") return VK_F10;
-    if (key == "F11") return VK_F11;
-    if (key == "F12") return VK_F12;
-    
-    // Arrow keys
-    if (key == "LEFT") return VK_LEFT;
-    if (key == "RIGHT") return VK_RIGHT;
-    if (key == "UP") return VK_UP;
-    if (key == "DOWN") return VK_DOWN;
-    
-    // Number pad
-    if (key == "NUM0") return VK_NUMPAD0;
-    if (key == "NUM1") return VK_NUMPAD1;
-    if (key == "NUM2") return VK_NUMPAD2;
-    if (key == "NUM3") return VK_NUMPAD3;
-    if (key == "NUM4") return VK_NUMPAD4;
-    if (key == "NUM5") return VK_NUMPAD5;
-    if (key == "NUM6") return VK_NUMPAD6;
-    if (key == "NUM7") return VK_NUMPAD7;
-    if (key == "NUM8") return VK_NUMPAD8;
-    if (key == "NUM9") return VK_NUMPAD9;
-    
-    // Single character keys
-    if (key.length() == 1) {
-        char c = toupper(key[0]);
-        if (c >= 'A' && c <= 'Z') return c;
-        if (c >= '0' && c <= '9') return c;
+    int len = GetWindowTextLength(statusEdit);
+    int excess = len + static_cast<int>(batch.size()) - STATUS_HISTORY_CHARS;
+    if (excess > 0) {
+        // Cut whole lines from the top
+        int line = (int)SendMessage(statusEdit, EM_LINEFROMCHAR, excess, 0);
+        int cut = (int)SendMessage(statusEdit, EM_LINEINDEX, line + 1, 0);
+        if (cut < 0) cut = len;
+        SendMessage(statusEdit, EM_SETSEL, 0, cut);
+        SendMessage(statusEdit, EM_REPLACESEL, FALSE, (LPARAM)"");
+        len -= cut;
     }
-    
-    return VK_SPACE; // Default fallback
+
+    SendMessage(statusEdit, EM_SETSEL, len, len);
+    SendMessage(statusEdit, EM_REPLACESEL, FALSE, (LPARAM)batch.c_str());
+
+    // Auto-scroll to bottom
+    SendMessage(statusEdit, EM_SCROLL, SB_BOTTOM, 0);
 }
 
 // Global variables
@@ -401,52 +85,6 @@ HWND g_keyEditHwnd = nullptr;
 WNDPROC g_originalKeyEditProc = nullptr;
 DWORD g_lastCaptureTime = 0;
 
-bool IsValidKeyString(const std::string& keyString) {
-    if (keyString.empty()) return false;
-    
-    std::string upper = keyString;
-    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
-    
-    // Remove modifiers to check base key
-    if (upper.find("CTRL+") != std::string::npos) {
-        upper = upper.substr(upper.find("CTRL+") + 5);
-    }
-    if (upper.find("SHIFT+") != std::string::npos) {
-        upper = upper.substr(upper.find("SHIFT+") + 6);
-    }
-    if (upper.find("ALT+") != std::string::npos) {
-        upper = upper.substr(upper.find("ALT+") + 4);
-    }
-    
-    // Check if remaining key is valid
-    return StringToVK(upper) != VK_SPACE || upper == "SPACE";
-}
-
-void ParseKeyString(const std::string& keyString, Config& config) {
-    std::string upper = keyString;
-    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
-    
-    config.useCtrl = false;
-    config.useShift = false;
-    config.useAlt = false;
-    
-    // Check for modifier keys
-    if (upper.find("CTRL+") != std::string::npos) {
-        config.useCtrl = true;
-        upper = upper.substr(upper.find("CTRL+") + 5);
-    }
-    if (upper.find("SHIFT+") != std::string::npos) {
-        config.useShift = true;
-        upper = upper.substr(upper.find("SHIFT+") + 6);
-    }
-    if (upper.find("ALT+") != std::string::npos) {
-        config.useAlt = true;
-        upper = upper.substr(upper.find("ALT+") + 4);
-    }
-    
-    config.triggerKey = StringToVK(upper);
-}
-
 std::string GetWindowText(HWND hwnd) {
     int len = GetWindowTextLength(hwnd);
     std::string result(len + 1, 0);
@@ -498,11 +136,8 @@ void RefreshWindowList(HWND parent) {
     }
 }
 
-void StartListener(HWND hwnd) {
-    if (g_trigger && g_trigger->IsRunning()) return;
-    
-    Config config;
-    
+// Reads the form into config; false (after telling the user) if it's invalid
+bool ReadConfig(HWND hwnd, Config& config) {
     // Get selected window from combo box
     int sel = SendMessage(GetDlgItem(hwnd, ID_WINDOW_COMBO), CB_GETCURSEL, 0, 0);
     if (sel != CB_ERR && sel < g_windows.size()) {
@@ -513,7 +148,6 @@ void StartListener(HWND hwnd) {
     
     config.ipAddress = GetWindowText(GetDlgItem(hwnd, ID_IP_EDIT));
     config.port = GetDlgItemInt(hwnd, ID_PORT_EDIT, nullptr, FALSE);
-    config.targetValue = GetDlgItemInt(hwnd, ID_VALUE_EDIT, nullptr, FALSE);
     config.oscAddress = GetWindowText(GetDlgItem(hwnd, ID_ADDRESS_EDIT));
     config.continuousMode = (SendMessage(GetDlgItem(hwnd, ID_CONTINUOUS_CHECK), BM_GETCHECK, 0, 0) == BST_CHECKED);
     
@@ -524,13 +158,32 @@ void StartListener(HWND hwnd) {
     // Validate key combination
     if (!IsValidKeyString(keyText)) {
         MessageBoxA(hwnd, "Invalid key combination. Please use format like: SPACE, ENTER, F1, A, CTRL+A, SHIFT+F1, etc.", "Invalid Key", MB_OK | MB_ICONERROR);
-        return;
+        return false;
     }
     
     ParseKeyString(keyText, config);
+
+    // Any value the rule syntax takes: negative or fractional numbers,
+    // comparisons, ranges, strings and conditions
+    char valueText[256];
+    GetDlgItemTextA(hwnd, ID_VALUE_EDIT, valueText, sizeof(valueText));
+    std::string error;
+    if (!ParseRuleValue(valueText, config.compareOp, config.targetValue, config.condition, error)) {
+        MessageBoxA(hwnd, ("Invalid target value: " + error + ".\nUse a number like 9, -1 or >=0.5, a range like 0.2..0.8, true, false or a string.").c_str(),
+                    "Invalid Value", MB_OK | MB_ICONERROR);
+        return false;
+    }
+    return true;
+}
+
+void StartListener(HWND hwnd) {
+    if (g_trigger && g_trigger->IsRunning()) return;
+    
+    Config config;
+    if (!ReadConfig(hwnd, config)) return;
     
     if (!g_trigger) {
-        g_trigger = std::make_unique<OSCTrigger>(GetDlgItem(hwnd, ID_STATUS_EDIT));
+        g_trigger = std::make_unique<OSCTrigger>(g_log, std::make_unique<Win32KeySink>());
     }
     
     if (g_trigger->Start(config)) {
@@ -542,9 +195,20 @@ void StartListener(HWND hwnd) {
         
         EnableWindow(GetDlgItem(hwnd, ID_START_BUTTON), FALSE);
         EnableWindow(GetDlgItem(hwnd, ID_STOP_BUTTON), TRUE);
+        EnableWindow(GetDlgItem(hwnd, ID_APPLY_BUTTON), TRUE);
     }
 }
 
+// Swaps in the edited address, value and key while listening; the socket
+// stays bound and no packets are missed. IP and port changes need a restart.
+void ApplyListener(HWND hwnd) {
+    if (!g_trigger || !g_trigger->IsRunning()) return;
+    
+    Config config;
+    if (!ReadConfig(hwnd, config)) return;
+    g_trigger->ApplyRules(config);
+}
+
 void StopListener(HWND hwnd) {
     if (g_trigger) {
         g_trigger->Stop();
@@ -560,6 +224,7 @@ void StopListener(HWND hwnd) {
         
         EnableWindow(GetDlgItem(hwnd, ID_START_BUTTON), TRUE);
         EnableWindow(GetDlgItem(hwnd, ID_STOP_BUTTON), FALSE);
+        EnableWindow(GetDlgItem(hwnd, ID_APPLY_BUTTON), FALSE);
     }
 }
 
@@ -725,6 +390,9 @@ void ResizeControls(HWND hwnd) {
     SetWindowPos(GetDlgItem(hwnd, ID_STOP_BUTTON), nullptr,
                 margin + 80 + spacing, currentY, 80, buttonHeight,
                 SWP_NOZORDER);
+    SetWindowPos(GetDlgItem(hwnd, ID_APPLY_BUTTON), nullptr,
+                margin + (80 + spacing) * 2, currentY, 80, buttonHeight,
+                SWP_NOZORDER);
     
     // Status area
     SetWindowPos(GetDlgItem(hwnd, ID_STATUS_EDIT), nullptr,
@@ -818,7 +486,7 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
             // Target value
             CreateWindowA("STATIC", "Target Value:", WS_VISIBLE | WS_CHILD,
                         10, 155, 100, 20, hwnd, nullptr, nullptr, nullptr);
-            CreateWindowA("EDIT", "9", WS_VISIBLE | WS_CHILD | WS_BORDER | ES_NUMBER,
+            CreateWindowA("EDIT", "9", WS_VISIBLE | WS_CHILD | WS_BORDER | ES_AUTOHSCROLL,
                         120, 155, 100, 20, hwnd, (HMENU)ID_VALUE_EDIT, nullptr, nullptr);
             
             // OSC address
@@ -836,6 +504,8 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
                         10, 245, 80, 30, hwnd, (HMENU)ID_START_BUTTON, nullptr, nullptr);
             CreateWindowA("BUTTON", "STOP", WS_VISIBLE | WS_CHILD | BS_PUSHBUTTON,
                         100, 245, 80, 30, hwnd, (HMENU)ID_STOP_BUTTON, nullptr, nullptr);
+            CreateWindowA("BUTTON", "APPLY", WS_VISIBLE | WS_CHILD | BS_PUSHBUTTON,
+                        190, 245, 80, 30, hwnd, (HMENU)ID_APPLY_BUTTON, nullptr, nullptr);
             
             // Status
             CreateWindowA("STATIC", "Status:", WS_VISIBLE | WS_CHILD,
@@ -844,12 +514,21 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
                         10, 305, 420, 150, hwnd, (HMENU)ID_STATUS_EDIT, nullptr, nullptr);
             
             EnableWindow(GetDlgItem(hwnd, ID_STOP_BUTTON), FALSE);
+            EnableWindow(GetDlgItem(hwnd, ID_APPLY_BUTTON), FALSE);
             
             // Initialize window list
             RefreshWindowList(hwnd);
             
             // Initial layout
             ResizeControls(hwnd);
+
+            SetTimer(hwnd, ID_LOG_TIMER, LOG_DRAIN_MS, nullptr);
+        }
+        break;
+
+    case WM_TIMER:
+        if (wParam == ID_LOG_TIMER) {
+            DrainStatusLog(GetDlgItem(hwnd, ID_STATUS_EDIT));
         }
         break;
         
@@ -870,6 +549,8 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
     case WM_COMMAND:
         if (LOWORD(wParam) == ID_START_BUTTON) {
             StartListener(hwnd);
+        } else if (LOWORD(wParam) == ID_APPLY_BUTTON) {
+            ApplyListener(hwnd);
         } else if (LOWORD(wParam) == ID_STOP_BUTTON) {
             StopListener(hwnd);
         } else if (LOWORD(wParam) == ID_WINDOW_SELECT) {
@@ -895,6 +576,7 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
         break;
         
     case WM_DESTROY:
+        KillTimer(hwnd, ID_LOG_TIMER);
         PostQuitMessage(0);
         break;
         
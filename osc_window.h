@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Opaque top-level window handle; an HWND on Windows. 0 means none.
+using WindowHandle = uintptr_t;
+
+// Where window handles come from. Find() is the expensive full lookup;
+// IsValid() and HasTitle() are the cheap checks used to revalidate a
+// cached handle.
+class WindowRegistry {
+public:
+    virtual ~WindowRegistry() {}
+    virtual WindowHandle Find(const std::string& title) = 0;
+    virtual bool IsValid(WindowHandle window) = 0;
+    virtual bool HasTitle(WindowHandle window, const std::string& title) = 0;
+};
+
+#ifdef _WIN32
+class Win32WindowRegistry : public WindowRegistry {
+public:
+    WindowHandle Find(const std::string& title) override {
+        return reinterpret_cast<WindowHandle>(FindWindowA(nullptr, title.c_str()));
+    }
+
+    bool IsValid(WindowHandle window) override {
+        return IsWindow(reinterpret_cast<HWND>(window)) != FALSE;
+    }
+
+    bool HasTitle(WindowHandle window, const std::string& title) override {
+        char text[512];
+        int length = GetWindowTextA(reinterpret_cast<HWND>(window), text, sizeof(text));
+        return title.compare(0, std::string::npos, text, length) == 0;
+    }
+};
+#endif
+
+// In-memory window list for exercising the resolver without a desktop.
+// Find() scans the list in z-order like FindWindowA; IsValid() and
+// HasTitle() are keyed lookups, like IsWindow and GetWindowText.
+class FakeWindowRegistry : public WindowRegistry {
+private:
+    std::vector<WindowHandle> order;
+    std::unordered_map<WindowHandle, std::string> titles;
+    WindowHandle nextHandle = 0x100;
+
+public:
+    uint64_t findCalls = 0;
+
+    WindowHandle Open(const std::string& title) {
+        WindowHandle window = nextHandle++;
+        order.push_back(window);
+        titles[window] = title;
+        return window;
+    }
+
+    void Close(WindowHandle window) {
+        titles.erase(window);
+        for (size_t i = 0; i < order.size(); i++) {
+            if (order[i] == window) {
+                order.erase(order.begin() + i);
+                return;
+            }
+        }
+    }
+
+    void Rename(WindowHandle window, const std::string& title) {
+        auto it = titles.find(window);
+        if (it != titles.end()) it->second = title;
+    }
+
+    WindowHandle Find(const std::string& title) override {
+        findCalls++;
+        for (WindowHandle window : order) {
+            if (titles[window] == title) return window;
+        }
+        return 0;
+    }
+
+    bool IsValid(WindowHandle window) override { return titles.count(window) != 0; }
+
+    bool HasTitle(WindowHandle window, const std::string& title) override {
+        auto it = titles.find(window);
+        return it != titles.end() && it->second == title;
+    }
+};
+
+// Remembers the handle each title last resolved to. A cached handle is
+// reused while it still exists and still carries that title; otherwise the
+// title is looked up again. Misses are not cached, so a window that opens
+// later is picked up on the next trigger. Used from one thread only.
+class CachedWindowResolver {
+private:
+    WindowRegistry& registry;
+    std::unordered_map<std::string, WindowHandle> cache;
+    uint64_t hits = 0;
+    uint64_t lookups = 0;
+
+public:
+    explicit CachedWindowResolver(WindowRegistry& windows) : registry(windows) {}
+
+    WindowHandle Resolve(const std::string& title) {
+        auto it = cache.find(title);
+        if (it != cache.end()) {
+            if (registry.IsValid(it->second) && registry.HasTitle(it->second, title)) {
+                hits++;
+                return it->second;
+            }
+            cache.erase(it);
+        }
+
+        lookups++;
+        WindowHandle window = registry.Find(title);
+        if (window) cache.emplace(title, window);
+        return window;
+    }
+
+    void Clear() { cache.clear(); }
+
+    uint64_t Hits() const { return hits; }
+    uint64_t Lookups() const { return lookups; }
+};